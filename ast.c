@@ -0,0 +1,295 @@
+/*
+ * ast.c - builds a tree for a <bexpr> in an arena and evaluates it. The
+ * parse functions follow the grammar in parser.c one for one. Since the
+ * nodes of a tree are stored children first, ast_eval() is one loop over
+ * an array rather than a walk over pointers.
+ * Date:   2025 April 26
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include "ast.h"
+#include "ipow.h"
+
+static int p_expr(struct parser_state *, struct ast_arena *);
+
+/**
+ * Bumps a new node off the arena, growing it as needed.
+ * @param arena: the arena to allocate from
+ * @param kind: INT_LITERAL or an operator's token kind
+ * @param left: the left child, or the value of an INT_LITERAL
+ * @param right: the right child
+ * @param offset: byte offset of the node's token in the input, for errors
+ * @return: the index of the node, or ERROR if out of memory
+ */
+int ast_new_node(struct ast_arena *arena, int kind, int left, int right, size_t offset) {
+   if (arena->count == arena->capacity) {
+      int capacity = arena->capacity ? arena->capacity * 2 : 256;
+      struct ast_node *nodes = realloc(arena->nodes, capacity * sizeof(struct ast_node));
+      int *values;
+      size_t *offsets;
+      if (nodes == NULL)
+         return ERROR;
+      arena->nodes = nodes;
+      values = realloc(arena->values, capacity * sizeof(int));
+      if (values == NULL)
+         return ERROR;
+      arena->values = values;
+      offsets = realloc(arena->offsets, capacity * sizeof(size_t));
+      if (offsets == NULL)
+         return ERROR;
+      arena->offsets = offsets;
+      arena->capacity = capacity;
+   }
+   arena->nodes[arena->count].kind = kind;
+   arena->nodes[arena->count].left = left;
+   arena->nodes[arena->count].right = right;
+   arena->offsets[arena->count] = offset;
+   return arena->count++;
+}
+
+/**
+ * <expp> -> ( <expr> ) | <num>
+ */
+static int p_expp(struct parser_state *ps, struct ast_arena *arena) {
+   int node;
+
+   if (ps->lex.kind == LEFT_PAREN) {
+      next_token(ps); // Consume the left parenthesis
+      if ((node = p_expr(ps, arena)) == ERROR)
+         return ERROR;
+      if (ps->lex.kind != RIGHT_PAREN) {
+         ps->is_right_paren_error = true;
+         parse_error(ps, PARSE_SYNTAX_ERROR, token_offset(ps), "Syntax Error: ')' expected");
+         return ERROR;
+      }
+      next_token(ps); // Consume the right parenthesis
+      return node;
+   }
+   if (ps->lex.kind != INT_LITERAL) {
+      parse_error(ps, PARSE_SYNTAX_ERROR, token_offset(ps), "Syntax Error: Expected a number");
+      return ERROR;
+   }
+   node = ast_new_node(arena, INT_LITERAL, token_int(ps), 0, token_offset(ps));
+   next_token(ps);
+   return node;
+}
+
+/**
+ * <factor> -> <expp> ^ <factor> | <expp>
+ */
+static int p_factor(struct parser_state *ps, struct ast_arena *arena) {
+   int left = p_expp(ps, arena), right;
+   size_t offset;
+
+   if (left == ERROR || ps->lex.kind != EXPON_OP)
+      return left;
+   offset = token_offset(ps);
+   next_token(ps);
+   if ((right = p_factor(ps, arena)) == ERROR)
+      return ERROR;
+   return ast_new_node(arena, EXPON_OP, left, right, offset);
+}
+
+/**
+ * <stmt> -> <factor> <ftail>
+ * <ftail> -> <compare_tok> <factor> <ftail> | e
+ */
+static int p_stmt(struct parser_state *ps, struct ast_arena *arena) {
+   int left = p_factor(ps, arena), right;
+   size_t offset;
+
+   while (left != ERROR) {
+      enum token_kind op = ps->lex.kind;
+      switch (op) {
+         case LESS_THAN_OP:
+         case GREATER_THAN_OP:
+         case LESS_THAN_OR_EQUAL_OP:
+         case GREATER_THAN_OR_EQUAL_OP:
+         case NOT_EQUALS_OP:
+         case EQUALS_OP:
+            offset = token_offset(ps);
+            next_token(ps);
+            if ((right = p_factor(ps, arena)) == ERROR)
+               return ERROR;
+            left = ast_new_node(arena, op, left, right, offset);
+            break;
+         default:
+            return left;
+      }
+   }
+   return ERROR;
+}
+
+/**
+ * <term> -> <stmt> <stail>
+ * <stail> -> <mult_div_tok> <stmt> <stail> | e
+ */
+static int p_term(struct parser_state *ps, struct ast_arena *arena) {
+   int left = p_stmt(ps, arena), right;
+   size_t offset;
+
+   while (left != ERROR && (ps->lex.kind == MULT_OP || ps->lex.kind == DIV_OP)) {
+      enum token_kind op = ps->lex.kind;
+      offset = token_offset(ps);
+      next_token(ps);
+      if ((right = p_stmt(ps, arena)) == ERROR)
+         return ERROR;
+      left = ast_new_node(arena, op, left, right, offset);
+   }
+   return left;
+}
+
+/**
+ * <expr> -> <term> <ttail>
+ * <ttail> -> <add_sub_tok> <term> <ttail> | e
+ */
+static int p_expr(struct parser_state *ps, struct ast_arena *arena) {
+   int left = p_term(ps, arena), right;
+   size_t offset;
+
+   while (left != ERROR && (ps->lex.kind == ADD_OP || ps->lex.kind == SUB_OP)) {
+      enum token_kind op = ps->lex.kind;
+      offset = token_offset(ps);
+      next_token(ps);
+      if ((right = p_term(ps, arena)) == ERROR)
+         return ERROR;
+      left = ast_new_node(arena, op, left, right, offset);
+   }
+   return left;
+}
+
+/**
+ * Sets up an empty arena.
+ * @param arena: the arena to initialize
+ */
+void ast_arena_init(struct ast_arena *arena) {
+   memset(arena, 0, sizeof(*arena));
+}
+
+/**
+ * Drops every tree in the arena, keeping its memory for reuse.
+ * @param arena: the arena to reset
+ */
+void ast_arena_reset(struct ast_arena *arena) {
+   arena->count = 0;
+}
+
+/**
+ * Frees the memory held by an arena.
+ * @param arena: the arena to free
+ */
+void ast_arena_free(struct ast_arena *arena) {
+   free(arena->nodes);
+   free(arena->values);
+   free(arena->offsets);
+   ast_arena_init(arena);
+}
+
+/**
+ * <bexpr> -> <expr> ;
+ * Parses the next <bexpr> into a tree in the arena. Errors are reported
+ * and recovered from as bexpr() does.
+ * @param ps: the parser state, positioned at the start of a <bexpr>
+ * @param arena: where to put the nodes
+ * @param tree: set to the first node and root of the tree
+ * @return: true if the tree can be evaluated; see ps->status
+ */
+bool ast_parse(struct parser_state *ps, struct ast_arena *arena, struct ast *tree) {
+   ps->is_right_paren_error = false;
+   ps->status = PARSE_OK;
+   tree->first = arena->count;
+
+   // A syntax error has been reported by now, so what is left is memory
+   if ((tree->root = p_expr(ps, arena)) == ERROR && ps->status == PARSE_OK)
+      parse_error(ps, PARSE_OUT_OF_MEMORY, token_offset(ps), "ERROR: out of memory");
+   return bexpr_finish(ps, 0).status == PARSE_OK;
+}
+
+/**
+ * Evaluates a tree. Every node's children come before it, so one pass
+ * from the first node to the root computes each value from values that
+ * are already known. An error is reported through ps, as bexpr()
+ * reports it, at the offset of its operator in the parsed statement.
+ * @param arena: the arena holding the tree
+ * @param tree: the tree to evaluate
+ * @param ps: where errors go; its status is set to that of the evaluation
+ * @return: PARSE_OK and the value of the tree, or why '/' or '^' failed
+ */
+struct eval_result ast_eval(struct ast_arena *arena, const struct ast *tree,
+                            struct parser_state *ps) {
+   const struct ast_node *n = arena->nodes;
+   int *v = arena->values, i;
+   struct eval_result result = { PARSE_OK, 0 };
+
+   ps->status = PARSE_OK;
+   for (i = tree->first; i <= tree->root; i++) {
+      if (n[i].kind == INT_LITERAL)
+         v[i] = n[i].left;
+      else if (!ast_apply(n[i].kind, v[n[i].left], v[n[i].right], &v[i])) {
+         size_t offset = arena->offsets[i];
+         if (n[i].kind == EXPON_OP)
+            parse_error(ps, PARSE_OVERFLOW, offset, "Overflow Error: '^' result out of range");
+         else if (v[n[i].right] == 0)
+            parse_error(ps, PARSE_DIVIDE_BY_ZERO, offset, "Math Error: division by zero");
+         else
+            parse_error(ps, PARSE_OVERFLOW, offset, "Overflow Error: '/' result out of range");
+         result.status = ps->status;
+         return result;
+      }
+   }
+   result.value = v[tree->root];
+   return result;
+}
+
+/**
+ * Applies a binary operator to two values.
+ * @param kind: the operator's token kind
+ * @param a: the left operand
+ * @param b: the right operand
+ * @param result: set to the result
+ * @return: false if '/' divides by zero or INT_MIN by -1, or '^' overflows
+ */
+bool ast_apply(int kind, int a, int b, int *result) {
+   switch (kind) {
+      case ADD_OP: *result = a + b; break;
+      case SUB_OP: *result = a - b; break;
+      case MULT_OP: *result = a * b; break;
+      case DIV_OP:
+         if (b == 0 || (b == -1 && a == INT_MIN))
+            return false;
+         *result = a / b;
+         break;
+      case EXPON_OP: return ipow(a, b, result);
+      default: *result = compare_values(kind, a, b); break;
+   }
+   return true;
+}
+
+/**
+ * Writes a tree as a fully parenthesized expression.
+ * @param out: where to write
+ * @param arena: the arena holding the tree
+ * @param node: the root of the (sub)tree to write
+ */
+void ast_print(FILE *out, const struct ast_arena *arena, int node) {
+   static const char *const symbols[TOKEN_KIND_COUNT] = {
+      [ADD_OP] = "+", [SUB_OP] = "-", [MULT_OP] = "*", [DIV_OP] = "/",
+      [EXPON_OP] = "^", [LESS_THAN_OP] = "<", [GREATER_THAN_OP] = ">",
+      [LESS_THAN_OR_EQUAL_OP] = "<=", [GREATER_THAN_OR_EQUAL_OP] = ">=",
+      [EQUALS_OP] = "==", [NOT_EQUALS_OP] = "!="
+   };
+   const struct ast_node *n = &arena->nodes[node];
+
+   if (n->kind == INT_LITERAL) {
+      fprintf(out, "%d", n->left);
+      return;
+   }
+   fputc('(', out);
+   ast_print(out, arena, n->left);
+   fprintf(out, " %s ", symbols[n->kind]);
+   ast_print(out, arena, n->right);
+   fputc(')', out);
+}
@@ -0,0 +1,49 @@
+#ifndef AST_H
+#define AST_H
+/*
+ * Purpose: Parse a <bexpr> once into a tree, then evaluate or print it
+ *          as often as needed.
+ * Date:    2025 April 26
+ */
+#include <stdio.h>
+#include "parser.h"
+
+/*
+ * One tree node. Children are indices into the arena, not pointers, and
+ * always come before their parent, so a tree is a contiguous post-order
+ * run of nodes ending at its root.
+ */
+struct ast_node {
+   int kind;      // INT_LITERAL or the operator's token kind
+   int left;      // left child, or the value of an INT_LITERAL
+   int right;     // right child, unused for INT_LITERAL
+};
+
+/*
+ * Bump allocator for nodes. ast_arena_reset() drops every tree at once
+ * and keeps the memory for the next batch; nodes are never freed one by
+ * one.
+ */
+struct ast_arena {
+   struct ast_node *nodes;
+   int *values;      // scratch space ast_eval() uses, one slot per node
+   size_t *offsets;  // where each node's token is in the input, for errors
+   int count;        // nodes in use
+   int capacity;     // nodes allocated
+};
+
+struct ast {
+   int first;     // first node of the tree
+   int root;      // root of the tree, which is also its last node
+};
+
+void ast_arena_init(struct ast_arena *);
+void ast_arena_reset(struct ast_arena *);
+void ast_arena_free(struct ast_arena *);
+int ast_new_node(struct ast_arena *, int, int, int, size_t);
+bool ast_parse(struct parser_state *, struct ast_arena *, struct ast *);
+struct eval_result ast_eval(struct ast_arena *, const struct ast *, struct parser_state *);
+bool ast_apply(int, int, int, int *);
+void ast_print(FILE *, const struct ast_arena *, int);
+
+#endif
@@ -0,0 +1,204 @@
+/*
+ * bench_ast.c - compares parse throughput and memory of building trees in
+ * an arena against the evaluate-while-parse path, and how fast a parsed
+ * tree evaluates again before and after ast_fold().
+ *
+ * Build: make bench_ast
+ * Usage: bench_ast [statements] [repeats]
+ * Date:  2025 April 26
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "optimize.h"
+#include "corpus.h"
+#include "parallel.h"
+
+/*
+ * Statements that fail, some only once a rewrite does not hide the
+ * failure, and some that fail to parse. Each must fail as it does in
+ * bexpr(), at the same offset, and leave the parser at the same place.
+ */
+static const char *const failing[] = {
+   "1 / 0;", "(0 - 2147483647 - 1) / (0 - 1);", "(1 / 0) ^ 0;", "(2 ^ 40) ^ 0;",
+   "(2 ^ 40) * 0;", "0 * (1 / 0) + 1;", "(1 < 2) * 0 + 7 / (3 - 3);", "2 ^ 40 ^ 0 + 0;",
+   "(1 + 2; 1;", "1 + ; 1;", "3 4; 1;"
+};
+
+/**
+ * Evaluates a tree, with its errors going to a log of their own.
+ * @param offset: set to the offset of the error, or 0 if there is none
+ */
+static struct eval_result eval_logged(struct ast_arena *arena, const struct ast *tree,
+                                      struct parser_state *ps, size_t *offset) {
+   struct error_log log;
+   struct eval_result result;
+
+   error_log_init(&log);
+   ps->errors = &log;
+   result = ast_eval(arena, tree, ps);
+   *offset = log.count ? log.errors[0].offset : 0;
+   ps->errors = NULL;
+   error_log_free(&log);
+   return result;
+}
+
+/**
+ * Parses, folds and evaluates the first of the statements, then
+ * evaluates it with bexpr(), with the errors of each going to a log of
+ * their own.
+ * @return: whether the tree, the folded tree and bexpr() agree on the
+ *          status, the value, the offset of the error and where the next
+ *          statement starts
+ */
+static bool same_as_bexpr(struct ast_arena *arena, const char *statements) {
+   struct parser_state ps;
+   struct error_log log, expected_log;
+   struct eval_result result = { PARSE_OK, 0 }, folded_result, expected;
+   struct ast tree, fold_tree;
+   size_t offset = 0, folded_offset, next;
+   char text[64];
+   bool same;
+
+   snprintf(text, sizeof(text), "%s", statements);
+   error_log_init(&log);
+   parser_init(&ps, text);
+   ps.errors = &log;
+   if (!ast_parse(&ps, arena, &tree)) {
+      result.status = ps.status;
+      offset = log.count ? log.errors[0].offset : 0;
+      folded_result = result;
+      folded_offset = offset;
+   } else if (ast_fold(arena, &tree, &fold_tree) == ERROR) {
+      error_log_free(&log);
+      return false;
+   } else {
+      result = eval_logged(arena, &tree, &ps, &offset);
+      folded_result = eval_logged(arena, &fold_tree, &ps, &folded_offset);
+   }
+   next = token_offset(&ps);
+   error_log_free(&log);
+
+   error_log_init(&expected_log);
+   parser_init(&ps, text);
+   ps.errors = &expected_log;
+   expected = bexpr(&ps);
+   same = result.status == expected.status && result.value == expected.value
+          && folded_result.status == expected.status && folded_result.value == expected.value
+          && next == token_offset(&ps)
+          && offset == (expected_log.count ? expected_log.errors[0].offset : 0)
+          && folded_offset == offset;
+   error_log_free(&expected_log);
+   return same;
+}
+
+static double now(void) {
+   struct timespec ts;
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+int main(int argc, char *argv[]) {
+   int count = argc > 1 ? atoi(argv[1]) : 100000;
+   int repeats = argc > 2 ? atoi(argv[2]) : 20;
+   struct statement_batch batch;
+   struct parser_state ps;
+   struct ast_arena arena;
+   struct ast *trees, *folded;
+   char *input;
+   size_t length, arena_bytes;
+   double start, direct, parse, eval, fold, folded_eval;
+   long eliminated = 0;
+   volatile int sink;
+   int i, r, mismatches = 0;
+
+   srand(352);
+   input = gen_corpus(count, &length);
+   if (input == NULL || batch_split(&batch, input, length) < 0
+       || (trees = malloc(batch.count * sizeof(struct ast))) == NULL
+       || (folded = malloc(batch.count * sizeof(struct ast))) == NULL) {
+      fprintf(stderr, "ERROR: out of memory\n");
+      return 1;
+   }
+   ast_arena_init(&arena);
+
+   start = now();
+   for (i = 0; i < batch.count; i++) {
+      parser_init(&ps, batch.stmts[i]);
+      sink = bexpr(&ps).value;
+   }
+   direct = now() - start;
+
+   // warm the arena so the timed pass measures parsing, not realloc
+   for (i = 0; i < batch.count; i++) {
+      parser_init(&ps, batch.stmts[i]);
+      ast_parse(&ps, &arena, &trees[i]);
+   }
+   ast_arena_reset(&arena);
+
+   start = now();
+   for (i = 0; i < batch.count; i++) {
+      parser_init(&ps, batch.stmts[i]);
+      ast_parse(&ps, &arena, &trees[i]);
+   }
+   parse = now() - start;
+   arena_bytes = (size_t) arena.count * (sizeof(struct ast_node) + sizeof(int) + sizeof(size_t));
+
+   start = now();
+   for (r = 0; r < repeats; r++) {
+      for (i = 0; i < batch.count; i++)
+         sink = ast_eval(&arena, &trees[i], &ps).value;
+   }
+   eval = now() - start;
+
+   start = now();
+   for (i = 0; i < batch.count; i++)
+      eliminated += ast_fold(&arena, &trees[i], &folded[i]);
+   fold = now() - start;
+
+   start = now();
+   for (r = 0; r < repeats; r++) {
+      for (i = 0; i < batch.count; i++)
+         sink = ast_eval(&arena, &folded[i], &ps).value;
+   }
+   folded_eval = now() - start;
+
+   for (i = 0; i < batch.count; i++) {
+      struct eval_result tree_result = ast_eval(&arena, &trees[i], &ps);
+      struct eval_result folded_result = ast_eval(&arena, &folded[i], &ps);
+      struct eval_result result;
+
+      parser_init(&ps, batch.stmts[i]);
+      result = bexpr(&ps);
+      if (tree_result.status != result.status || tree_result.value != result.value)
+         mismatches++;
+      if (folded_result.status != result.status || folded_result.value != result.value)
+         mismatches++;
+   }
+
+   // The corpus never fails, so check the failures on their own
+   for (i = 0; i < (int) (sizeof(failing) / sizeof(failing[0])); i++) {
+      if (!same_as_bexpr(&arena, failing[i]))
+         mismatches++;
+   }
+
+   printf("%d statements, %.1f MB of source\n", batch.count, length / 1e6);
+   printf("evaluate while parsing  %12.0f stmts/sec, no heap\n", batch.count / direct);
+   printf("parse to tree           %12.0f stmts/sec\n", batch.count / parse);
+   printf("evaluate tree           %12.0f evals/sec\n", (double) batch.count * repeats / eval);
+   printf("fold tree               %12.0f stmts/sec, %ld nodes eliminated (%.1f/stmt)\n",
+          batch.count / fold, eliminated, (double) eliminated / batch.count);
+   printf("evaluate folded tree    %12.0f evals/sec\n", (double) batch.count * repeats / folded_eval);
+   printf("arena: %zu bytes/node, %.1f MB (%.1f bytes/stmt) before folding, %d mismatches\n",
+          sizeof(struct ast_node) + sizeof(int) + sizeof(size_t), arena_bytes / 1e6,
+          (double) arena_bytes / batch.count, mismatches);
+
+   (void) sink;
+   ast_arena_free(&arena);
+   free(trees);
+   free(folded);
+   batch_free(&batch);
+   free(input);
+   return mismatches != 0;
+}
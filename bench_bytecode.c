@@ -0,0 +1,145 @@
+/*
+ * bench_bytecode.c - compares evaluations/sec of the recursive evaluator,
+ * which lexes and parses the statement on every evaluation, against
+ * running bytecode compiled once.
+ *
+ * Build: make bench_bytecode
+ * Usage: bench_bytecode [statements] [repeats]
+ * Date:  2025 April 25
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "bytecode.h"
+#include "corpus.h"
+#include "parallel.h"
+
+/*
+ * Statements that fail to compile or fail when run, each followed by one
+ * that does not; each must fail as it does in bexpr(), at the same offset,
+ * and leave the parser at the same place.
+ */
+static const char *const failing[] = {
+   "1 / 0; 1;", "(0 - 2147483647 - 1) / (0 - 1); 1;", "7 / (3 - 3) + 1; 1;",
+   "2 ^ 40; 1;", "1 < 2 / (2 - 2); 1;", "(0 - 2147483647 - 1) / (0 - 1) * 0; 1;",
+   "(1 + 2; 1;", "1 + ; 1;", "3 4; 1;", "2 * (3 ^ 4)) 5; 1;"
+};
+
+/**
+ * Compiles and runs the first of the statements, then evaluates it with
+ * bexpr(), with the errors of each going to a log of their own.
+ * @return: whether the two agree on the status, the value, the offset of
+ *          the error and where the next statement starts
+ */
+static bool same_as_bexpr(const char *statements) {
+   struct parser_state ps;
+   struct program prog;
+   struct error_log log, expected_log;
+   struct eval_result result = { PARSE_OK, 0 }, expected;
+   size_t next;
+   char text[64];
+   bool same;
+
+   snprintf(text, sizeof(text), "%s", statements);
+   program_init(&prog);
+   error_log_init(&log);
+   parser_init(&ps, text);
+   ps.errors = &log;
+   if (compile(&ps, &prog))
+      result = run(&prog, &ps);
+   else
+      result.status = ps.status;
+   next = token_offset(&ps);
+   program_free(&prog);
+
+   error_log_init(&expected_log);
+   parser_init(&ps, text);
+   ps.errors = &expected_log;
+   expected = bexpr(&ps);
+   same = result.status == expected.status && result.value == expected.value
+          && next == token_offset(&ps) && log.count == expected_log.count
+          && (log.count == 0 || log.errors[0].offset == expected_log.errors[0].offset);
+   error_log_free(&log);
+   error_log_free(&expected_log);
+   return same;
+}
+
+static double now(void) {
+   struct timespec ts;
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+int main(int argc, char *argv[]) {
+   int count = argc > 1 ? atoi(argv[1]) : 100000;
+   int repeats = argc > 2 ? atoi(argv[2]) : 20;
+   struct statement_batch batch;
+   struct parser_state ps;
+   struct program *progs;
+   char *input;
+   size_t length;
+   double start, recursive, compiled, compile_secs;
+   volatile int sink;
+   int i, r, mismatches = 0;
+
+   srand(352);
+   input = gen_corpus(count, &length);
+   if (input == NULL || batch_split(&batch, input, length) < 0
+       || (progs = calloc(batch.count, sizeof(struct program))) == NULL) {
+      fprintf(stderr, "ERROR: out of memory\n");
+      return 1;
+   }
+
+   start = now();
+   for (r = 0; r < repeats; r++) {
+      for (i = 0; i < batch.count; i++) {
+         parser_init(&ps, batch.stmts[i]);
+         sink = bexpr(&ps).value;
+      }
+   }
+   recursive = now() - start;
+
+   start = now();
+   for (i = 0; i < batch.count; i++) {
+      parser_init(&ps, batch.stmts[i]);
+      compile(&ps, &progs[i]);
+   }
+   compile_secs = now() - start;
+
+   start = now();
+   for (r = 0; r < repeats; r++) {
+      for (i = 0; i < batch.count; i++)
+         sink = run(&progs[i], &ps).value;
+   }
+   compiled = now() - start;
+
+   for (i = 0; i < batch.count; i++) {
+      struct eval_result result, expected;
+
+      result = run(&progs[i], &ps);
+      parser_init(&ps, batch.stmts[i]);
+      expected = bexpr(&ps);
+      if (result.status != expected.status || result.value != expected.value)
+         mismatches++;
+      program_free(&progs[i]);
+   }
+
+   // The corpus never fails, so check the errors on their own
+   for (i = 0; i < (int) (sizeof(failing) / sizeof(failing[0])); i++) {
+      if (!same_as_bexpr(failing[i]))
+         mismatches++;
+   }
+
+   printf("%d statements x %d repeats\n", batch.count, repeats);
+   printf("recursive evaluator  %12.0f evals/sec\n", (double) batch.count * repeats / recursive);
+   printf("bytecode (run only)  %12.0f evals/sec\n", (double) batch.count * repeats / compiled);
+   printf("compile              %12.0f stmts/sec\n", batch.count / compile_secs);
+   printf("speedup %.1fx, %d mismatches\n", recursive / compiled, mismatches);
+
+   (void) sink;
+   free(progs);
+   batch_free(&batch);
+   free(input);
+   return mismatches != 0;
+}
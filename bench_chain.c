@@ -0,0 +1,262 @@
+/*
+ * bench_chain.c - checks and times chain_bexpr(). It builds statements
+ * hundreds of kilobytes long: flat sums, products and quotients, and
+ * sums of random parenthesized expressions, some with an error such as
+ * a division by zero or an unbalanced parenthesis far into the chain.
+ * Each is evaluated with bexpr() and with chain_bexpr() on pools of
+ * several sizes, comparing the results, where the parser ends up and
+ * the errors logged. Then it times both on one long statement of each
+ * kind.
+ *
+ * Build: make bench_chain
+ * Usage: bench_chain [megabytes] [threads] [repeats]
+ * Date:  2025 May 13
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "chain.h"
+
+#define SLACK 65536   // more than gen_chain() writes past the size asked for
+
+enum shape { SUM, PRODUCT, NESTED, SHAPES };
+
+static const char *names[SHAPES] = { "sum", "product", "nested" };
+
+static const char *operators[] = {
+   "+", "-", "*", "/", "^", "<", ">", "<=", ">=", "==", "!="
+};
+
+static double now(void) {
+   struct timespec ts;
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// A literal that is never 0, but sometimes large enough to wrap
+static char *gen_literal(char *out) {
+   switch (rand() % 6) {
+      case 0: return out + sprintf(out, "2147483647");
+      case 1: return out + sprintf(out, "%d", rand());
+      default: return out + sprintf(out, "%d", 1 + rand() % 20);
+   }
+}
+
+// An expression of up to 5 operands with any operators, nested to depth
+static char *gen_random(char *out, int depth) {
+   int terms = 1 + rand() % 5, t;
+
+   for (t = 0; t < terms; t++) {
+      if (t > 0)
+         out += sprintf(out, " %s ", operators[rand() % 11]);
+      if (depth > 0 && rand() % 3 == 0) {
+         *out++ = '(';
+         out = gen_random(out, depth - 1);
+         *out++ = ')';
+      } else {
+         out = gen_literal(out);
+      }
+   }
+   return out;
+}
+
+/**
+ * Writes a parenthesized random expression that can follow op without an
+ * error, so the chain is valid unless an error is put in on purpose.
+ */
+static char *gen_operand(char *out, char op) {
+   struct parser_state ps;
+   struct error_log log;
+   struct eval_result result;
+   char *end;
+
+   for (;;) {
+      *out = '(';
+      end = gen_random(out + 1, 3);
+      strcpy(end, ");");
+      error_log_init(&log);
+      parser_init(&ps, out);
+      ps.errors = &log;
+      result = bexpr(&ps);
+      error_log_free(&log);
+      if (result.status == PARSE_OK
+          && (op != '/' || (result.value != 0 && result.value != -1)))
+         return end + 1;
+   }
+}
+
+/**
+ * Writes one statement of about size bytes, the operands of its chain
+ * joined by + and - for a SUM, mostly * and / for a PRODUCT, and by any
+ * of + - * / for a NESTED chain of parenthesized random expressions.
+ */
+static char *gen_chain(char *out, enum shape shape, size_t size) {
+   char *start = out;
+
+   out = gen_literal(out);
+   while ((size_t) (out - start) < size) {
+      switch (shape) {
+         case SUM:
+            out += sprintf(out, " %c ", "+-"[rand() % 2]);
+            out = gen_literal(out);
+            break;
+         case PRODUCT:
+            // Small divisors, and a sum now and then, keep it from reaching 0
+            if (rand() % 16 == 0)
+               out += sprintf(out, " + %d", rand());
+            else if (rand() % 2 == 0)
+               out += sprintf(out, " * %d", 1 + rand() % 7);
+            else
+               out += sprintf(out, " / %d", 1 + rand() % 3);
+            break;
+         default:
+            out += sprintf(out, " %c ", "+-*/"[rand() % 4]);
+            out = gen_operand(out, out[-2]);
+      }
+   }
+   return out;
+}
+
+/**
+ * Writes statements of every shape, some with an error: a division by
+ * zero, an INT_MIN / -1, a parenthesis too many or too few, or a stray
+ * byte. Short statements between them check that the parser is left
+ * where bexpr() would leave it.
+ */
+static char *gen_checks(size_t size, int rounds) {
+   char *input = malloc((size_t) rounds * SHAPES * 2 * (size + SLACK) + 1), *out = input;
+   int r, s;
+
+   if (input == NULL)
+      return NULL;
+   for (r = 0; r < rounds; r++) {
+      for (s = 0; s < SHAPES; s++) {
+         out = gen_chain(out, s, size);
+         switch (rand() % 6) {
+            case 0: out += sprintf(out, " / (3 - 3) + 1"); break;
+            case 1: out += sprintf(out, " + (0 - 2147483647 - 1) / (0 - 1)"); break;
+            case 2: out += sprintf(out, " + (1))"); break;
+            case 3: out += sprintf(out, " * (1 + (2)"); break;
+            case 4: out[-(long) (rand() % size)] = "()+x"[rand() % 4]; break;
+            default: break;
+         }
+         out += sprintf(out, ";\n1 + 2;\n");
+         out = gen_chain(out, s, size);
+         out += sprintf(out, ";\n");
+      }
+   }
+   *out = '\0';
+   return input;
+}
+
+/**
+ * Evaluates every statement of the input with bexpr() and again with
+ * chain_bexpr(), and counts the differences.
+ */
+static int check(char *input, struct task_pool *pool) {
+   struct parser_state serial, parallel;
+   struct error_log serial_log, parallel_log;
+   struct eval_result a, b;
+   int i, mismatches = 0;
+   size_t e;
+
+   error_log_init(&serial_log);
+   error_log_init(&parallel_log);
+   parser_init(&serial, input);
+   parser_init(&parallel, input);
+   serial.errors = &serial_log;
+   parallel.errors = &parallel_log;
+   for (i = 0; serial.lex.kind != END_OF_INPUT; i++) {
+      a = bexpr(&serial);
+      b = chain_bexpr(pool, &parallel);
+      if (a.status != b.status || a.value != b.value
+          || token_offset(&serial) != token_offset(&parallel)) {
+         if (mismatches++ < 5)
+            fprintf(stderr, "MISMATCH at statement %d: bexpr %d/%d, chain %d/%d\n",
+                    i, a.status, a.value, b.status, b.value);
+      }
+   }
+   if (serial_log.count != parallel_log.count)
+      mismatches++;
+   for (e = 0; e < serial_log.count && e < parallel_log.count; e++) {
+      if (serial_log.errors[e].status != parallel_log.errors[e].status
+          || serial_log.errors[e].offset != parallel_log.errors[e].offset)
+         mismatches++;
+   }
+   error_log_free(&serial_log);
+   error_log_free(&parallel_log);
+   return mismatches;
+}
+
+int main(int argc, char *argv[]) {
+   int megabytes = argc > 1 ? atoi(argv[1]) : 16;
+   int threads = argc > 2 ? atoi(argv[2]) : 4;
+   int repeats = argc > 3 ? atoi(argv[3]) : 5;
+   size_t size = (size_t) megabytes << 20;
+   struct task_pool pool;
+   struct parser_state ps;
+   char *checks, *input[SHAPES];
+   double start, serial, parallel;
+   int s, t, r, expected = 0, value, mismatches = 0;
+   unsigned long long steals;
+
+   srand(2311);
+   checks = gen_checks(256 * 1024, 4);
+   if (checks == NULL) {
+      fprintf(stderr, "ERROR: out of memory\n");
+      return 1;
+   }
+   for (t = 2; t <= 8; t *= 2) {
+      if (!pool_init(&pool, t)) {
+         fprintf(stderr, "ERROR: out of memory\n");
+         return 1;
+      }
+      mismatches += check(checks, &pool);
+      pool_free(&pool);
+   }
+   printf("%zu bytes of checks on 2, 4 and 8 threads: %d mismatches\n",
+          strlen(checks), mismatches);
+   free(checks);
+
+   for (s = 0; s < SHAPES; s++) {
+      char *end;
+      if ((input[s] = malloc(size + SLACK)) == NULL) {
+         fprintf(stderr, "ERROR: out of memory\n");
+         return 1;
+      }
+      end = gen_chain(input[s], s, size);
+      strcpy(end, ";");
+   }
+   if (!pool_init(&pool, threads)) {
+      fprintf(stderr, "ERROR: out of memory\n");
+      return 1;
+   }
+   printf("%d MB statements, %d threads, %d repeats\n", megabytes, pool.threads, repeats);
+   for (s = 0; s < SHAPES; s++) {
+      start = now();
+      for (r = 0; r < repeats; r++) {
+         parser_init(&ps, input[s]);
+         expected = bexpr(&ps).value;
+      }
+      serial = (now() - start) / repeats;
+
+      steals = atomic_load(&pool.steals);
+      start = now();
+      for (r = 0; r < repeats; r++) {
+         parser_init(&ps, input[s]);
+         value = chain_bexpr(&pool, &ps).value;
+         if (value != expected || ps.status != PARSE_OK)
+            mismatches++;
+      }
+      parallel = (now() - start) / repeats;
+      printf("%-8s bexpr %8.1f MB/s   chain_bexpr %8.1f MB/s   %.2fx   %llu steals\n",
+             names[s], megabytes / serial, megabytes / parallel, serial / parallel,
+             (unsigned long long) (atomic_load(&pool.steals) - steals) / repeats);
+      free(input[s]);
+   }
+   pool_free(&pool);
+   printf("%d mismatches\n", mismatches);
+   return mismatches != 0;
+}
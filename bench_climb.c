@@ -0,0 +1,260 @@
+/*
+ * bench_climb.c - compares climb_bexpr() with the recursive descent of
+ * bexpr() and the explicit stack of iter_bexpr(). It checks that
+ * climb_bexpr() and bexpr() agree on values, errors and where the
+ * parser ends up, on the generated corpus and on random, often
+ * malformed, tokens. Then it times all three on the corpus, on one
+ * with every class of operator weighted alike, and on wide, deep and
+ * '^'-nested statements. The recursive evaluators run those in a child
+ * process so a stack overflow is reported instead of ending the run.
+ *
+ * Build: make bench_climb
+ * Usage: bench_climb [statements] [max_depth]
+ * Date:  2025 May 14
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include "climb.h"
+#include "corpus.h"
+#include "iterative.h"
+
+enum evaluator { RECURSIVE, ITERATIVE, CLIMBING, EVALUATORS };
+
+static const char *evaluator_names[EVALUATORS] = { "bexpr", "iter_bexpr", "climb_bexpr" };
+
+static struct eval_stack stack;
+
+static double now(void) {
+   struct timespec ts;
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static struct eval_result evaluate(enum evaluator e, struct parser_state *ps) {
+   switch (e) {
+      case ITERATIVE: return iter_bexpr(ps, &stack);
+      case CLIMBING: return climb_bexpr(ps);
+      default: return bexpr(ps);
+   }
+}
+
+/*
+ * Evaluates every statement of input and returns the seconds per pass,
+ * over at least three passes and a fifth of a second.
+ */
+static double time_all(char *input, enum evaluator e) {
+   struct parser_state ps;
+   double start = now(), secs;
+   volatile int sink;
+   int passes = 0;
+
+   do {
+      parser_init(&ps, input);
+      while (ps.lex.kind != END_OF_INPUT)
+         sink = evaluate(e, &ps).value;
+      passes++;
+   } while ((secs = now() - start) < 0.2 || passes < 3);
+   (void) sink;
+   return secs / passes;
+}
+
+/*
+ * time_all() in a child process, for the evaluators that recurse.
+ * Returns the seconds per pass, or -1 if the child died.
+ */
+static double time_child(char *input, enum evaluator e) {
+   int fds[2], status;
+   double secs = -1;
+   pid_t pid;
+
+   if (e == ITERATIVE)
+      return time_all(input, e);
+   if (pipe(fds) != 0 || (pid = fork()) < 0)
+      return -1;
+   if (pid == 0) {
+      close(fds[0]);
+      secs = time_all(input, e);
+      if (write(fds[1], &secs, sizeof(secs)) != sizeof(secs))
+         _exit(1);
+      _exit(0);
+   }
+   close(fds[1]);
+   if (read(fds[0], &secs, sizeof(secs)) != sizeof(secs))
+      secs = -1;
+   close(fds[0]);
+   waitpid(pid, &status, 0);
+   return WIFEXITED(status) && WEXITSTATUS(status) == 0 ? secs : -1;
+}
+
+// "7 + 1 - 2 * 3 < 4 ..." with n operators, cycling through all but '/' and '^'
+static char *wide(int n) {
+   static const char *ops[] = { "+", "-", "*", "<", ">=", "==", "!=", "+", "<=", ">" };
+   char *text = malloc((size_t) n * 8 + 16), *out = text;
+   int i;
+
+   out += sprintf(out, "7");
+   for (i = 0; i < n; i++)
+      out += sprintf(out, " %s %d", ops[i % 10], 1 + i % 9);
+   strcpy(out, ";");
+   return text;
+}
+
+// n '(' around "1 + 2", each closed after adding one more term
+static char *deep(int n) {
+   char *text = malloc((size_t) n * 6 + 16), *out = text;
+   int i;
+
+   memset(out, '(', n);
+   out += n;
+   out += sprintf(out, "1 + 2");
+   for (i = 0; i < n; i++)
+      out += sprintf(out, ") - %d", i % 3);
+   strcpy(out, ";");
+   return text;
+}
+
+// "1 ^ 1 ^ 1 ..." with n '^', which nest to the right
+static char *tower(int n) {
+   char *text = malloc((size_t) n * 4 + 16), *out = text;
+   int i;
+
+   out += sprintf(out, "1");
+   for (i = 0; i < n; i++)
+      out += sprintf(out, " ^ %d", 1 + i % 2);
+   strcpy(out, ";");
+   return text;
+}
+
+// Statements of random tokens, often malformed, for the agreement check
+static char *soup(int count) {
+   static const char *tokens[] = {
+      "(", ")", "+", "-", "*", "/", "^", "<", "<=", ">", ">=", "==", "!=",
+      "0", "1", "2", "7", "31", "65536", "2147483647", "=", "!", "$", ";"
+   };
+   char *text = malloc((size_t) count * 16 * 12 + 1), *out = text;
+   int i, j;
+
+   for (i = 0; i < count; i++) {
+      int n = 1 + rand() % 15;
+      for (j = 0; j < n; j++) {
+         int pick = rand() % 100;
+         const char *token = pick < 40 ? tokens[13 + rand() % 7]
+                           : tokens[rand() % (sizeof(tokens) / sizeof(tokens[0]))];
+         out += sprintf(out, "%s ", token);
+      }
+      out += sprintf(out, ";\n");
+   }
+   *out = '\0';
+   return text;
+}
+
+// Evaluates input with bexpr() and climb_bexpr(), counting differences
+static int compare(char *input, int *statements) {
+   struct parser_state a, b;
+   struct error_log log_a, log_b;
+   int mismatches = 0;
+
+   error_log_init(&log_a);
+   error_log_init(&log_b);
+   parser_init(&a, input);
+   parser_init(&b, input);
+   a.errors = &log_a;
+   b.errors = &log_b;
+   *statements = 0;
+   while (a.lex.kind != END_OF_INPUT || b.lex.kind != END_OF_INPUT) {
+      struct eval_result x = bexpr(&a), y = climb_bexpr(&b);
+      if (x.status != y.status || x.value != y.value || token_offset(&a) != token_offset(&b)
+          || a.is_right_paren_error != b.is_right_paren_error)
+         mismatches++;
+      (*statements)++;
+   }
+   if (log_a.count != log_b.count)
+      mismatches++;
+   for (size_t i = 0; i < log_a.count && i < log_b.count; i++) {
+      if (log_a.errors[i].offset != log_b.errors[i].offset
+          || strcmp(log_a.errors[i].message, log_b.errors[i].message) != 0)
+         mismatches++;
+   }
+   error_log_free(&log_a);
+   error_log_free(&log_b);
+   return mismatches;
+}
+
+// Times a corpus with each evaluator and checks climb_bexpr() against bexpr()
+static int run_corpus(const char *name, char *input) {
+   double secs[EVALUATORS];
+   int e, statements, mismatches = compare(input, &statements);
+
+   for (e = 0; e < EVALUATORS; e++)
+      secs[e] = time_all(input, e);
+   printf("%s, %d statements, %d mismatches\n", name, statements, mismatches);
+   for (e = 0; e < EVALUATORS; e++)
+      printf("  %-12s %8.2f M stmts/s  (%.2fx)\n", evaluator_names[e],
+             statements / secs[e] / 1e6, secs[RECURSIVE] / secs[e]);
+   return mismatches;
+}
+
+int main(int argc, char *argv[]) {
+   int count = argc > 1 ? atoi(argv[1]) : 200000;
+   int max_depth = argc > 2 ? atoi(argv[2]) : 1000000;
+   static const char *names[] = { "wide", "deep", "tower" };
+   char *(*const shapes[])(int) = { wide, deep, tower };
+   struct corpus_options opt;
+   char *input;
+   size_t length;
+   double secs;
+   int s, n, e, statements, mismatches = 0;
+
+   srand(2405);
+   eval_stack_init(&stack);
+   corpus_defaults(&opt);
+   opt.statements = count;
+   input = gen_corpus_with(&opt, &length);
+   if (input == NULL) {
+      fprintf(stderr, "ERROR: out of memory\n");
+      return 1;
+   }
+   mismatches += run_corpus("corpus", input);
+   free(input);
+
+   for (e = 0; e < CORPUS_OPS; e++)
+      opt.mix[e] = 1;
+   opt.depth = 5;
+   if ((input = gen_corpus_with(&opt, &length)) == NULL) {
+      fprintf(stderr, "ERROR: out of memory\n");
+      return 1;
+   }
+   mismatches += run_corpus("even mix, depth 5", input);
+   free(input);
+
+   input = soup(count);
+   n = compare(input, &statements);
+   printf("random tokens, %d statements, %d mismatches\n", statements, n);
+   mismatches += n;
+   free(input);
+
+   for (s = 0; s < 3; s++) {
+      printf("%s\n", names[s]);
+      for (n = 1000; n <= max_depth; n *= 10) {
+         input = shapes[s](n);
+         printf("  %8d", n);
+         for (e = 0; e < EVALUATORS; e++) {
+            if ((secs = time_child(input, e)) < 0)
+               printf("  %s  stack overflow", evaluator_names[e]);
+            else
+               printf("  %s %9.3f ms", evaluator_names[e], secs * 1e3);
+         }
+         printf("\n");
+         free(input);
+      }
+   }
+
+   eval_stack_free(&stack);
+   printf("%d mismatches\n", mismatches);
+   return mismatches != 0;
+}
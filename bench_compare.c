@@ -0,0 +1,208 @@
+/*
+ * bench_compare.c - comparison-heavy statements with random operands and
+ * operators, so no comparison outcome or operator is predictable. Times
+ * a switch on the operator against compare_values() on the same random
+ * triples, then bexpr(), iter_bexpr(), bytecode and folded trees on
+ * statements of selects like (a < b) * 7 + (c >= d) * 0, reporting how
+ * much code the compilers drop and checking every result against bexpr().
+ *
+ * Build: make bench_compare
+ * Usage: bench_compare [statements] [repeats]
+ * Date:  2025 May 8
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "bytecode.h"
+#include "iterative.h"
+#include "optimize.h"
+
+#define TRIPLES (1 << 20)
+
+static const int compare_kinds[] = {
+   LESS_THAN_OP, GREATER_THAN_OP, LESS_THAN_OR_EQUAL_OP,
+   GREATER_THAN_OR_EQUAL_OP, EQUALS_OP, NOT_EQUALS_OP
+};
+static const char *compare_text[] = { "<", ">", "<=", ">=", "==", "!=" };
+
+static double now(void) {
+   struct timespec ts;
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// What ftail() did before: one branch per operator
+__attribute__((noinline))
+static int compare_switch(int kind, int a, int b) {
+   switch (kind) {
+      case LESS_THAN_OP: return a < b;
+      case GREATER_THAN_OP: return a > b;
+      case NOT_EQUALS_OP: return a != b;
+      case EQUALS_OP: return a == b;
+      case GREATER_THAN_OR_EQUAL_OP: return a >= b;
+      default: return a <= b;
+   }
+}
+
+__attribute__((noinline))
+static int compare_table(int kind, int a, int b) {
+   return compare_values(kind, a, b);
+}
+
+/*
+ * Sums one comparison per triple through the given function, chaining
+ * each result into the next left operand as ftail() does.
+ * Returns nanoseconds per comparison.
+ */
+static double time_triples(int (*compare)(int, int, int), const int *kinds, const int *a,
+                           const int *b, int repeats, int *sum) {
+   double start = now();
+   int r, i, total = 0;
+
+   for (r = 0; r < repeats; r++) {
+      for (i = 0; i < TRIPLES; i++)
+         total += compare(kinds[i], a[i] + (total & 1), b[i]);
+   }
+   *sum = total;
+   return (now() - start) * 1e9 / ((double) repeats * TRIPLES);
+}
+
+// A statement of 2 to 8 terms, each a comparison chain or a select
+static char *gen_statement(char *out) {
+   int terms = 2 + rand() % 7, t, n;
+
+   for (t = 0; t < terms; t++) {
+      if (t > 0)
+         out += sprintf(out, " %s ", rand() % 2 ? "+" : "-");
+      n = 1 + rand() % 3;
+      if (rand() % 2) {
+         // a select, with the constant on either side: (a < b) * k or k * (a < b)
+         int k = rand() % 3 == 0 ? 0 : rand() % 3 == 0 ? 1 : rand() % 100;
+         bool left = rand() % 2;
+         out += left ? sprintf(out, "%d * (%d", k, rand() % 100) : sprintf(out, "(%d", rand() % 100);
+         while (n-- > 0)
+            out += sprintf(out, " %s %d", compare_text[rand() % 6], rand() % 100);
+         out += left ? sprintf(out, ")") : sprintf(out, ") * %d", k);
+      } else {
+         out += sprintf(out, "%d", rand() % 100);
+         while (n-- > 0)
+            out += sprintf(out, " %s %d", compare_text[rand() % 6], rand() % 100);
+      }
+   }
+   return out + sprintf(out, ";\n");
+}
+
+int main(int argc, char *argv[]) {
+   int count = argc > 1 ? atoi(argv[1]) : 200000;
+   int repeats = argc > 2 ? atoi(argv[2]) : 10;
+   int *kinds = malloc(TRIPLES * sizeof(int)), *a = malloc(TRIPLES * sizeof(int));
+   int *b = malloc(TRIPLES * sizeof(int));
+   char *input = malloc((size_t) count * 256 + 1), *out = input;
+   struct parser_state ps;
+   struct eval_stack st;
+   struct ast_arena arena;
+   struct ast tree, folded;
+   struct program *progs;
+   struct eval_result *expected;
+   double branchy, table, start, recursive, iterative, bytecode;
+   long code = 0, eliminated = 0, nodes = 0;
+   volatile int sink;
+   int i, r, sum1, sum2, mismatches = 0;
+
+   progs = calloc(count, sizeof(struct program));
+   expected = malloc(count * sizeof(struct eval_result));
+   if (kinds == NULL || a == NULL || b == NULL || input == NULL || progs == NULL
+       || expected == NULL) {
+      fprintf(stderr, "ERROR: out of memory\n");
+      return 1;
+   }
+
+   srand(352);
+   for (i = 0; i < TRIPLES; i++) {
+      kinds[i] = compare_kinds[rand() % 6];
+      a[i] = rand() % 100;
+      b[i] = rand() % 100;
+   }
+   branchy = time_triples(compare_switch, kinds, a, b, repeats, &sum1);
+   table = time_triples(compare_table, kinds, a, b, repeats, &sum2);
+   printf("random comparisons: switch %.2f ns  table %.2f ns  (%.2fx)%s\n",
+          branchy, table, branchy / table, sum1 != sum2 ? "  MISMATCH" : "");
+
+   for (i = 0; i < count; i++)
+      out = gen_statement(out);
+
+   start = now();
+   for (r = 0; r < repeats; r++) {
+      parser_init(&ps, input);
+      for (i = 0; i < count; i++)
+         expected[i] = bexpr(&ps);
+   }
+   recursive = (now() - start) / repeats;
+
+   eval_stack_init(&st);
+   start = now();
+   for (r = 0; r < repeats; r++) {
+      parser_init(&ps, input);
+      for (i = 0; i < count; i++) {
+         struct eval_result result = iter_bexpr(&ps, &st);
+         if (r == 0 && (result.status != expected[i].status || result.value != expected[i].value))
+            mismatches++;
+      }
+   }
+   iterative = (now() - start) / repeats;
+   eval_stack_free(&st);
+
+   parser_init(&ps, input);
+   for (i = 0; i < count; i++) {
+      compile(&ps, &progs[i]);
+      code += progs[i].length;
+   }
+   start = now();
+   for (r = 0; r < repeats; r++) {
+      for (i = 0; i < count; i++)
+         sink = run(&progs[i], &ps).value;
+   }
+   bytecode = (now() - start) / repeats;
+   for (i = 0; i < count; i++) {
+      struct eval_result result = run(&progs[i], &ps);
+      if (result.status != expected[i].status || result.value != expected[i].value)
+         mismatches++;
+      program_free(&progs[i]);
+   }
+
+   ast_arena_init(&arena);
+   parser_init(&ps, input);
+   for (i = 0; i < count; i++) {
+      struct eval_result result;
+
+      ast_arena_reset(&arena);
+      if (!ast_parse(&ps, &arena, &tree) || (r = ast_fold(&arena, &tree, &folded)) == ERROR
+          || (result = ast_eval(&arena, &folded, &ps)).status != expected[i].status
+          || result.value != expected[i].value) {
+         mismatches++;
+         continue;
+      }
+      nodes += tree.root - tree.first + 1;
+      eliminated += r;
+   }
+   ast_arena_free(&arena);
+   (void) sink;
+
+   printf("%d statements\n", count);
+   printf("bexpr        %8.2f M stmts/s\n", count / recursive / 1e6);
+   printf("iter_bexpr   %8.2f M stmts/s\n", count / iterative / 1e6);
+   printf("bytecode     %8.2f M stmts/s, %.1f ints of code/stmt\n",
+          count / bytecode / 1e6, (double) code / count);
+   printf("ast_fold     %.1f%% of %ld nodes eliminated\n", 100.0 * eliminated / nodes, nodes);
+   printf("%d mismatches\n", mismatches);
+
+   free(kinds);
+   free(a);
+   free(b);
+   free(input);
+   free(progs);
+   free(expected);
+   return 0;
+}
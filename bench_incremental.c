@@ -0,0 +1,107 @@
+/*
+ * bench_incremental.c - edits a few statements of a large corpus and
+ * compares evaluating the whole edited file again against incremental
+ * evaluation with the statement cache saved from the previous run.
+ *
+ * Build: make bench_incremental
+ * Usage: bench_incremental [statements] [percent_edited] [cache_file]
+ * Date:  2025 May 3
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "corpus.h"
+#include "incremental.h"
+
+static double now(void) {
+   struct timespec ts;
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// Loads the cache at path, evaluates input with it and saves the new one
+static int run_incremental(const char *path, const char *input, size_t length,
+                           struct statement_batch *batch, struct incr_stats *stats) {
+   struct stmt_cache old, fresh;
+
+   stmt_cache_load(&old, path);
+   if (batch_split(batch, input, length) < 0 || !stmt_cache_init(&fresh)
+       || incr_eval(batch, &old, &fresh, stats) < 0 || !stmt_cache_save(&fresh, path)) {
+      fprintf(stderr, "ERROR: incremental run failed\n");
+      exit(1);
+   }
+   stmt_cache_free(&old);
+   stmt_cache_free(&fresh);
+   return batch->count;
+}
+
+int main(int argc, char *argv[]) {
+   int count = argc > 1 ? atoi(argv[1]) : 1000000;
+   double percent = argc > 2 ? atof(argv[2]) : 1;
+   const char *path = argc > 3 ? argv[3] : "bench_incremental.stc";
+   struct statement_batch batch, full;
+   struct incr_stats stats;
+   char *input, *edited, *out, stmt[CORPUS_MAX_STMT + 4];
+   size_t length;
+   double start, cold, warm, rerun;
+   int i, mismatches = 0;
+
+   srand(352);
+   input = gen_corpus(count, &length);
+   edited = malloc(length + (size_t) count * (CORPUS_MAX_STMT + 4));
+   if (input == NULL || edited == NULL) {
+      fprintf(stderr, "ERROR: out of memory\n");
+      return 1;
+   }
+   remove(path);
+
+   start = now();
+   run_incremental(path, input, length, &batch, &stats);
+   cold = now() - start;
+
+   // replace about percent of the statements with new ones
+   out = edited;
+   for (i = 0; i < batch.count; i++) {
+      if (rand() < percent / 100 * RAND_MAX) {
+         strcpy(gen_expr(stmt, 3), ";\n");
+         out += sprintf(out, "%s", stmt);
+      } else {
+         out += sprintf(out, "%s", batch.stmts[i]);
+      }
+   }
+   batch_free(&batch);
+
+   start = now();
+   if (batch_split(&full, edited, out - edited) < 0) {
+      fprintf(stderr, "ERROR: out of memory\n");
+      return 1;
+   }
+   batch_eval(&full, 1);
+   rerun = now() - start;
+
+   start = now();
+   run_incremental(path, edited, out - edited, &batch, &stats);
+   warm = now() - start;
+
+   for (i = 0; i < batch.count; i++) {
+      if (batch.results[i].status != full.results[i].status
+          || batch.results[i].value != full.results[i].value)
+         mismatches++;
+   }
+
+   printf("%d statements, %.1f MB, %.1f%% edited\n", batch.count, length / 1e6, percent);
+   printf("first run, empty cache  %8.1f ms\n", cold * 1e3);
+   printf("full re-evaluation      %8.1f ms\n", rerun * 1e3);
+   printf("incremental             %8.1f ms (%.2fx), %d reused, %d evaluated\n",
+          warm * 1e3, rerun / warm, stats.reused, stats.evaluated);
+   printf("%d mismatches\n", mismatches);
+
+   batch_free(&batch);
+   batch_free(&full);
+   free(input);
+   free(edited);
+   remove(path);
+   return mismatches != 0;
+}
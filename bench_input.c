@@ -0,0 +1,83 @@
+/*
+ * bench_input.c - compares tokenizer throughput reading a large file in
+ * STREAM_CHUNK blocks, from the file and through a pipe, against mapping
+ * it with mmap(). The token report goes to /dev/null.
+ *
+ * Build: make bench_input
+ * Usage: bench_input [megabytes] [scratch_file]
+ * Date:  2025 April 29
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include "corpus.h"
+#include "tokenizer.h"
+
+// Statements generated per write while building the input file
+#define BLOCK 10000
+
+static double now(void) {
+   struct timespec ts;
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+int main(int argc, char *argv[]) {
+   double megabytes = argc > 1 ? atof(argv[1]) : 2048;
+   const char *path = argc > 2 ? argv[2] : "bench_input.txt";
+   FILE *file, *pipe_in;
+   char *block, command[256];
+   size_t length, total = 0;
+   double start, streamed, piped, mapped;
+   int fd, null_out;
+
+   if ((file = fopen(path, "w")) == NULL || (null_out = open("/dev/null", O_WRONLY)) < 0) {
+      fprintf(stderr, "ERROR: could not open %s for writing\n", path);
+      return 1;
+   }
+   srand(352);
+   while (total < megabytes * 1e6) {
+      if ((block = gen_corpus(BLOCK, &length)) == NULL) {
+         fprintf(stderr, "ERROR: out of memory\n");
+         return 1;
+      }
+      fwrite(block, 1, length, file);
+      free(block);
+      total += length;
+   }
+   fclose(file);
+
+   // read the file once so every run starts from the page cache
+   fd = open(path, O_RDONLY);
+   tokenize_stream(fd, null_out);
+   close(fd);
+
+   fd = open(path, O_RDONLY);
+   start = now();
+   tokenize_stream(fd, null_out);
+   streamed = now() - start;
+   close(fd);
+
+   snprintf(command, sizeof(command), "cat '%s'", path);
+   pipe_in = popen(command, "r");
+   start = now();
+   tokenize_stream(fileno(pipe_in), null_out);
+   piped = now() - start;
+   pclose(pipe_in);
+
+   start = now();
+   tokenize_mapped(path, null_out);
+   mapped = now() - start;
+
+   printf("%.1f MB input\n", total / 1e6);
+   printf("stream, file  %8.1f MB/s\n", total / 1e6 / streamed);
+   printf("stream, pipe  %8.1f MB/s\n", total / 1e6 / piped);
+   printf("mmap          %8.1f MB/s\n", total / 1e6 / mapped);
+
+   close(null_out);
+   remove(path);
+   return 0;
+}
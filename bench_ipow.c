@@ -0,0 +1,92 @@
+/*
+ * bench_ipow.c - compares ipow() with the (int) pow() it replaced on
+ * exponent-heavy workloads: random exponents, and the small constant
+ * exponents that take ipow()'s fast path.
+ *
+ * Build: make bench_ipow
+ * Usage: bench_ipow [operations]
+ * Date:  2025 April 28
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <time.h>
+#include "ipow.h"
+
+static double now(void) {
+   struct timespec ts;
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/**
+ * Times n powers with libm and with ipow() over the same operands.
+ * @param label: what the operands are
+ * @param bases: the bases
+ * @param exps: the exponents
+ * @param n: the number of operands
+ * @return: the number of results that differ
+ */
+static int compare(const char *label, const int *bases, const int *exps, int n) {
+   double start, libm, integer;
+   volatile int sink;
+   int i, value, mismatches = 0;
+
+   start = now();
+   for (i = 0; i < n; i++)
+      sink = (int) pow(bases[i], exps[i]);
+   libm = now() - start;
+
+   start = now();
+   for (i = 0; i < n; i++) {
+      ipow(bases[i], exps[i], &value);
+      sink = value;
+   }
+   integer = now() - start;
+
+   for (i = 0; i < n; i++) {
+      if (!ipow(bases[i], exps[i], &value) || value != (int) pow(bases[i], exps[i]))
+         mismatches++;
+   }
+   (void) sink;
+   printf("%-22s pow() %8.1f Mops/s   ipow() %8.1f Mops/s   %.1fx\n",
+          label, n / libm / 1e6, n / integer / 1e6, libm / integer);
+   return mismatches;
+}
+
+int main(int argc, char *argv[]) {
+   int n = argc > 1 ? atoi(argv[1]) : 10000000;
+   int *bases = malloc(n * sizeof(int)), *exps = malloc(n * sizeof(int));
+   int i, mismatches = 0;
+
+   if (n <= 0 || bases == NULL || exps == NULL) {
+      fprintf(stderr, "ERROR: could not allocate %d operands\n", n);
+      return 1;
+   }
+   srand(352);
+
+   // every power below fits in an int, so both must agree
+   for (i = 0; i < n; i++) {
+      bases[i] = rand() % 7 - 3;
+      exps[i] = rand() % 20;
+   }
+   mismatches += compare("random exponent", bases, exps, n);
+
+   for (i = 0; i < n; i++) {
+      bases[i] = rand() % 1000;
+      exps[i] = 2;
+   }
+   mismatches += compare("constant exponent 2", bases, exps, n);
+
+   for (i = 0; i < n; i++) {
+      bases[i] = rand() % 1000;
+      exps[i] = 3;
+   }
+   mismatches += compare("constant exponent 3", bases, exps, n);
+
+   printf("%d mismatches\n", mismatches);
+   free(bases);
+   free(exps);
+   return mismatches != 0;
+}
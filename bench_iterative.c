@@ -0,0 +1,221 @@
+/*
+ * bench_iterative.c - compares iter_bexpr() with the recursive bexpr()
+ * on the generated corpus, on wide inputs (one long operator chain) and
+ * on deep ones (nested parentheses, right-nested '^'), and checks that
+ * both agree on values and errors for random, often malformed, input.
+ * The recursive evaluator runs in a child process so the depth at which
+ * it overflows the stack is reported instead of ending the benchmark.
+ *
+ * Build: make bench_iterative
+ * Usage: bench_iterative [statements] [max_depth]
+ * Date:  2025 May 6
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include "corpus.h"
+#include "iterative.h"
+
+static double now(void) {
+   struct timespec ts;
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/*
+ * Evaluates every statement of input, either way, and returns the
+ * seconds per pass, over at least three passes and a fifth of a second.
+ */
+static double time_all(char *input, struct eval_stack *st) {
+   struct parser_state ps;
+   double start = now(), secs;
+   volatile int sink;
+   int passes = 0;
+
+   do {
+      parser_init(&ps, input);
+      while (ps.lex.kind != END_OF_INPUT)
+         sink = (st != NULL ? iter_bexpr(&ps, st) : bexpr(&ps)).value;
+      passes++;
+   } while ((secs = now() - start) < 0.2 || passes < 3);
+   (void) sink;
+   return secs / passes;
+}
+
+/*
+ * time_all() for the recursive evaluator in a child process.
+ * Returns the seconds per pass, or -1 if the child died.
+ */
+static double time_recursive(char *input) {
+   int fds[2], status;
+   double secs = -1;
+   pid_t pid;
+
+   if (pipe(fds) != 0 || (pid = fork()) < 0)
+      return -1;
+   if (pid == 0) {
+      close(fds[0]);
+      secs = time_all(input, NULL);
+      if (write(fds[1], &secs, sizeof(secs)) != sizeof(secs))
+         _exit(1);
+      _exit(0);
+   }
+   close(fds[1]);
+   if (read(fds[0], &secs, sizeof(secs)) != sizeof(secs))
+      secs = -1;
+   close(fds[0]);
+   waitpid(pid, &status, 0);
+   return WIFEXITED(status) && WEXITSTATUS(status) == 0 ? secs : -1;
+}
+
+// "7 + 1 - 2 * 3 < 4 ..." with n operators, cycling through all but '/' and '^'
+static char *wide(int n) {
+   static const char *ops[] = { "+", "-", "*", "<", ">=", "==", "!=", "+", "<=", ">" };
+   char *text = malloc((size_t) n * 8 + 16), *out = text;
+   int i;
+
+   out += sprintf(out, "7");
+   for (i = 0; i < n; i++)
+      out += sprintf(out, " %s %d", ops[i % 10], 1 + i % 9);
+   strcpy(out, ";");
+   return text;
+}
+
+// n '(' around "1 + 2", each closed after adding one more term
+static char *deep(int n) {
+   char *text = malloc((size_t) n * 6 + 16), *out = text;
+   int i;
+
+   memset(out, '(', n);
+   out += n;
+   out += sprintf(out, "1 + 2");
+   for (i = 0; i < n; i++)
+      out += sprintf(out, ") - %d", i % 3);
+   strcpy(out, ";");
+   return text;
+}
+
+// "1 ^ 1 ^ 1 ..." with n '^', which the recursive <factor> nests
+static char *tower(int n) {
+   char *text = malloc((size_t) n * 4 + 16), *out = text;
+   int i;
+
+   out += sprintf(out, "1");
+   for (i = 0; i < n; i++)
+      out += sprintf(out, " ^ %d", 1 + i % 2);
+   strcpy(out, ";");
+   return text;
+}
+
+// Statements of random tokens, often malformed, for the agreement check
+static char *soup(int count) {
+   static const char *tokens[] = {
+      "(", ")", "+", "-", "*", "/", "^", "<", "<=", ">", ">=", "==", "!=",
+      "0", "1", "2", "7", "31", "65536", "2147483647", "=", "!", "$", ";"
+   };
+   char *text = malloc((size_t) count * 16 * 12 + 1), *out = text;
+   int i, j;
+
+   for (i = 0; i < count; i++) {
+      int n = 1 + rand() % 15;
+      for (j = 0; j < n; j++) {
+         int pick = rand() % 100;
+         const char *token = pick < 40 ? tokens[13 + rand() % 7]
+                           : tokens[rand() % (sizeof(tokens) / sizeof(tokens[0]))];
+         out += sprintf(out, "%s ", token);
+      }
+      out += sprintf(out, ";\n");
+   }
+   *out = '\0';
+   return text;
+}
+
+// Evaluates input both ways, statement by statement, counting differences
+static int compare(char *input, struct eval_stack *st, int *statements) {
+   struct parser_state a, b;
+   struct error_log log_a, log_b;
+   int mismatches = 0;
+
+   error_log_init(&log_a);
+   error_log_init(&log_b);
+   parser_init(&a, input);
+   parser_init(&b, input);
+   a.errors = &log_a;
+   b.errors = &log_b;
+   *statements = 0;
+   while (a.lex.kind != END_OF_INPUT || b.lex.kind != END_OF_INPUT) {
+      struct eval_result x = bexpr(&a), y = iter_bexpr(&b, st);
+      if (x.status != y.status || x.value != y.value || token_offset(&a) != token_offset(&b))
+         mismatches++;
+      (*statements)++;
+   }
+   if (log_a.count != log_b.count)
+      mismatches++;
+   for (size_t i = 0; i < log_a.count && i < log_b.count; i++) {
+      if (log_a.errors[i].offset != log_b.errors[i].offset
+          || strcmp(log_a.errors[i].message, log_b.errors[i].message) != 0)
+         mismatches++;
+   }
+   error_log_free(&log_a);
+   error_log_free(&log_b);
+   return mismatches;
+}
+
+int main(int argc, char *argv[]) {
+   int count = argc > 1 ? atoi(argv[1]) : 200000;
+   int max_depth = argc > 2 ? atoi(argv[2]) : 1000000;
+   static const char *names[] = { "wide", "deep", "tower" };
+   char *(*const shapes[])(int) = { wide, deep, tower };
+   struct eval_stack st;
+   char *input;
+   size_t length;
+   double recursive, iterative;
+   int s, n, statements, mismatches;
+
+   srand(352);
+   eval_stack_init(&st);
+   input = gen_corpus(count, &length);
+   if (input == NULL) {
+      fprintf(stderr, "ERROR: out of memory\n");
+      return 1;
+   }
+   recursive = time_all(input, NULL);
+   iterative = time_all(input, &st);
+   mismatches = compare(input, &st, &statements);
+   printf("corpus, %d statements\n", statements);
+   printf("recursive %8.2f M stmts/s  iterative %8.2f M stmts/s  (%.2fx), %d mismatches\n",
+          statements / recursive / 1e6, statements / iterative / 1e6,
+          recursive / iterative, mismatches);
+   free(input);
+
+   input = soup(count);
+   mismatches = compare(input, &st, &statements);
+   printf("random tokens, %d statements, %d mismatches\n", statements, mismatches);
+   free(input);
+
+   for (s = 0; s < 3; s++) {
+      printf("%s\n", names[s]);
+      for (n = 1000; n <= max_depth; n *= 10) {
+         input = shapes[s](n);
+         iterative = time_all(input, &st);
+         recursive = time_recursive(input);
+         if (recursive < 0) {
+            printf("  %8d  recursive   stack overflow  iterative %9.3f ms\n",
+                   n, iterative * 1e3);
+         } else {
+            mismatches = compare(input, &st, &statements);
+            printf("  %8d  recursive %9.3f ms  iterative %9.3f ms  (%.2fx)%s\n",
+                   n, recursive * 1e3, iterative * 1e3, recursive / iterative,
+                   mismatches ? "  MISMATCH" : "");
+         }
+         free(input);
+      }
+   }
+
+   eval_stack_free(&st);
+   return 0;
+}
@@ -0,0 +1,227 @@
+/*
+ * bench_jit.c - checks and times the JIT. First it runs random
+ * statements through bexpr() and through jit_bexpr() with every
+ * statement compiled, including statements that divide by zero,
+ * overflow or are malformed, and compares the results, where the parser
+ * ends up and the errors logged. There are more of them than fit the
+ * cache's default cap, so entries are evicted and code is flushed on the
+ * way. Then it times bexpr(), bytecode,
+ * jit_bexpr() and calls of the compiled functions on a corpus that is
+ * evaluated over and over.
+ *
+ * Build: make bench_jit
+ * Usage: bench_jit [statements] [repeats] [checks]
+ * Date:  2025 May 11
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "bytecode.h"
+#include "corpus.h"
+#include "jit.h"
+
+static const char *operators[] = {
+   "+", "-", "*", "/", "^", "<", ">", "<=", ">=", "==", "!="
+};
+
+static double now(void) {
+   struct timespec ts;
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// A literal that is often 0, 1 or large, so errors and wrapping are common
+static char *gen_literal(char *out) {
+   switch (rand() % 8) {
+      case 0: return out + sprintf(out, "0");
+      case 1: return out + sprintf(out, "1");
+      case 2: return out + sprintf(out, "2147483647");
+      case 3: return out + sprintf(out, "(0 - 2147483647 - 1)");
+      case 4: return out + sprintf(out, "(0 - 1)");
+      case 5: return out + sprintf(out, "%d", rand());
+      default: return out + sprintf(out, "%d", rand() % 20);
+   }
+}
+
+// An expression of up to 5 operands with any operators, nested to depth
+static char *gen_random(char *out, int depth) {
+   int terms = 1 + rand() % 5, t;
+
+   for (t = 0; t < terms; t++) {
+      if (t > 0)
+         out += sprintf(out, " %s ", operators[rand() % 11]);
+      if (depth > 0 && rand() % 3 == 0) {
+         *out++ = '(';
+         out = gen_random(out, depth - 1);
+         *out++ = ')';
+      } else {
+         out = gen_literal(out);
+      }
+   }
+   return out;
+}
+
+/**
+ * Writes count random statements, one in twenty with a byte replaced so
+ * that it is malformed, or ends early.
+ */
+static char *gen_checks(int count) {
+   char *input = malloc((size_t) count * CORPUS_MAX_STMT * 4 + 1), *out = input, *start;
+   int i;
+
+   if (input == NULL)
+      return NULL;
+   for (i = 0; i < count; i++) {
+      start = out;
+      out = gen_random(out, 3);
+      if (rand() % 20 == 0)
+         start[rand() % (out - start)] = "()+x;"[rand() % 5];
+      out += sprintf(out, ";\n");
+   }
+   *out = '\0';
+   return input;
+}
+
+/**
+ * Evaluates every statement of the input with bexpr() and again with
+ * jit_bexpr(), and counts the differences.
+ */
+static int check(char *input, int count, struct jit_cache *jc) {
+   struct parser_state interp, native;
+   struct error_log interp_log, native_log;
+   struct eval_result a, b;
+   int i, mismatches = 0;
+   size_t e;
+
+   error_log_init(&interp_log);
+   error_log_init(&native_log);
+   parser_init(&interp, input);
+   parser_init(&native, input);
+   interp.errors = &interp_log;
+   native.errors = &native_log;
+   for (i = 0; i < count && interp.lex.kind != END_OF_INPUT; i++) {
+      a = bexpr(&interp);
+      b = jit_bexpr(jc, &native);
+      if (a.status != b.status || a.value != b.value
+          || token_offset(&interp) != token_offset(&native)) {
+         if (mismatches++ < 5)
+            fprintf(stderr, "MISMATCH at statement %d: bexpr %d/%d, jit %d/%d\n",
+                    i, a.status, a.value, b.status, b.value);
+      }
+   }
+   if (interp_log.count != native_log.count)
+      mismatches++;
+   for (e = 0; e < interp_log.count && e < native_log.count; e++) {
+      if (interp_log.errors[e].status != native_log.errors[e].status
+          || interp_log.errors[e].offset != native_log.errors[e].offset)
+         mismatches++;
+   }
+   error_log_free(&interp_log);
+   error_log_free(&native_log);
+   return mismatches;
+}
+
+int main(int argc, char *argv[]) {
+   int count = argc > 1 ? atoi(argv[1]) : 2000;
+   int repeats = argc > 2 ? atoi(argv[2]) : 500;
+   int checks = argc > 3 ? atoi(argv[3]) : 200000;
+   struct corpus_options opt;
+   struct parser_state ps;
+   struct jit_cache jc, hot;
+   struct program *progs;
+   jit_fn *fns;
+   char *input, *random;
+   size_t length;
+   double start, interpreted, bytecode, cached, direct;
+   long checksum[4] = { 0, 0, 0, 0 };
+   int i, r, value, mismatches;
+
+   srand(2111);
+   corpus_defaults(&opt);
+   opt.statements = count;
+   input = gen_corpus_with(&opt, &length);
+   random = gen_checks(checks);
+   progs = calloc(count, sizeof(struct program));
+   fns = calloc(count, sizeof(jit_fn));
+   if (input == NULL || random == NULL || progs == NULL || fns == NULL
+       || !jit_init(&jc, 0, 0) || !jit_init(&hot, JIT_HOT, 0)) {
+      fprintf(stderr, "ERROR: out of memory\n");
+      return 1;
+   }
+   if (!jc.available)
+      printf("no JIT in this build or on this system; jit_bexpr() runs bexpr()\n");
+
+   mismatches = check(random, checks, &jc);
+   printf("%d random statements: %llu compiled, %llu rejected, %llu native, %llu interpreted\n",
+          checks, (unsigned long long) jc.compiled, (unsigned long long) jc.rejected,
+          (unsigned long long) jc.native, (unsigned long long) jc.interpreted);
+   printf("  %llu entries evicted, %llu code flushes; %zu bytes of entries and %zu of"
+          " code held, under a cap of %zu each\n", (unsigned long long) jc.evictions,
+          (unsigned long long) jc.flushes, jc.bytes, jc.mapped, jc.max_bytes);
+
+   start = now();
+   for (r = 0; r < repeats; r++) {
+      parser_init(&ps, input);
+      for (i = 0; i < count; i++)
+         checksum[0] += bexpr(&ps).value;
+   }
+   interpreted = (now() - start) / repeats;
+
+   parser_init(&ps, input);
+   for (i = 0; i < count; i++)
+      compile(&ps, &progs[i]);
+   start = now();
+   for (r = 0; r < repeats; r++) {
+      for (i = 0; i < count; i++)
+         checksum[1] += run(&progs[i], &ps).value;
+   }
+   bytecode = (now() - start) / repeats;
+
+   // the text lookup and the parser's move past each statement included
+   start = now();
+   for (r = 0; r < repeats; r++) {
+      parser_init(&ps, input);
+      for (i = 0; i < count; i++)
+         checksum[2] += jit_bexpr(&hot, &ps).value;
+   }
+   cached = (now() - start) / repeats;
+
+   parser_init(&ps, input);
+   for (i = 0; i < count; i++) {
+      if ((fns[i] = jit_compile(&jc, &ps)) == NULL)
+         break;
+   }
+   start = now();
+   for (r = 0; r < repeats; r++) {
+      for (i = 0; i < count && fns[i] != NULL; i++)
+         if (fns[i](&value))
+            checksum[3] += value;
+   }
+   direct = (now() - start) / repeats;
+
+   for (i = 1; i < 4; i++) {
+      if (checksum[i] != checksum[0] && (i != 3 || jc.available))
+         mismatches++;
+   }
+   printf("%d statements, %d repeats\n", count, repeats);
+   printf("bexpr            %8.2f M stmts/s\n", count / interpreted / 1e6);
+   printf("bytecode run     %8.2f M stmts/s\n", count / bytecode / 1e6);
+   printf("jit_bexpr        %8.2f M stmts/s  (%llu native, %llu interpreted)\n",
+          count / cached / 1e6, (unsigned long long) hot.native,
+          (unsigned long long) hot.interpreted);
+   if (jc.available)
+      printf("compiled calls   %8.2f M stmts/s\n", count / direct / 1e6);
+   printf("%d mismatches\n", mismatches);
+
+   for (i = 0; i < count; i++)
+      program_free(&progs[i]);
+   free(progs);
+   free(fns);
+   free(input);
+   free(random);
+   jit_free(&jc);
+   jit_free(&hot);
+   return mismatches != 0;
+}
@@ -0,0 +1,188 @@
+/*
+ * bench_lexeme.c - measures what lexing copies and allocates per MB of
+ * input. Three loops take the same tokens from the generated corpus:
+ *
+ *    line copy   - the first tokenizer's scheme: the rest of the line is
+ *                  copied into a buffer before each token, which is then
+ *                  cut down to the lexeme
+ *    token copy  - each lexeme copied into a TSIZE buffer, as the parser
+ *                  did before it took descriptors
+ *    descriptor  - next_lexeme(), which copies nothing
+ *
+ * Then bexpr() evaluates the corpus. The allocation functions are
+ * wrapped at link time to count calls, and every loop checks that it
+ * saw the same tokens as next_lexeme().
+ *
+ * Build: make bench_lexeme
+ * Usage: bench_lexeme [statements] [statements_per_line]
+ * Date:  2025 May 15
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "corpus.h"
+#include "parser.h"
+
+#define TSIZE 20   // the parser's old token buffer
+
+enum scheme { LINE_COPY, TOKEN_COPY, DESCRIPTOR, SCHEMES };
+
+static const char *scheme_names[SCHEMES] = { "line copy", "token copy", "descriptor" };
+
+static unsigned long long allocations;
+
+void *__real_malloc(size_t);
+void *__real_calloc(size_t, size_t);
+void *__real_realloc(void *, size_t);
+
+void *__wrap_malloc(size_t size) {
+   allocations++;
+   return __real_malloc(size);
+}
+
+void *__wrap_calloc(size_t count, size_t size) {
+   allocations++;
+   return __real_calloc(count, size);
+}
+
+void *__wrap_realloc(void *p, size_t size) {
+   allocations++;
+   return __real_realloc(p, size);
+}
+
+static double now(void) {
+   struct timespec ts;
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/*
+ * What one loop did: bytes copied, allocations, seconds, and a checksum
+ * of the token kinds and literal values it saw.
+ */
+struct result {
+   unsigned long long copied;
+   unsigned long long allocations;
+   double seconds;
+   unsigned long long checksum;
+};
+
+static unsigned long long mix(unsigned long long sum, const struct lexeme *t) {
+   return sum * 31 + (unsigned) t->kind * 7 + (unsigned) t->value;
+}
+
+/**
+ * Takes every token of input by one scheme. The copying schemes scan
+ * with next_lexeme() too, so they differ from it only in their copies.
+ */
+static struct result lex_all(char *input, size_t length, enum scheme scheme) {
+   struct lexer_state lex = { input, input, input + length, END_OF_INPUT, 0, 0 };
+   struct lexeme t;
+   struct result r = { 0, allocations, now(), 0 };
+   char token[TSIZE], *line = NULL, *line_end = input;
+   size_t capacity = 0;
+   volatile char sink;
+
+   for (;;) {
+      if (scheme == LINE_COPY) {
+         // The next token starts a new line: find its end for the copies
+         char *p = lex.line;
+         while (p < lex.end && (*p == ' ' || *p == '\t' || *p == '\n'))
+            p++;
+         if (p >= line_end) {
+            line_end = memchr(p, '\n', (size_t) (lex.end - p));
+            line_end = line_end != NULL ? line_end : lex.end;
+            if ((size_t) (line_end - p) + 1 > capacity) {
+               capacity = (size_t) (line_end - p) + 1;
+               free(line);
+               if ((line = malloc(capacity)) == NULL)
+                  return r;
+            }
+         }
+         memcpy(line, p, (size_t) (line_end - p));
+         line[line_end - p] = '\0';
+         r.copied += (unsigned long long) (line_end - p) + 1;
+      }
+      next_lexeme(&lex, &t);
+      if (t.kind == END_OF_INPUT)
+         break;
+      if (scheme == LINE_COPY) {
+         line[t.length] = '\0'; // cut down to the lexeme
+         sink = line[0];
+      } else if (scheme == TOKEN_COPY) {
+         size_t n = t.length < TSIZE - 1 ? (size_t) t.length : TSIZE - 1;
+         memcpy(token, t.start, n);
+         token[n] = '\0';
+         r.copied += n;
+         sink = token[0];
+      }
+      r.checksum = mix(r.checksum, &t);
+   }
+   (void) sink;
+   free(line);
+   r.seconds = now() - r.seconds;
+   r.allocations = allocations - r.allocations;
+   return r;
+}
+
+// Evaluates every statement of input with bexpr()
+static struct result eval_all(char *input) {
+   struct parser_state ps;
+   struct result r = { 0, allocations, now(), 0 };
+
+   parser_init(&ps, input);
+   while (ps.lex.kind != END_OF_INPUT)
+      r.checksum = r.checksum * 31 + (unsigned) bexpr(&ps).value;
+   r.seconds = now() - r.seconds;
+   r.allocations = allocations - r.allocations;
+   return r;
+}
+
+static void print(const char *name, const struct result *r, double megabytes) {
+   printf("  %-12s %12.0f bytes copied/MB %8.1f allocations/MB %8.1f MB/s\n", name,
+          r->copied / megabytes, r->allocations / megabytes, megabytes / r->seconds);
+}
+
+int main(int argc, char *argv[]) {
+   int count = argc > 1 ? atoi(argv[1]) : 200000;
+   int per_line = argc > 2 ? atoi(argv[2]) : 100;
+   int layout, s, statements, mismatches = 0;
+   struct corpus_options opt;
+   struct result r[SCHEMES], eval;
+   char *input, *p;
+   size_t length;
+   double megabytes;
+
+   corpus_defaults(&opt);
+   opt.statements = count;
+   if ((input = gen_corpus_with(&opt, &length)) == NULL) {
+      fprintf(stderr, "ERROR: out of memory\n");
+      return 1;
+   }
+   megabytes = length / 1048576.0;
+   for (layout = 0; layout < 2; layout++) {
+      if (layout == 1) {
+         // Join the statements into lines of per_line each
+         for (p = input, statements = 0; (p = strchr(p, '\n')) != NULL; p++) {
+            if (++statements % (per_line > 0 ? per_line : 1) != 0)
+               *p = ' ';
+         }
+         printf("%.1f MB, %d statements per line\n", megabytes, per_line);
+      } else {
+         printf("%.1f MB, one statement per line\n", megabytes);
+      }
+      for (s = 0; s < SCHEMES; s++)
+         r[s] = lex_all(input, length, s);
+      for (s = 0; s < SCHEMES; s++) {
+         print(scheme_names[s], &r[s], megabytes);
+         mismatches += r[s].checksum != r[DESCRIPTOR].checksum;
+      }
+      eval = eval_all(input);
+      print("bexpr", &eval, megabytes);
+   }
+   free(input);
+   printf("%d mismatches\n", mismatches);
+   return mismatches != 0;
+}
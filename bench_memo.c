@@ -0,0 +1,148 @@
+/*
+ * bench_memo.c - evaluates a skewed stream of repeated statements, half
+ * of them respaced, directly and through the memo cache at several
+ * memory caps, on several threads, and reports hit rate and evictions.
+ *
+ * Build: make bench_memo
+ * Usage: bench_memo [distinct] [lookups] [threads]
+ * Date:  2025 May 4
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include "corpus.h"
+#include "parallel.h"
+#include "parser.h"
+#include "memo.h"
+
+struct run {
+   char **stream;          // statements to evaluate, in order
+   struct eval_result *results;
+   int first, last;
+   struct memo_cache *memo;   // NULL to call bexpr() directly
+};
+
+static double now(void) {
+   struct timespec ts;
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void *evaluate(void *arg) {
+   struct run *run = arg;
+   struct parser_state ps;
+   int i;
+
+   for (i = run->first; i < run->last; i++) {
+      if (run->memo != NULL) {
+         run->results[i] = memo_bexpr(run->memo, run->stream[i]);
+      } else {
+         parser_init(&ps, run->stream[i]);
+         run->results[i] = bexpr(&ps);
+      }
+   }
+   return NULL;
+}
+
+// Evaluates the whole stream on threads and returns the seconds it took
+static double time_stream(char **stream, struct eval_result *results, int count, int threads,
+                          struct memo_cache *memo) {
+   pthread_t ids[64];
+   struct run runs[64];
+   double start = now();
+   int t;
+
+   for (t = 0; t < threads; t++) {
+      runs[t] = (struct run) { stream, results, (long) count * t / threads,
+                               (long) count * (t + 1) / threads, memo };
+      pthread_create(&ids[t], NULL, evaluate, &runs[t]);
+   }
+   for (t = 0; t < threads; t++)
+      pthread_join(ids[t], NULL);
+   return now() - start;
+}
+
+// Copies a statement with every blank doubled
+static char *respace(const char *stmt) {
+   char *copy = malloc(2 * strlen(stmt) + 1), *out = copy;
+   for (; *stmt != '\0'; stmt++) {
+      *out++ = *stmt;
+      if (*stmt == ' ')
+         *out++ = ' ';
+   }
+   *out = '\0';
+   return copy;
+}
+
+int main(int argc, char *argv[]) {
+   int distinct = argc > 1 ? atoi(argv[1]) : 100000;
+   int lookups = argc > 2 ? atoi(argv[2]) : 2000000;
+   int threads = argc > 3 ? atoi(argv[3]) : 4;
+   size_t caps[] = { 1 << 20, 4 << 20, 64 << 20 };
+   struct statement_batch batch;
+   struct memo_cache memo;
+   struct memo_stats stats;
+   char *input, **respaced, **stream;
+   struct eval_result *direct, *cached;
+   int i, c, mismatches;
+   size_t length;
+   double secs;
+
+   if (threads > 64)
+      threads = 64;
+   srand(352);
+   input = gen_corpus(distinct, &length);
+   stream = malloc(lookups * sizeof(char *));
+   direct = malloc(lookups * sizeof(struct eval_result));
+   cached = malloc(lookups * sizeof(struct eval_result));
+   if (input == NULL || batch_split(&batch, input, length) < 0 || stream == NULL
+       || direct == NULL || cached == NULL
+       || (respaced = malloc(batch.count * sizeof(char *))) == NULL) {
+      fprintf(stderr, "ERROR: out of memory\n");
+      return 1;
+   }
+   for (i = 0; i < batch.count; i++)
+      respaced[i] = respace(batch.stmts[i]);
+
+   // u^3 puts most lookups on a few statements and leaves a long tail
+   for (i = 0; i < lookups; i++) {
+      double u = (double) rand() / RAND_MAX;
+      int pick = (int) (u * u * u * (batch.count - 1));
+      stream[i] = rand() & 1 ? respaced[pick] : batch.stmts[pick];
+   }
+
+   secs = time_stream(stream, direct, lookups, threads, NULL);
+   printf("%d lookups of %d statements on %d threads\n", lookups, batch.count, threads);
+   printf("direct bexpr()          %8.2f M/s\n", lookups / secs / 1e6);
+
+   for (c = 0; c < (int) (sizeof(caps) / sizeof(caps[0])); c++) {
+      if (!memo_init(&memo, caps[c], 0)) {
+         fprintf(stderr, "ERROR: out of memory\n");
+         return 1;
+      }
+      secs = time_stream(stream, cached, lookups, threads, &memo);
+      memo_stats(&memo, &stats);
+      for (i = 0, mismatches = 0; i < lookups; i++)
+         mismatches += cached[i].status != direct[i].status
+                       || cached[i].value != direct[i].value;
+      printf("memo, %3zu MB cap        %8.2f M/s, %5.1f%% hits, %8llu evictions, "
+             "%7zu entries, %d mismatches\n",
+             caps[c] >> 20, lookups / secs / 1e6,
+             100.0 * stats.hits / (stats.hits + stats.misses),
+             (unsigned long long) stats.evictions, stats.entries, mismatches);
+      memo_free(&memo);
+   }
+
+   for (i = 0; i < batch.count; i++)
+      free(respaced[i]);
+   free(respaced);
+   batch_free(&batch);
+   free(input);
+   free(stream);
+   free(direct);
+   free(cached);
+   return 0;
+}
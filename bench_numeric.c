@@ -0,0 +1,185 @@
+/*
+ * bench_numeric.c - times num_bexpr() in the number type it was built
+ * with against bexpr() on ordinary statements, then on exponent-heavy
+ * ones, and for the bignum build, Karatsuba against schoolbook multiply.
+ *
+ * Build: make bench_numeric, or bench_numeric_int64 or bench_numeric_bignum
+ *        for the other backends of value.h
+ * Usage: bench_numeric [statements]
+ * Date:  2025 May 5
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <limits.h>
+#include <time.h>
+#include "corpus.h"
+#include "parallel.h"
+#include "numeric.h"
+
+static double now(void) {
+   struct timespec ts;
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// Statements whose powers overflow 64 bits long before they finish
+static char heavy[][64] = {
+   "3 ^ 5000 / 7 ^ 2000 - 11 ^ 1000;",
+   "(2 ^ 4096 - 1) / (2 ^ 2048 + 1);",
+   "12345 ^ 789 > 9876 ^ 800;",
+   "(7 ^ 3000 + 1) * (13 ^ 2500 - 1) / 17 ^ 1000;",
+};
+
+/*
+ * Statements that fail in the int build exactly as they do in bexpr(),
+ * at the same offset, leaving the parser at the same place
+ */
+static char failing[][64] = {
+   "1 / 0; 1;",
+   "(0 - 2147483647 - 1) / (0 - 1); 1;",
+   "7 + (0 - 2147483647 - 1) / (2 - 3); 1;",
+   "(1 + 2; 1;",
+   "3 4; 1;",
+};
+
+int main(int argc, char *argv[]) {
+   int count = argc > 1 ? atoi(argv[1]) : 200000;
+   struct statement_batch batch;
+   struct parser_state ps;
+   value_t value;
+   char *input;
+   size_t length;
+   double start, direct, numeric;
+   int i, errors = 0, mismatches = 0, failed = 0;
+   volatile int sink;
+
+   srand(352);
+   input = gen_corpus(count, &length);
+   if (input == NULL || batch_split(&batch, input, length) < 0) {
+      fprintf(stderr, "ERROR: out of memory\n");
+      return 1;
+   }
+
+   start = now();
+   for (i = 0; i < batch.count; i++) {
+      parser_init(&ps, batch.stmts[i]);
+      batch.results[i] = bexpr(&ps);
+   }
+   direct = now() - start;
+
+   // overflow messages from the checked backends would swamp the output
+   freopen("/dev/null", "w", stderr);
+   val_init(&value);
+   start = now();
+   for (i = 0; i < batch.count; i++) {
+      parser_init(&ps, batch.stmts[i]);
+      if (num_bexpr(&ps, &value) != PARSE_OK) {
+         errors++;
+         continue;
+      }
+#if defined(VALUE_BIGNUM) || defined(VALUE_INT64)
+      sink = val_is_zero(&value);
+#else
+      if (batch.results[i].status == PARSE_OK && value != batch.results[i].value)
+         mismatches++;
+#endif
+   }
+   numeric = now() - start;
+
+   printf("backend %s, %d statements\n", VALUE_NAME, batch.count);
+   printf("bexpr()          %8.2f M stmts/s\n", batch.count / direct / 1e6);
+   printf("num_bexpr()      %8.2f M stmts/s, %d errors, %d mismatches\n",
+          batch.count / numeric / 1e6, errors, mismatches);
+
+   for (i = 0; i < (int) (sizeof(failing) / sizeof(failing[0])); i++) {
+      struct error_log log, expected_log;
+      struct eval_result result;
+      enum parse_status status;
+      size_t offset, next, expected_offset;
+
+      error_log_init(&log);
+      parser_init(&ps, failing[i]);
+      ps.errors = &log;
+      status = num_bexpr(&ps, &value);
+      offset = log.count ? log.errors[0].offset : 0;
+      next = token_offset(&ps);
+      error_log_free(&log);
+
+      error_log_init(&expected_log);
+      parser_init(&ps, failing[i]);
+      ps.errors = &expected_log;
+      result = bexpr(&ps);
+      expected_offset = expected_log.count ? expected_log.errors[0].offset : 0;
+      error_log_free(&expected_log);
+#if defined(VALUE_BIGNUM) || defined(VALUE_INT64)
+      // Only a division by zero or a syntax error fails in the wider backends
+      if (result.status != PARSE_DIVIDE_BY_ZERO && result.status != PARSE_SYNTAX_ERROR) {
+         result.status = PARSE_OK;
+         expected_offset = 0;
+      }
+#endif
+      if (status != result.status || offset != expected_offset || next != token_offset(&ps))
+         failed++;
+   }
+   printf("%d statements that fail, %d mismatches\n",
+          (int) (sizeof(failing) / sizeof(failing[0])), failed);
+
+   for (i = 0; i < (int) (sizeof(heavy) / sizeof(heavy[0])); i++) {
+      int r, repeats = 20;
+      bool ok = true;
+      start = now();
+      for (r = 0; r < repeats && ok; r++) {
+         parser_init(&ps, heavy[i]);
+         ok = num_bexpr(&ps, &value) == PARSE_OK;
+      }
+      if (ok)
+         printf("%-46s %8.1f us\n", heavy[i], (now() - start) / repeats * 1e6);
+      else
+         printf("%-46s out of range\n", heavy[i]);
+   }
+   val_free(&value);
+
+#ifdef VALUE_BIGNUM
+   {
+      struct bignum a, b, product;
+      int limbs, r, repeats, saved = karatsuba_limbs;
+      double school, karatsuba;
+
+      big_init(&a);
+      big_init(&b);
+      big_init(&product);
+      for (limbs = 64; limbs <= 4096; limbs *= 4) {
+         char digits[40000];
+         for (i = 0; i < limbs * 9; i++)
+            digits[i] = '1' + rand() % 9;
+         big_digits(&a, digits, limbs * 9);
+         big_digits(&b, digits + limbs, limbs * 8);
+         repeats = 4096 / limbs * 16;
+
+         karatsuba_limbs = INT_MAX;
+         start = now();
+         for (r = 0; r < repeats; r++)
+            big_mul(&product, &a, &b);
+         school = (now() - start) / repeats;
+
+         karatsuba_limbs = saved;
+         start = now();
+         for (r = 0; r < repeats; r++)
+            big_mul(&product, &a, &b);
+         karatsuba = (now() - start) / repeats;
+
+         printf("multiply %4d limbs  schoolbook %9.1f us  karatsuba %9.1f us  (%.2fx)\n",
+                a.length, school * 1e6, karatsuba * 1e6, school / karatsuba);
+      }
+      big_free(&a);
+      big_free(&b);
+      big_free(&product);
+   }
+#endif
+
+   (void) sink;
+   batch_free(&batch);
+   free(input);
+   return mismatches + failed != 0;
+}
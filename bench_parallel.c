@@ -0,0 +1,52 @@
+/*
+ * bench_parallel.c - measures how batch_eval() scales with the number of
+ * threads on a generated stream of statements.
+ *
+ * Build: make bench_parallel
+ * Usage: bench_parallel [statements] [max_threads]
+ * Date:  2025 April 24
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+#include "corpus.h"
+#include "parallel.h"
+
+static double now(void) {
+   struct timespec ts;
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+int main(int argc, char *argv[]) {
+   int count = argc > 1 ? atoi(argv[1]) : 1000000;
+   int max_threads = argc > 2 ? atoi(argv[2]) : (int) sysconf(_SC_NPROCESSORS_ONLN);
+   struct statement_batch batch;
+   char *input;
+   size_t length;
+   double base = 0, start, secs;
+   int threads;
+
+   srand(352);
+   input = gen_corpus(count, &length);
+   if (input == NULL || batch_split(&batch, input, length) < 0) {
+      fprintf(stderr, "ERROR: out of memory\n");
+      return 1;
+   }
+   printf("%d statements, %.1f MB\n", batch.count, length / 1e6);
+   printf("threads  statements/sec  speedup\n");
+   for (threads = 1; threads <= max_threads; threads *= 2) {
+      start = now();
+      batch_eval(&batch, threads);
+      secs = now() - start;
+      if (threads == 1)
+         base = secs;
+      printf("%7d  %14.0f  %7.2f\n", threads, batch.count / secs, base / secs);
+   }
+
+   batch_free(&batch);
+   free(input);
+   return 0;
+}
@@ -0,0 +1,146 @@
+/*
+ * bench_scan.c - checks every SIMD kernel in scan.c against its scalar
+ * version on random input, then measures each kernel at each level this
+ * CPU supports. Exits non-zero if any kernel disagrees with the scalar
+ * version.
+ *
+ * Build: make bench_scan
+ * Usage: bench_scan [megabytes]
+ * Date:  2025 April 30
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "scan.h"
+
+// Random cases checked per level
+#define CASES 200000
+
+static const char *level_names[] = { "scalar", "sse2", "avx2" };
+
+static double now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/**
+ * Fills buf with bytes drawn from alphabet, favouring long runs.
+ */
+static void fill(char *buf, int length, const char *alphabet) {
+    int n = (int) strlen(alphabet), i;
+
+    for (i = 0; i < length; i++)
+        buf[i] = (i > 0 && rand() % 8 != 0) ? buf[i - 1] : alphabet[rand() % n];
+}
+
+/**
+ * Compares every kernel at the given level with the scalar kernels.
+ * @return: the number of disagreements
+ */
+static int check(enum scan_level level) {
+    char buf[256], *start, *end, *ref_stop, *stop, *ref_line, *line;
+    int c, length, ref_nl, nl, ref_value, value, failures = 0;
+
+    for (c = 0; c < CASES; c++) {
+        length = rand() % 200;
+        fill(buf, length, c % 2 ? " \t\n" : " \t\nx");
+        start = buf + rand() % (length + 1);
+        end = buf + length;
+
+        scan_select(SCAN_SCALAR);
+        ref_nl = 0;
+        ref_line = NULL;
+        ref_stop = skip_space(start, end, &ref_nl, &ref_line);
+        scan_select(level);
+        nl = 0;
+        line = NULL;
+        stop = skip_space(start, end, &nl, &line);
+        if (stop != ref_stop || nl != ref_nl || line != ref_line)
+            failures++;
+
+        fill(buf, length, c % 2 ? "0123456789" : "0123456789;");
+        scan_select(SCAN_SCALAR);
+        ref_stop = skip_digits(start, end);
+        scan_select(level);
+        if (skip_digits(start, end) != ref_stop)
+            failures++;
+
+        length = ref_stop - start;
+        scan_select(SCAN_SCALAR);
+        ref_value = parse_digits(start, length);
+        scan_select(level);
+        value = parse_digits(start, length);
+        if (value != ref_value)
+            failures++;
+    }
+    return failures;
+}
+
+int main(int argc, char *argv[]) {
+    size_t size = (size_t) ((argc > 1 ? atof(argv[1]) : 64) * 1e6), i;
+    char *space = malloc(size + 1), *digits = malloc(size + 1), *p, *line;
+    int level, top, failures = 0, newlines, count;
+    volatile int sink = 0;
+    double start, secs;
+
+    if (space == NULL || digits == NULL) {
+        fprintf(stderr, "ERROR: out of memory\n");
+        return 1;
+    }
+    srand(352);
+    top = scan_select(SCAN_AVX2);
+
+    for (level = SCAN_SSE2; level <= top; level++) {
+        int f = check(level);
+        printf("%-6s %d of %d random cases disagree with scalar\n",
+               level_names[level], f, CASES * 3);
+        failures += f;
+    }
+
+    // 255 bytes of padding between lexemes, and 40-digit literals
+    for (i = 0; i < size; i++) {
+        space[i] = (i % 256 == 255) ? 'x' : (i % 64 == 63 ? '\n' : ' ');
+        digits[i] = (i % 41 == 40) ? ';' : (char) ('0' + i % 10);
+    }
+    space[size] = digits[size] = '\0';
+
+    printf("kernel        level   GB/s or M/s\n");
+    for (level = SCAN_SCALAR; level <= top; level++) {
+        scan_select(level);
+
+        newlines = 0;
+        start = now();
+        for (p = space; p < space + size; p++)
+            p = skip_space(p, space + size, &newlines, &line);
+        secs = now() - start;
+        printf("skip_space    %-6s  %6.2f GB/s\n", level_names[level], size / secs / 1e9);
+
+        start = now();
+        for (p = digits; p < digits + size; p++)
+            p = skip_digits(p, digits + size);
+        secs = now() - start;
+        printf("skip_digits   %-6s  %6.2f GB/s\n", level_names[level], size / secs / 1e9);
+
+        count = 0;
+        start = now();
+        for (p = digits; p + 18 < digits + size; p += 41, count++)
+            sink += parse_digits(p, 18);
+        secs = now() - start;
+        printf("parse_digits  %-6s  %6.1f M/s (18 digits)\n", level_names[level], count / secs / 1e6);
+
+        count = 0;
+        start = now();
+        for (p = digits; p + 9 < digits + size; p += 41, count++)
+            sink += parse_digits(p, 9);
+        secs = now() - start;
+        printf("parse_digits  %-6s  %6.1f M/s (9 digits)\n", level_names[level], count / secs / 1e6);
+    }
+
+    (void) sink;
+    free(space);
+    free(digits);
+    return failures != 0;
+}
@@ -0,0 +1,357 @@
+/*
+ * bench_server.c - latency and throughput of the evaluator daemon
+ * against a process started per request. The daemon runs in a child
+ * process; client threads each send requests of the same statements,
+ * first waiting for each reply before the next request, then with every
+ * request written ahead of its replies. The baseline has as many
+ * threads start a process per request, which reads the request on stdin
+ * and writes the replies to stdout as "server -" does. Every reply is
+ * checked against bexpr().
+ *
+ * Build: make bench_server
+ * Usage: bench_server [requests] [statements] [clients] [server]
+ *        server is a server binary to exec per request; without it each
+ *        request forks a copy of this program instead
+ * Date:  2025 May 12
+ */
+
+#define _GNU_SOURCE   // for pipe2()
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include "corpus.h"
+#include "parser.h"
+#include "server.h"
+
+// Statements that fail, so error replies are checked too
+#define ERROR_STATEMENTS "1 / 0;\n2 ^ 99;\n(1 + ;\n"
+
+static const char *status_words[] = {
+   "ok", "syntax", "overflow", "divide-by-zero", "out-of-memory"
+};
+
+static char socket_path[108];
+static const char *server;         // binary to exec per request, or NULL to fork
+static char *request, *expected;   // one request and the replies it should get
+static size_t request_length, expected_length;
+static int expected_lines;
+
+struct client_args {
+   int requests;
+   double *latency;     // per request, or NULL when pipelined
+   int mismatches;
+};
+
+static double now(void) {
+   struct timespec ts;
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static int by_value(const void *a, const void *b) {
+   double x = *(const double *) a, y = *(const double *) b;
+   return (x > y) - (x < y);
+}
+
+static double percentile(const double *sorted, int count, double fraction) {
+   int i = (int) (fraction * count);
+   return sorted[i < count ? i : count - 1];
+}
+
+static bool write_all_fd(int fd, const char *data, size_t length) {
+   while (length > 0) {
+      ssize_t n = write(fd, data, length);
+      if (n < 0 && errno == EINTR)
+         continue;
+      if (n <= 0)
+         return false;
+      data += n;
+      length -= n;
+   }
+   return true;
+}
+
+// The replies the daemon should send to the request, from bexpr()
+static void expect(void) {
+   struct parser_state ps;
+   struct error_log log;
+   struct eval_result r;
+   char *out;
+
+   expected = out = malloc(request_length * 4 + 64);
+   error_log_init(&log);
+   parser_init(&ps, request);
+   ps.errors = &log;
+   while (ps.lex.kind != END_OF_INPUT) {
+      r = bexpr(&ps);
+      out += r.status == PARSE_OK ? sprintf(out, "ok %d\n", r.value)
+                                  : sprintf(out, "error %s\n", status_words[r.status]);
+      expected_lines++;
+   }
+   expected_length = out - expected;
+   error_log_free(&log);
+}
+
+static int connect_daemon(void) {
+   struct sockaddr_un addr;
+   int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+
+   memset(&addr, 0, sizeof(addr));
+   addr.sun_family = AF_UNIX;
+   strcpy(addr.sun_path, socket_path);
+   if (fd < 0 || connect(fd, (struct sockaddr *) &addr, sizeof(addr)) != 0) {
+      perror("connect");
+      exit(1);
+   }
+   return fd;
+}
+
+/**
+ * Reads the replies to one request into reply, which has room for
+ * twice the expected replies.
+ * @return: whether they are the expected ones
+ */
+static bool read_replies(int fd, char *reply) {
+   size_t used = 0;
+   int lines = 0;
+   ssize_t n;
+
+   while (lines < expected_lines && used < 2 * expected_length) {
+      if ((n = read(fd, reply + used, 2 * expected_length - used)) <= 0)
+         return false;
+      for (ssize_t i = 0; i < n; i++)
+         lines += reply[used + i] == '\n';
+      used += n;
+   }
+   return used == expected_length && memcmp(reply, expected, used) == 0;
+}
+
+// One connection; each request waits for its replies
+static void *round_trips(void *arg) {
+   struct client_args *args = arg;
+   char *reply = malloc(2 * expected_length);
+   int fd = connect_daemon(), r;
+   double start;
+
+   for (r = 0; r < args->requests; r++) {
+      start = now();
+      if (!write_all_fd(fd, request, request_length) || !read_replies(fd, reply)) {
+         args->mismatches++;
+         break;
+      }
+      args->latency[r] = (now() - start) * 1e6;
+   }
+   close(fd);
+   free(reply);
+   return NULL;
+}
+
+// One connection; requests are written while the replies come back
+static void *pipelined(void *arg) {
+   struct client_args *args = arg;
+   size_t total = (size_t) args->requests * request_length, sent = 0;
+   size_t replies = (size_t) args->requests * expected_length, received = 0;
+   char buffer[65536];
+   struct pollfd pfd;
+   int fd = connect_daemon();
+   ssize_t n;
+
+   pfd.fd = fd;
+   while (received < replies) {
+      pfd.events = POLLIN | (sent < total ? POLLOUT : 0);
+      if (poll(&pfd, 1, -1) < 0)
+         continue;
+      if ((pfd.revents & POLLOUT) && sent < total) {
+         size_t at = sent % request_length;
+         if ((n = send(fd, request + at, request_length - at, MSG_DONTWAIT)) > 0)
+            sent += n;
+      }
+      if (pfd.revents & (POLLIN | POLLHUP)) {
+         if ((n = recv(fd, buffer, sizeof(buffer), MSG_DONTWAIT)) <= 0) {
+            if (n == 0 || (errno != EAGAIN && errno != EINTR))
+               break;
+            continue;
+         }
+         for (ssize_t i = 0; i < n; i++, received++) {
+            if (buffer[i] != expected[received % expected_length])
+               args->mismatches++;
+         }
+      }
+   }
+   if (received != replies)
+      args->mismatches++;
+   close(fd);
+   return NULL;
+}
+
+/**
+ * Runs clients threads of the given kind, each making requests.
+ * @return: statements per second over all of them
+ */
+static double run_clients(void *(*kind)(void *), int clients, int requests,
+                          double *latency, int *mismatches) {
+   pthread_t *ids = malloc(clients * sizeof(pthread_t));
+   struct client_args *args = calloc(clients, sizeof(struct client_args));
+   double start = now(), secs;
+   int i;
+
+   for (i = 0; i < clients; i++) {
+      args[i].requests = requests / clients;
+      args[i].latency = latency != NULL ? latency + i * (requests / clients) : NULL;
+      pthread_create(&ids[i], NULL, kind, &args[i]);
+   }
+   for (i = 0; i < clients; i++) {
+      pthread_join(ids[i], NULL);
+      *mismatches += args[i].mismatches;
+   }
+   secs = now() - start;
+   free(ids);
+   free(args);
+   return (double) (requests / clients) * clients * expected_lines / secs;
+}
+
+/**
+ * Serves one request with a new process.
+ * @return: whether its replies were the expected ones
+ */
+static bool fork_request(char *reply) {
+   int in[2], out[2], status;
+   size_t used = 0;
+   ssize_t n;
+   pid_t pid;
+
+   // close-on-exec, since other threads fork while these are open
+   if (pipe2(in, O_CLOEXEC) != 0 || pipe2(out, O_CLOEXEC) != 0 || (pid = fork()) < 0)
+      return false;
+   if (pid == 0) {
+      dup2(in[0], STDIN_FILENO);
+      dup2(out[1], STDOUT_FILENO);
+      if (server != NULL) {
+         execl(server, server, "-", (char *) NULL);
+         _exit(127);
+      }
+      // without an exec, the pipes of other requests have to be closed here
+      for (int fd = STDERR_FILENO + 1; fd < 1024; fd++)
+         close(fd);
+      _exit(server_oneshot(STDIN_FILENO, STDOUT_FILENO) == 0 ? 0 : 1);
+   }
+   close(in[0]);
+   close(out[1]);
+   write_all_fd(in[1], request, request_length);
+   close(in[1]);
+   while (used < 2 * expected_length && (n = read(out[0], reply + used, 2 * expected_length - used)) > 0)
+      used += n;
+   close(out[0]);
+   waitpid(pid, &status, 0);
+   return WIFEXITED(status) && WEXITSTATUS(status) == 0 && used == expected_length
+          && memcmp(reply, expected, used) == 0;
+}
+
+// A process per request
+static void *forks(void *arg) {
+   struct client_args *args = arg;
+   char *reply = malloc(2 * expected_length);
+   double start;
+   int r;
+
+   for (r = 0; r < args->requests; r++) {
+      start = now();
+      if (!fork_request(reply))
+         args->mismatches++;
+      args->latency[r] = (now() - start) * 1e6;
+   }
+   free(reply);
+   return NULL;
+}
+
+static void report(const char *name, double *latency, int count, double rate) {
+   qsort(latency, count, sizeof(double), by_value);
+   printf("%-26s p50 %8.1f us  p99 %8.1f us  %8.3f M stmts/s\n", name,
+          percentile(latency, count, 0.5), percentile(latency, count, 0.99), rate / 1e6);
+}
+
+static volatile sig_atomic_t stopping;
+
+static void on_stop(int sig) {
+   (void) sig;
+   stopping = 1;
+}
+
+int main(int argc, char *argv[]) {
+   int requests = argc > 1 ? atoi(argv[1]) : 20000;
+   int statements = argc > 2 ? atoi(argv[2]) : 100;
+   int clients = argc > 3 ? atoi(argv[3]) : 4;
+   int forked, mismatches = 0, listen_fd;
+   struct corpus_options opt;
+   struct sigaction sa;
+   double *latency, daemon_rate, pipelined_rate, fork_rate, p50_daemon;
+   char *corpus;
+   size_t length;
+   pid_t daemon;
+
+   if (clients < 1 || requests < clients || statements < 1) {
+      fprintf(stderr, "Usage: %s [requests] [statements] [clients] [server]\n", argv[0]);
+      return 2;
+   }
+   requests -= requests % clients;
+   forked = requests < 2000 ? requests : 2000 - 2000 % clients;
+   server = argc > 4 ? argv[4] : NULL;
+   corpus_defaults(&opt);
+   opt.statements = statements;
+   corpus = gen_corpus_with(&opt, &length);
+   request = malloc(length + sizeof(ERROR_STATEMENTS));
+   latency = malloc(requests * sizeof(double));
+   if (corpus == NULL || request == NULL || latency == NULL) {
+      fprintf(stderr, "ERROR: out of memory\n");
+      return 1;
+   }
+   memcpy(request, corpus, length);
+   memcpy(request + length, ERROR_STATEMENTS, sizeof(ERROR_STATEMENTS));
+   request_length = length + sizeof(ERROR_STATEMENTS) - 1;
+   free(corpus);
+   expect();
+   printf("request: %d statements, %zu bytes\n", expected_lines, request_length);
+
+   snprintf(socket_path, sizeof(socket_path), "/tmp/bench_server.%d.sock", (int) getpid());
+   if ((listen_fd = server_listen(socket_path)) < 0)
+      return 1;
+   if ((daemon = fork()) == 0) {
+      memset(&sa, 0, sizeof(sa));
+      sa.sa_handler = on_stop;
+      sigemptyset(&sa.sa_mask);
+      sigaction(SIGTERM, &sa, NULL);
+      _exit(server_run(listen_fd, (int) sysconf(_SC_NPROCESSORS_ONLN), &stopping, NULL) == 0 ? 0 : 1);
+   }
+   close(listen_fd);
+
+   daemon_rate = run_clients(round_trips, clients, requests, latency, &mismatches);
+   report("daemon, round trips", latency, requests, daemon_rate);
+   p50_daemon = percentile(latency, requests, 0.5);
+   pipelined_rate = run_clients(pipelined, clients, requests, NULL, &mismatches);
+   printf("%-26s %42.3f M stmts/s\n", "daemon, pipelined", pipelined_rate / 1e6);
+   kill(daemon, SIGTERM);
+   waitpid(daemon, NULL, 0);
+   unlink(socket_path);
+
+   fork_rate = run_clients(forks, clients, forked, latency, &mismatches);
+   report(server != NULL ? "fork and exec per request" : "fork per request", latency, forked,
+          fork_rate);
+   printf("%d clients: daemon round trips %.1fx the throughput, %.1fx lower p50 latency\n",
+          clients, daemon_rate / fork_rate, percentile(latency, forked, 0.5) / p50_daemon);
+   printf("%d mismatches\n", mismatches);
+
+   free(request);
+   free(expected);
+   free(latency);
+   return mismatches != 0;
+}
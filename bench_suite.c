@@ -0,0 +1,186 @@
+/*
+ * bench_suite.c - the benchmark to run between versions. Generates a
+ * corpus with gen_corpus_with() from the knobs on the command line, then
+ * measures tokenizer throughput, bexpr() throughput and the latency of
+ * each statement, and writes the results as one JSON object on stdout.
+ * A checksum of the values is included, so a run that got faster by
+ * computing something else shows up too.
+ *
+ * Build: make bench_suite
+ * Usage: bench_suite [seed=N] [statements=N] [terms=N] [depth=N]
+ *        [mix=add,mul,div,pow,compare] [digits=N] [spaces=PERCENT]
+ *        [repeats=N]
+ * Date:  2025 May 9
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "corpus.h"
+#include "parser.h"
+#include "scan.h"
+
+static const char *mix_names[CORPUS_OPS] = { "add", "mul", "div", "pow", "compare" };
+
+static double now(void) {
+   struct timespec ts;
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/**
+ * Reads one name=value argument into the options.
+ * @return: false if the argument is not one of the knobs
+ */
+static bool parse_knob(const char *arg, struct corpus_options *opt, int *repeats) {
+   const char *value = strchr(arg, '=');
+   size_t name = value != NULL ? (size_t) (value - arg) : 0;
+
+   if (value == NULL)
+      return false;
+   value++;
+   if (strncmp(arg, "seed", name) == 0 && name == 4)
+      opt->seed = strtoull(value, NULL, 10);
+   else if (strncmp(arg, "statements", name) == 0 && name == 10)
+      opt->statements = atoi(value);
+   else if (strncmp(arg, "terms", name) == 0 && name == 5)
+      opt->terms = atoi(value);
+   else if (strncmp(arg, "depth", name) == 0 && name == 5)
+      opt->depth = atoi(value);
+   else if (strncmp(arg, "digits", name) == 0 && name == 6)
+      opt->digits = atoi(value);
+   else if (strncmp(arg, "spaces", name) == 0 && name == 6)
+      opt->spaces = atoi(value);
+   else if (strncmp(arg, "repeats", name) == 0 && name == 7)
+      *repeats = atoi(value);
+   else if (strncmp(arg, "mix", name) == 0 && name == 3)
+      return sscanf(value, "%d,%d,%d,%d,%d", &opt->mix[0], &opt->mix[1], &opt->mix[2],
+                    &opt->mix[3], &opt->mix[4]) == CORPUS_OPS;
+   else
+      return false;
+   return true;
+}
+
+/**
+ * Lexes the whole input once, skipping whitespace as next_token() does,
+ * without the token report.
+ * @return: the number of tokens
+ */
+static long lex_all(char *input, size_t length) {
+   struct lexer_state lex;
+   long tokens = 0;
+   int lines = 0;
+
+   lex.line = lex.line_start = input;
+   lex.end = input + length;
+   for (;;) {
+      lex.line = skip_space(lex.line, lex.end, &lines, &lex.line_start);
+      if (lex.line == lex.end)
+         return tokens;
+      scan_token(&lex);
+      tokens++;
+   }
+}
+
+static int by_value(const void *a, const void *b) {
+   double x = *(const double *) a, y = *(const double *) b;
+   return (x > y) - (x < y);
+}
+
+// The value below which the given fraction of the sorted samples fall
+static double percentile(const double *sorted, int count, double fraction) {
+   int i = (int) (fraction * count);
+   return sorted[i < count ? i : count - 1];
+}
+
+int main(int argc, char *argv[]) {
+   struct corpus_options opt;
+   struct parser_state ps;
+   struct eval_result result;
+   struct error_log log;
+   char *input;
+   size_t length;
+   double start, best_lex = 1e30, best_eval = 1e30, secs, sum = 0, *latency;
+   long tokens = 0;
+   unsigned long checksum = 0;
+   int repeats = 5, r, i, statements, errors = 0;
+
+   corpus_defaults(&opt);
+   for (i = 1; i < argc; i++) {
+      if (!parse_knob(argv[i], &opt, &repeats)) {
+         fprintf(stderr, "Usage: %s [seed=N] [statements=N] [terms=N] [depth=N]"
+                 " [mix=add,mul,div,pow,compare] [digits=N] [spaces=PERCENT] [repeats=N]\n",
+                 argv[0]);
+         return 2;
+      }
+   }
+   if (repeats < 1)
+      repeats = 1;
+   if (opt.statements < 0)
+      opt.statements = 0;
+   if ((input = gen_corpus_with(&opt, &length)) == NULL
+       || (latency = malloc((opt.statements > 0 ? opt.statements : 1) * sizeof(double))) == NULL) {
+      fprintf(stderr, "ERROR: out of memory\n");
+      return 1;
+   }
+   statements = opt.statements;
+
+   // best of repeats, since the fastest run is the one least disturbed
+   for (r = 0; r < repeats; r++) {
+      start = now();
+      tokens = lex_all(input, length);
+      if ((secs = now() - start) < best_lex)
+         best_lex = secs;
+   }
+   error_log_init(&log);
+   for (r = 0; r < repeats; r++) {
+      parser_init(&ps, input);
+      ps.errors = &log;
+      start = now();
+      for (i = 0; i < statements; i++)
+         bexpr(&ps);
+      if ((secs = now() - start) < best_eval)
+         best_eval = secs;
+   }
+
+   // one more pass timing each statement on its own, which also checks them
+   parser_init(&ps, input);
+   ps.errors = &log;
+   for (i = 0; i < statements; i++) {
+      start = now();
+      result = bexpr(&ps);
+      latency[i] = (now() - start) * 1e9;
+      sum += latency[i];
+      checksum = checksum * 31 + (unsigned int) result.value;
+      errors += result.status != PARSE_OK;
+   }
+   error_log_free(&log);
+   qsort(latency, statements, sizeof(double), by_value);
+
+   printf("{\n  \"benchmark\": \"bench_suite\",\n  \"options\": {\"seed\": %llu, \"statements\": %d,"
+          " \"terms\": %d, \"depth\": %d, \"digits\": %d, \"spaces\": %d, \"repeats\": %d,"
+          " \"mix\": {", opt.seed, opt.statements, opt.terms, opt.depth, opt.digits, opt.spaces,
+          repeats);
+   for (i = 0; i < CORPUS_OPS; i++)
+      printf("%s\"%s\": %d", i > 0 ? ", " : "", mix_names[i], opt.mix[i]);
+   printf("}},\n");
+   printf("  \"corpus\": {\"bytes\": %zu, \"tokens\": %ld, \"errors\": %d, \"checksum\": \"%016lx\"},\n",
+          length, tokens, errors, checksum);
+   printf("  \"tokenizer\": {\"seconds\": %.6f, \"mb_per_s\": %.2f, \"tokens_per_s\": %.0f},\n",
+          best_lex, length / best_lex / 1e6, tokens / best_lex);
+   printf("  \"eval\": {\"seconds\": %.6f, \"statements_per_s\": %.0f, \"mb_per_s\": %.2f},\n",
+          best_eval, statements / best_eval, length / best_eval / 1e6);
+   if (statements > 0) {
+      printf("  \"latency_ns\": {\"mean\": %.1f, \"p50\": %.1f, \"p90\": %.1f, \"p99\": %.1f,"
+             " \"p999\": %.1f, \"max\": %.1f}\n}\n",
+             sum / statements, percentile(latency, statements, 0.5),
+             percentile(latency, statements, 0.9), percentile(latency, statements, 0.99),
+             percentile(latency, statements, 0.999), latency[statements - 1]);
+   } else {
+      printf("  \"latency_ns\": null\n}\n");
+   }
+   free(latency);
+   free(input);
+   return errors != 0;
+}
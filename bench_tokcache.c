@@ -0,0 +1,117 @@
+/*
+ * bench_tokcache.c - compares re-lexing a corpus on every run against
+ * loading its cached binary token stream: stream size, load time, and
+ * the time to lex or decode and to parse all of it each way.
+ *
+ * Build: make bench_tokcache
+ * Usage: bench_tokcache [statements] [cache_file]
+ * Date:  2025 May 2
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "corpus.h"
+#include "parser.h"
+#include "tokcache.h"
+
+static double now(void) {
+   struct timespec ts;
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// Reads every token of an initialized parser and returns how many
+static long count_tokens(struct parser_state *ps) {
+   long count = 0;
+   while (ps->lex.kind != END_OF_INPUT) {
+      next_token(ps);
+      count++;
+   }
+   return count;
+}
+
+// Evaluates every statement; bexpr() skips past the ';' of any that fail
+static long parse_all(struct parser_state *ps) {
+   long sum = 0;
+   while (ps->lex.kind != END_OF_INPUT) {
+      struct eval_result result = bexpr(ps);
+      if (result.status == PARSE_OK)
+         sum += result.value;
+   }
+   return sum;
+}
+
+int main(int argc, char *argv[]) {
+   int count = argc > 1 ? atoi(argv[1]) : 1000000;
+   const char *path = argc > 2 ? argv[2] : "bench_tokcache.tks";
+   struct parser_state ps;
+   struct token_cache tc;
+   char *input;
+   size_t length;
+   double start, lexed, built, loaded, decoded, parsed, parsed_cached;
+   long tokens, cached_tokens, sum, cached_sum;
+
+   srand(352);
+   input = gen_corpus(count, &length);
+   if (input == NULL) {
+      fprintf(stderr, "ERROR: out of memory\n");
+      return 1;
+   }
+   remove(path);
+
+   start = now();
+   parser_init(&ps, input);
+   tokens = count_tokens(&ps);
+   lexed = now() - start;
+
+   start = now();
+   if (tokcache_open(&tc, path, input, length) != TOKCACHE_REBUILT) {
+      fprintf(stderr, "ERROR: could not build %s\n", path);
+      return 1;
+   }
+   built = now() - start;
+   tokcache_free(&tc);
+
+   start = now();
+   if (tokcache_open(&tc, path, input, length) != TOKCACHE_HIT) {
+      fprintf(stderr, "ERROR: %s was not reused\n", path);
+      return 1;
+   }
+   loaded = now() - start;
+
+   start = now();
+   parser_init_cached(&ps, input, &tc);
+   cached_tokens = count_tokens(&ps);
+   decoded = now() - start;
+
+   start = now();
+   parser_init(&ps, input);
+   sum = parse_all(&ps);
+   parsed = now() - start;
+
+   start = now();
+   parser_init_cached(&ps, input, &tc);
+   cached_sum = parse_all(&ps);
+   parsed_cached = now() - start;
+
+   printf("%.1f MB source, %ld tokens\n", length / 1e6, tokens);
+   printf("token stream  %8.1f MB (%.2f bytes/token, %.0f%% of source)\n",
+          tc.length / 1e6, (double) tc.length / tokens, 100.0 * tc.length / length);
+   printf("lex           %8.1f ms\n", lexed * 1e3);
+   printf("build + save  %8.1f ms\n", built * 1e3);
+   printf("load + check  %8.1f ms\n", loaded * 1e3);
+   printf("decode        %8.1f ms\n", decoded * 1e3);
+   printf("parse, lexed  %8.1f ms\n", parsed * 1e3);
+   printf("parse, cached %8.1f ms (%.2fx with the load)\n",
+          parsed_cached * 1e3, parsed / (loaded + parsed_cached));
+   if (tokens != cached_tokens || sum != cached_sum) {
+      printf("MISMATCH: %ld/%ld tokens, sums %ld/%ld\n", tokens, cached_tokens, sum, cached_sum);
+      return 1;
+   }
+
+   tokcache_free(&tc);
+   free(input);
+   remove(path);
+   return 0;
+}
@@ -0,0 +1,569 @@
+/*
+ * bignum.c - arbitrary-precision integers. Values that fit in 64 bits
+ * are kept inside the bignum and, as long as the result fits too, are
+ * added, subtracted, multiplied and divided as plain 64-bit integers, so
+ * ordinary expressions never allocate. Larger products use Karatsuba
+ * once both operands reach karatsuba_limbs limbs.
+ * Date:   2025 May 5
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "bignum.h"
+
+int karatsuba_limbs = 32;
+
+/**
+ * The limbs of a value, wherever they are stored.
+ */
+static inline uint32_t *limbs(struct bignum *v) {
+   return v->capacity > 0 ? v->heap : v->small;
+}
+
+static inline const uint32_t *climbs(const struct bignum *v) {
+   return v->capacity > 0 ? v->heap : v->small;
+}
+
+/**
+ * Sets a bignum to zero without allocating.
+ * @param v: the bignum to initialize
+ */
+void big_init(struct bignum *v) {
+   v->negative = false;
+   v->length = 0;
+   v->capacity = 0;
+   v->heap = NULL;
+}
+
+/**
+ * Frees a bignum's heap limbs, leaving it zero.
+ * @param v: the bignum to free
+ */
+void big_free(struct bignum *v) {
+   free(v->heap);
+   big_init(v);
+}
+
+/**
+ * Stores a magnitude and sign in v. mag must not be v's own limbs.
+ * @param v: the bignum to set
+ * @param mag: the magnitude, lowest limb first
+ * @param n: limbs in mag, possibly with zeros on top
+ * @param negative: the sign
+ * @return: false if out of memory
+ */
+static bool assign(struct bignum *v, const uint32_t *mag, int n, bool negative) {
+   while (n > 0 && mag[n - 1] == 0)
+      n--;
+   if (n > BIG_INLINE && n > v->capacity) {
+      uint32_t *heap = realloc(v->heap, n * sizeof(uint32_t));
+      if (heap == NULL)
+         return false;
+      v->heap = heap;
+      v->capacity = n;
+   }
+   memcpy(limbs(v), mag, n * sizeof(uint32_t));
+   v->length = n;
+   v->negative = negative && n > 0;
+   return true;
+}
+
+/**
+ * Sets v from a sign and a 64-bit magnitude.
+ */
+static bool set_u64(struct bignum *v, uint64_t mag, bool negative) {
+   uint32_t parts[2] = { (uint32_t) mag, (uint32_t) (mag >> 32) };
+   return assign(v, parts, 2, negative);
+}
+
+/**
+ * Sets v to a C integer.
+ * @return: false if out of memory, which cannot happen for inline sizes
+ */
+bool big_set_int(struct bignum *v, long long x) {
+   return x < 0 ? set_u64(v, (uint64_t) -(x + 1) + 1, true) : set_u64(v, (uint64_t) x, false);
+}
+
+/**
+ * Reads v as a 64-bit integer.
+ * @return: false if v does not fit
+ */
+static inline bool to_i64(const struct bignum *v, int64_t *x) {
+   const uint32_t *m = climbs(v);
+   uint64_t mag;
+
+   if (v->length > 2)
+      return false;
+   mag = v->length == 0 ? 0 : v->length == 1 ? m[0] : (m[0] | (uint64_t) m[1] << 32);
+   if (mag > INT64_MAX)
+      return false;
+   *x = v->negative ? -(int64_t) mag : (int64_t) mag;
+   return true;
+}
+
+/**
+ * Compares two magnitudes.
+ * @return: negative, zero or positive as a is less, equal or greater
+ */
+static int mag_cmp(const uint32_t *a, int na, const uint32_t *b, int nb) {
+   if (na != nb)
+      return na < nb ? -1 : 1;
+   while (na-- > 0) {
+      if (a[na] != b[na])
+         return a[na] < b[na] ? -1 : 1;
+   }
+   return 0;
+}
+
+/**
+ * Adds y into x, carrying as far as needed. x must be large enough to
+ * hold the sum.
+ */
+static void add_into(uint32_t *x, int nx, const uint32_t *y, int ny) {
+   uint64_t carry = 0;
+   int i;
+
+   for (i = 0; i < ny; i++) {
+      carry += (uint64_t) x[i] + y[i];
+      x[i] = (uint32_t) carry;
+      carry >>= 32;
+   }
+   for (; carry != 0 && i < nx; i++) {
+      carry += x[i];
+      x[i] = (uint32_t) carry;
+      carry >>= 32;
+   }
+}
+
+/**
+ * Subtracts y from x, borrowing as far as needed. x must be at least y.
+ */
+static void sub_into(uint32_t *x, int nx, const uint32_t *y, int ny) {
+   int64_t borrow = 0;
+   int i;
+
+   for (i = 0; i < ny; i++) {
+      borrow += (int64_t) x[i] - y[i];
+      x[i] = (uint32_t) borrow;
+      borrow >>= 32;
+   }
+   for (; borrow != 0 && i < nx; i++) {
+      borrow += x[i];
+      x[i] = (uint32_t) borrow;
+      borrow >>= 32;
+   }
+}
+
+/**
+ * Schoolbook product of two magnitudes into r, which holds na + nb
+ * zeroed limbs.
+ */
+static void mul_school(uint32_t *r, const uint32_t *a, int na, const uint32_t *b, int nb) {
+   int i, j;
+
+   for (i = 0; i < na; i++) {
+      uint64_t carry = 0;
+      for (j = 0; j < nb; j++) {
+         carry += (uint64_t) a[i] * b[j] + r[i + j];
+         r[i + j] = (uint32_t) carry;
+         carry >>= 32;
+      }
+      r[i + nb] = (uint32_t) carry;
+   }
+}
+
+/**
+ * Product of two magnitudes into r, which holds na + nb zeroed limbs.
+ * Splitting both in half at m limbs, a * b is z2 B^2m + z1 B^m + z0 with
+ * z1 = (a0 + a1)(b0 + b1) - z0 - z2, three half-size products instead
+ * of four. A much longer a is cut into pieces the size of b first.
+ * @return: false if out of memory
+ */
+static bool mul_mag(uint32_t *r, const uint32_t *a, int na, const uint32_t *b, int nb) {
+   const uint32_t *swap;
+   uint32_t *block, *z0, *z1, *z2, *sa, *sb;
+   int m, n, i, la, lb, l1;
+
+   if (na < nb) {
+      swap = a, a = b, b = swap;
+      n = na, na = nb, nb = n;
+   }
+   // below 4 limbs a split would not make the halves any smaller
+   if (nb < karatsuba_limbs || nb < 4) {
+      mul_school(r, a, na, b, nb);
+      return true;
+   }
+
+   if (na >= 2 * nb) {
+      if ((block = malloc(2 * nb * sizeof(uint32_t))) == NULL)
+         return false;
+      for (i = 0; i < na; i += nb) {
+         n = na - i < nb ? na - i : nb;
+         memset(block, 0, (n + nb) * sizeof(uint32_t));
+         if (!mul_mag(block, a + i, n, b, nb)) {
+            free(block);
+            return false;
+         }
+         add_into(r + i, na + nb - i, block, n + nb);
+      }
+      free(block);
+      return true;
+   }
+
+   // nb > na / 2 >= m, so both high halves are non-empty
+   m = na / 2;
+   la = na - m + 1;
+   lb = (nb - m > m ? nb - m : m) + 1;
+   l1 = la + lb;
+   block = calloc(2 * m + (na + nb - 2 * m) + la + lb + l1, sizeof(uint32_t));
+   if (block == NULL)
+      return false;
+   z0 = block;
+   z2 = z0 + 2 * m;
+   sa = z2 + (na + nb - 2 * m);
+   sb = sa + la;
+   z1 = sb + lb;
+
+   memcpy(sa, a + m, (na - m) * sizeof(uint32_t));
+   add_into(sa, la, a, m);
+   memcpy(sb, b + m, (nb - m) * sizeof(uint32_t));
+   add_into(sb, lb, b, m);
+   if (!mul_mag(z0, a, m, b, m) || !mul_mag(z2, a + m, na - m, b + m, nb - m)
+       || !mul_mag(z1, sa, la, sb, lb)) {
+      free(block);
+      return false;
+   }
+   sub_into(z1, l1, z0, 2 * m);
+   sub_into(z1, l1, z2, na + nb - 2 * m);
+   while (l1 > 0 && z1[l1 - 1] == 0)
+      l1--;
+
+   memcpy(r, z0, (na + nb) * sizeof(uint32_t));   // z0 then z2, back to back
+   add_into(r + m, na + nb - m, z1, l1);
+   free(block);
+   return true;
+}
+
+/**
+ * Quotient of two magnitudes, a >= b, into q, which holds na - nb + 1
+ * limbs. This is Knuth's algorithm D: each quotient limb is estimated
+ * from the top two limbs and corrected at most twice.
+ * @return: false if out of memory
+ */
+static bool div_mag(uint32_t *q, const uint32_t *a, int na, const uint32_t *b, int nb) {
+   uint32_t *un, *vn;
+   int s, i, j;
+
+   if (nb == 1) {
+      uint64_t rem = 0;
+      for (i = na - 1; i >= 0; i--) {
+         uint64_t cur = rem << 32 | a[i];
+         q[i] = (uint32_t) (cur / b[0]);
+         rem = cur % b[0];
+      }
+      return true;
+   }
+
+   if ((un = malloc((na + 1 + nb) * sizeof(uint32_t))) == NULL)
+      return false;
+   vn = un + na + 1;
+
+   // shift so the top limb of the divisor has its high bit set
+   s = __builtin_clz(b[nb - 1]);
+   for (i = nb - 1; i > 0; i--)
+      vn[i] = (b[i] << s) | (uint32_t) ((uint64_t) b[i - 1] >> (32 - s));
+   vn[0] = b[0] << s;
+   un[na] = (uint32_t) ((uint64_t) a[na - 1] >> (32 - s));
+   for (i = na - 1; i > 0; i--)
+      un[i] = (a[i] << s) | (uint32_t) ((uint64_t) a[i - 1] >> (32 - s));
+   un[0] = a[0] << s;
+
+   for (j = na - nb; j >= 0; j--) {
+      uint64_t top = (uint64_t) un[j + nb] << 32 | un[j + nb - 1];
+      uint64_t qhat = top / vn[nb - 1], rhat = top % vn[nb - 1], p;
+      int64_t t, k = 0;
+
+      while (qhat >> 32 || qhat * vn[nb - 2] > (rhat << 32 | un[j + nb - 2])) {
+         qhat--;
+         rhat += vn[nb - 1];
+         if (rhat >> 32)
+            break;
+      }
+      for (i = 0; i < nb; i++) {
+         p = qhat * vn[i];
+         t = (int64_t) un[i + j] - k - (int64_t) (p & 0xffffffffu);
+         un[i + j] = (uint32_t) t;
+         k = (int64_t) (p >> 32) - (t >> 32);
+      }
+      t = (int64_t) un[j + nb] - k;
+      un[j + nb] = (uint32_t) t;
+      q[j] = (uint32_t) qhat;
+
+      // the estimate was one too big; add the divisor back
+      if (t < 0) {
+         uint64_t carry = 0;
+         q[j]--;
+         for (i = 0; i < nb; i++) {
+            carry += (uint64_t) un[i + j] + vn[i];
+            un[i + j] = (uint32_t) carry;
+            carry >>= 32;
+         }
+         un[j + nb] += (uint32_t) carry;
+      }
+   }
+   free(un);
+   return true;
+}
+
+/**
+ * Sets r to a + b, or a - b when flip is set.
+ */
+static bool add_signed(struct bignum *r, const struct bignum *a, const struct bignum *b,
+                       bool flip) {
+   const uint32_t *x = climbs(a), *y = climbs(b);
+   bool b_negative = b->negative != flip && b->length > 0;
+   int nx = a->length, ny = b->length, n;
+   uint32_t stack[BIG_INLINE + 1], *sum = stack;
+   bool negative, ok;
+
+   if (a->negative == b_negative) {
+      negative = a->negative;
+   } else if (mag_cmp(x, nx, y, ny) >= 0) {
+      negative = a->negative;
+   } else {
+      negative = b_negative;
+      x = climbs(b), y = climbs(a);
+      n = nx, nx = ny, ny = n;
+   }
+   if (nx < ny) {   // same signs: make x the longer one
+      const uint32_t *t = x;
+      x = y, y = t;
+      n = nx, nx = ny, ny = n;
+   }
+   if (nx + 1 > BIG_INLINE + 1 && (sum = malloc((nx + 1) * sizeof(uint32_t))) == NULL)
+      return false;
+   memcpy(sum, x, nx * sizeof(uint32_t));
+   sum[nx] = 0;
+   if (a->negative == b_negative)
+      add_into(sum, nx + 1, y, ny);
+   else
+      sub_into(sum, nx + 1, y, ny);
+   ok = assign(r, sum, nx + 1, negative);
+   if (sum != stack)
+      free(sum);
+   return ok;
+}
+
+/**
+ * Sets r to a + b. r may be a or b.
+ * @return: false if out of memory
+ */
+bool big_add(struct bignum *r, const struct bignum *a, const struct bignum *b) {
+   int64_t x, y, z;
+
+   if (to_i64(a, &x) && to_i64(b, &y) && !__builtin_add_overflow(x, y, &z))
+      return big_set_int(r, z);
+   return add_signed(r, a, b, false);
+}
+
+/**
+ * Sets r to a - b. r may be a or b.
+ * @return: false if out of memory
+ */
+bool big_sub(struct bignum *r, const struct bignum *a, const struct bignum *b) {
+   int64_t x, y, z;
+
+   if (to_i64(a, &x) && to_i64(b, &y) && !__builtin_sub_overflow(x, y, &z))
+      return big_set_int(r, z);
+   return add_signed(r, a, b, true);
+}
+
+/**
+ * Sets r to a * b. r may be a or b.
+ * @return: false if out of memory
+ */
+bool big_mul(struct bignum *r, const struct bignum *a, const struct bignum *b) {
+   int64_t x, y, z;
+   uint32_t *product;
+   int n = a->length + b->length;
+   bool ok;
+
+   if (to_i64(a, &x) && to_i64(b, &y) && !__builtin_mul_overflow(x, y, &z))
+      return big_set_int(r, z);
+   if ((product = calloc(n, sizeof(uint32_t))) == NULL)
+      return false;
+   ok = mul_mag(product, climbs(a), a->length, climbs(b), b->length)
+        && assign(r, product, n, a->negative != b->negative);
+   free(product);
+   return ok;
+}
+
+/**
+ * Sets r to a / b, truncated toward zero as C division is. r may be a
+ * or b.
+ * @return: false if b is zero or out of memory
+ */
+bool big_div(struct bignum *r, const struct bignum *a, const struct bignum *b) {
+   int64_t x, y;
+   uint32_t *quotient;
+   int n;
+   bool ok;
+
+   if (b->length == 0)
+      return false;
+   if (to_i64(a, &x) && to_i64(b, &y) && !(x == INT64_MIN && y == -1))
+      return big_set_int(r, x / y);
+   if (mag_cmp(climbs(a), a->length, climbs(b), b->length) < 0)
+      return big_set_int(r, 0);
+
+   n = a->length - b->length + 1;
+   if ((quotient = malloc(n * sizeof(uint32_t))) == NULL)
+      return false;
+   ok = div_mag(quotient, climbs(a), a->length, climbs(b), b->length)
+        && assign(r, quotient, n, a->negative != b->negative);
+   free(quotient);
+   return ok;
+}
+
+/**
+ * Sets r to base ^ exponent by squaring. A negative exponent gives the
+ * truncated value of 1 / base ^ -exponent, as ipow() does.
+ * @return: false for 0 to a negative power, a result over BIG_MAX_BITS
+ *          bits, or out of memory
+ */
+bool big_pow(struct bignum *r, const struct bignum *base, const struct bignum *exponent) {
+   struct bignum square, result;
+   int64_t e, bits;
+   bool unit = base->length == 1 && climbs(base)[0] == 1;
+   bool odd = exponent->length > 0 && (climbs(exponent)[0] & 1);
+   bool ok = true;
+
+   if (exponent->length == 0)
+      return big_set_int(r, 1);
+   if (base->length == 0)
+      return !exponent->negative && big_set_int(r, 0);
+   if (unit)
+      return big_set_int(r, base->negative && odd ? -1 : 1);
+   if (exponent->negative)
+      return big_set_int(r, 0);
+
+   bits = 32 * (int64_t) base->length - __builtin_clz(climbs(base)[base->length - 1]);
+   if (!to_i64(exponent, &e) || e > BIG_MAX_BITS / bits)
+      return false;
+
+   big_init(&square);
+   big_init(&result);
+   ok = assign(&square, climbs(base), base->length, base->negative) && big_set_int(&result, 1);
+   while (ok) {
+      if (e & 1)
+         ok = big_mul(&result, &result, &square);
+      e >>= 1;
+      if (e == 0)
+         break;
+      ok = ok && big_mul(&square, &square, &square);
+   }
+   if (ok) {
+      big_free(r);
+      *r = result;
+   } else {
+      big_free(&result);
+   }
+   big_free(&square);
+   return ok;
+}
+
+/**
+ * Compares two bignums.
+ * @return: negative, zero or positive as a is less, equal or greater
+ */
+int big_cmp(const struct bignum *a, const struct bignum *b) {
+   int order;
+
+   if (a->negative != b->negative)
+      return a->negative ? -1 : 1;
+   order = mag_cmp(climbs(a), a->length, climbs(b), b->length);
+   return a->negative ? -order : order;
+}
+
+/**
+ * Sets v to the value of length decimal digits.
+ * @return: false if out of memory
+ */
+bool big_digits(struct bignum *v, const char *p, int length) {
+   static const uint32_t tens[10] = { 1, 10, 100, 1000, 10000, 100000, 1000000,
+                                      10000000, 100000000, 1000000000 };
+   uint32_t *mag;
+   int n = 0, i, chunk;
+   bool ok;
+
+   if (length <= 19 && (length < 19 || strncmp(p, "9223372036854775807", 19) <= 0)) {
+      int64_t x = 0;
+      for (i = 0; i < length; i++)
+         x = 10 * x + (p[i] - '0');
+      return big_set_int(v, x);
+   }
+
+   // each limb holds more than 9 digits
+   if ((mag = calloc(length / 9 + 2, sizeof(uint32_t))) == NULL)
+      return false;
+   for (i = 0; i < length; i += chunk) {
+      uint64_t carry = 0;
+      uint32_t value = 0;
+      int j;
+
+      chunk = length - i < 9 ? length - i : 9;
+      for (j = 0; j < chunk; j++)
+         value = 10 * value + (uint32_t) (p[i + j] - '0');
+      carry = value;
+      for (j = 0; j < n; j++) {
+         carry += (uint64_t) mag[j] * tens[chunk];
+         mag[j] = (uint32_t) carry;
+         carry >>= 32;
+      }
+      if (carry != 0)
+         mag[n++] = (uint32_t) carry;
+   }
+   ok = assign(v, mag, n, false);
+   free(mag);
+   return ok;
+}
+
+/**
+ * Writes a bignum in decimal, converting 9 digits at a time.
+ * @param out: where to write
+ * @param v: the bignum to write
+ */
+void big_print(FILE *out, const struct bignum *v) {
+   uint32_t *mag, *chunks;
+   int n = v->length, count = 0, i;
+
+   if (n == 0) {
+      fputs("0", out);
+      return;
+   }
+   mag = malloc(n * sizeof(uint32_t));
+   chunks = malloc((n * 32 / 29 + 2) * sizeof(uint32_t));
+   if (mag == NULL || chunks == NULL) {
+      fputs("(out of memory)", out);
+      free(mag);
+      free(chunks);
+      return;
+   }
+   memcpy(mag, climbs(v), n * sizeof(uint32_t));
+   do {
+      uint64_t rem = 0;
+      for (i = n - 1; i >= 0; i--) {
+         uint64_t cur = rem << 32 | mag[i];
+         mag[i] = (uint32_t) (cur / 1000000000);
+         rem = cur % 1000000000;
+      }
+      chunks[count++] = (uint32_t) rem;
+      while (n > 0 && mag[n - 1] == 0)
+         n--;
+   } while (n > 0);
+   fprintf(out, "%s%u", v->negative ? "-" : "", chunks[count - 1]);
+   for (i = count - 2; i >= 0; i--)
+      fprintf(out, "%09u", chunks[i]);
+   free(mag);
+   free(chunks);
+}
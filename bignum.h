@@ -0,0 +1,42 @@
+#ifndef BIGNUM_H
+#define BIGNUM_H
+/*
+ * Purpose: Arbitrary-precision integers for the VALUE_BIGNUM backend.
+ * Date:    2025 May 5
+ */
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#define BIG_INLINE 2            // limbs stored in the bignum itself
+#define BIG_MAX_BITS (1 << 24)  // largest power big_pow() will compute
+
+/*
+ * A sign and a magnitude in base 2^32 limbs, lowest limb first. Values
+ * up to 64 bits live in small[] and never touch the heap; larger ones
+ * move to heap. Zero has length 0 and is never negative.
+ */
+struct bignum {
+   bool negative;
+   int length;          // limbs in use
+   int capacity;        // limbs in heap, or 0 while small[] is used
+   uint32_t *heap;
+   uint32_t small[BIG_INLINE];
+};
+
+// Limbs at which big_mul() switches from schoolbook to Karatsuba
+extern int karatsuba_limbs;
+
+void big_init(struct bignum *);
+void big_free(struct bignum *);
+bool big_set_int(struct bignum *, long long);
+bool big_digits(struct bignum *, const char *, int);
+bool big_add(struct bignum *, const struct bignum *, const struct bignum *);
+bool big_sub(struct bignum *, const struct bignum *, const struct bignum *);
+bool big_mul(struct bignum *, const struct bignum *, const struct bignum *);
+bool big_div(struct bignum *, const struct bignum *, const struct bignum *);
+bool big_pow(struct bignum *, const struct bignum *, const struct bignum *);
+int big_cmp(const struct bignum *, const struct bignum *);
+void big_print(FILE *, const struct bignum *);
+
+#endif
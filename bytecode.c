@@ -0,0 +1,389 @@
+/*
+ * bytecode.c - compiles a <bexpr> into a flat array of stack machine
+ * instructions and runs it. The compile functions follow the grammar in
+ * parser.c one for one, but emit code instead of computing values, so an
+ * expression is lexed and parsed once and then run as often as needed.
+ * Date:   2025 April 25
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include "bytecode.h"
+#include "ipow.h"
+
+// Stack slots run() keeps on the C stack before it falls back to malloc
+#define VM_STACK 256
+
+/*
+ * What the c_* functions return on success: what is known about the
+ * value the code they emitted leaves on the stack. Errors are ERROR.
+ */
+#define SHAPE_ANY 0        // nothing
+#define SHAPE_BOOL 1       // it is 0 or 1, from a comparison
+#define SHAPE_CONSTANT 2   // the code is a single OP_PUSH
+
+static int c_expr(struct parser_state *, struct program *);
+
+/**
+ * Appends one int to the code array, growing it as needed.
+ * @return: 0, or ERROR if out of memory
+ */
+static int emit_int(struct program *prog, int value) {
+   if (prog->length == prog->capacity) {
+      int capacity = prog->capacity ? prog->capacity * 2 : 64;
+      int *code = realloc(prog->code, capacity * sizeof(int));
+      if (code == NULL)
+         return ERROR;
+      prog->code = code;
+      prog->capacity = capacity;
+   }
+   prog->code[prog->length++] = value;
+   return 0;
+}
+
+/**
+ * Appends an opcode and tracks the stack depth it leaves behind.
+ * @return: 0, or ERROR if out of memory
+ */
+static int emit(struct program *prog, enum opcode op) {
+   prog->depth += (op == OP_PUSH) ? 1 : (op == OP_MASK) ? 0 : -1;
+   if (prog->depth > prog->max_depth)
+      prog->max_depth = prog->depth;
+   return emit_int(prog, op);
+}
+
+/**
+ * Appends OP_DIV or OP_POW and the index of a new site, which keeps the
+ * offset of the operator for run() to report an error at.
+ * @return: 0, or ERROR if out of memory
+ */
+static int emit_site(struct program *prog, enum opcode op, size_t offset) {
+   if (prog->site_count == prog->site_capacity) {
+      int capacity = prog->site_capacity ? prog->site_capacity * 2 : 16;
+      size_t *sites = realloc(prog->sites, capacity * sizeof(size_t));
+      if (sites == NULL)
+         return ERROR;
+      prog->sites = sites;
+      prog->site_capacity = capacity;
+   }
+   prog->sites[prog->site_count] = offset;
+   if (emit(prog, op) == ERROR || emit_int(prog, prog->site_count) == ERROR)
+      return ERROR;
+   prog->site_count++;
+   return 0;
+}
+
+/**
+ * Maps an operator token to its instruction.
+ */
+static enum opcode opcode_of(enum token_kind kind) {
+   switch (kind) {
+      case ADD_OP: return OP_ADD;
+      case SUB_OP: return OP_SUB;
+      case MULT_OP: return OP_MUL;
+      case DIV_OP: return OP_DIV;
+      case EXPON_OP: return OP_POW;
+      case LESS_THAN_OP: return OP_LT;
+      case GREATER_THAN_OP: return OP_GT;
+      case LESS_THAN_OR_EQUAL_OP: return OP_LE;
+      case GREATER_THAN_OR_EQUAL_OP: return OP_GE;
+      case EQUALS_OP: return OP_EQ;
+      default: return OP_NE;
+   }
+}
+
+/**
+ * <expp> -> ( <expr> ) | <num>
+ */
+static int c_expp(struct parser_state *ps, struct program *prog) {
+   if (ps->lex.kind == LEFT_PAREN) {
+      next_token(ps); // Consume the left parenthesis
+      int shape = c_expr(ps, prog);
+      if (shape == ERROR)
+         return ERROR;
+      if (ps->lex.kind != RIGHT_PAREN) {
+         ps->is_right_paren_error = true;
+         parse_error(ps, PARSE_SYNTAX_ERROR, token_offset(ps), "Syntax Error: ')' expected");
+         return ERROR;
+      }
+      next_token(ps); // Consume the right parenthesis
+      return shape;
+   }
+   if (ps->lex.kind != INT_LITERAL) {
+      parse_error(ps, PARSE_SYNTAX_ERROR, token_offset(ps), "Syntax Error: Expected a number");
+      return ERROR;
+   }
+   if (emit(prog, OP_PUSH) == ERROR || emit_int(prog, token_int(ps)) == ERROR)
+      return ERROR;
+   next_token(ps);
+   return SHAPE_CONSTANT;
+}
+
+/**
+ * <factor> -> <expp> ^ <factor> | <expp>
+ */
+static int c_factor(struct parser_state *ps, struct program *prog) {
+   int shape = c_expp(ps, prog);
+
+   if (shape == ERROR)
+      return ERROR;
+   if (ps->lex.kind == EXPON_OP) {
+      size_t offset = token_offset(ps);
+      next_token(ps);
+      if (c_factor(ps, prog) == ERROR)
+         return ERROR;
+      return emit_site(prog, OP_POW, offset);
+   }
+   return shape;
+}
+
+/**
+ * <stmt> -> <factor> <ftail>
+ * <ftail> -> <compare_tok> <factor> <ftail> | e
+ */
+static int c_stmt(struct parser_state *ps, struct program *prog) {
+   int shape = c_factor(ps, prog);
+
+   if (shape == ERROR)
+      return ERROR;
+   for (;;) {
+      enum token_kind op = ps->lex.kind;
+      switch (op) {
+         case LESS_THAN_OP:
+         case GREATER_THAN_OP:
+         case LESS_THAN_OR_EQUAL_OP:
+         case GREATER_THAN_OR_EQUAL_OP:
+         case NOT_EQUALS_OP:
+         case EQUALS_OP:
+            next_token(ps);
+            if (c_factor(ps, prog) == ERROR || emit(prog, opcode_of(op)) == ERROR)
+               return ERROR;
+            shape = SHAPE_BOOL;
+            break;
+         default:
+            return shape;
+      }
+   }
+}
+
+/**
+ * Whether the code from start to the end of prog can fail when run, or
+ * change the statement's status, because it divides or raises a power.
+ */
+static bool can_fail(const struct program *prog, int start) {
+   for (int pc = start; pc < prog->length; pc++) {
+      if (prog->code[pc] == OP_PUSH || prog->code[pc] == OP_MASK)
+         pc++; // Skip the operand
+      else if (prog->code[pc] == OP_DIV || prog->code[pc] == OP_POW)
+         return true;
+   }
+   return false;
+}
+
+/**
+ * Compiles a comparison times a constant. The left operand's code runs
+ * from start to right, the right one's from right to the end; one of
+ * them is the comparison and the other a single OP_PUSH. A product with
+ * 0 drops the comparison, unless it could fail, for a push of 0; any
+ * other constant becomes an OP_MASK, which selects without a multiply.
+ * @return: the shape of the product, or ERROR if out of memory
+ */
+static int c_mask(struct program *prog, int start, int right, int left_shape) {
+   int constant;
+
+   if (left_shape == SHAPE_CONSTANT) {
+      // Slide the comparison over the push of the constant
+      constant = prog->code[start + 1];
+      memmove(prog->code + start, prog->code + right,
+              (prog->length - right) * sizeof(int));
+      prog->length -= right - start;
+   } else {
+      constant = prog->code[right + 1];
+      prog->length = right;
+   }
+   prog->depth--;
+   if (constant == 0 && !can_fail(prog, start)) {
+      prog->length = start;
+      prog->depth--;
+      return emit(prog, OP_PUSH) == ERROR || emit_int(prog, 0) == ERROR ? ERROR : SHAPE_CONSTANT;
+   }
+   if (emit(prog, OP_MASK) == ERROR || emit_int(prog, constant) == ERROR)
+      return ERROR;
+   return constant == 1 ? SHAPE_BOOL : SHAPE_ANY;
+}
+
+/**
+ * <term> -> <stmt> <stail>
+ * <stail> -> <mult_div_tok> <stmt> <stail> | e
+ */
+static int c_term(struct parser_state *ps, struct program *prog) {
+   int start = prog->length, right, shape = c_stmt(ps, prog), right_shape;
+
+   if (shape == ERROR)
+      return ERROR;
+   while (ps->lex.kind == MULT_OP || ps->lex.kind == DIV_OP) {
+      enum token_kind op = ps->lex.kind;
+      size_t offset = token_offset(ps);
+      next_token(ps);
+      right = prog->length;
+      if ((right_shape = c_stmt(ps, prog)) == ERROR)
+         return ERROR;
+      if (op == MULT_OP && (shape | right_shape) == (SHAPE_BOOL | SHAPE_CONSTANT))
+         shape = c_mask(prog, start, right, shape);
+      else if (op == DIV_OP)
+         shape = emit_site(prog, OP_DIV, offset) == ERROR ? ERROR : SHAPE_ANY;
+      else
+         shape = emit(prog, OP_MUL) == ERROR ? ERROR : SHAPE_ANY;
+      if (shape == ERROR)
+         return ERROR;
+   }
+   return shape;
+}
+
+/**
+ * <expr> -> <term> <ttail>
+ * <ttail> -> <add_sub_tok> <term> <ttail> | e
+ */
+static int c_expr(struct parser_state *ps, struct program *prog) {
+   int shape = c_term(ps, prog);
+
+   if (shape == ERROR)
+      return ERROR;
+   while (ps->lex.kind == ADD_OP || ps->lex.kind == SUB_OP) {
+      enum token_kind op = ps->lex.kind;
+      next_token(ps);
+      if (c_term(ps, prog) == ERROR || emit(prog, opcode_of(op)) == ERROR)
+         return ERROR;
+      shape = SHAPE_ANY;
+   }
+   return shape;
+}
+
+/**
+ * Sets up an empty program.
+ * @param prog: the program to initialize
+ */
+void program_init(struct program *prog) {
+   memset(prog, 0, sizeof(*prog));
+}
+
+/**
+ * Frees the code of a program.
+ * @param prog: the program to free
+ */
+void program_free(struct program *prog) {
+   free(prog->code);
+   free(prog->sites);
+   program_init(prog);
+}
+
+/**
+ * <bexpr> -> <expr> ;
+ * Compiles the next <bexpr> into prog, replacing what it held before.
+ * The tails are loops rather than tail calls; the code they emit is the
+ * same left-to-right order the recursive evaluator uses. Errors are
+ * reported and recovered from as bexpr() does.
+ * @param ps: the parser state, positioned at the start of a <bexpr>
+ * @param prog: where to put the code
+ * @return: true if prog can be run; see ps->status
+ */
+bool compile(struct parser_state *ps, struct program *prog) {
+   prog->length = prog->depth = prog->max_depth = prog->site_count = 0;
+   ps->is_right_paren_error = false;
+   ps->status = PARSE_OK;
+
+   // A syntax error has been reported by now, so what is left is memory
+   if ((c_expr(ps, prog) == ERROR || emit_int(prog, OP_HALT) == ERROR) && ps->status == PARSE_OK)
+      parse_error(ps, PARSE_OUT_OF_MEMORY, token_offset(ps), "ERROR: out of memory");
+   return bexpr_finish(ps, 0).status == PARSE_OK;
+}
+
+/*
+ * Instruction dispatch. GCC and Clang jump straight from one handler to
+ * the next through a table of label addresses; other compilers, or builds
+ * with -DVM_NO_COMPUTED_GOTO, get a switch inside a loop.
+ */
+#if defined(__GNUC__) && !defined(VM_NO_COMPUTED_GOTO)
+#define VM_COMPUTED_GOTO
+#define VM_START     goto *dispatch[*pc++];
+#define VM_CASE(op)  L_##op:
+#define VM_NEXT      goto *dispatch[*pc++]
+#define VM_END
+#else
+#define VM_START     for (;;) switch (*pc++) {
+#define VM_CASE(op)  case op:
+#define VM_NEXT      continue
+#define VM_END       }
+#endif
+
+/**
+ * Runs a compiled program. An error is reported through ps, as bexpr()
+ * reports it, at the offset of its operator in the compiled statement.
+ * @param prog: a program filled by compile()
+ * @param ps: where errors go; its status is set to that of the run
+ * @return: PARSE_OK and the value of the expression, or why '/' or '^'
+ *          failed, or PARSE_OUT_OF_MEMORY if there is no memory for the stack
+ */
+struct eval_result run(const struct program *prog, struct parser_state *ps) {
+#ifdef VM_COMPUTED_GOTO
+   static void *const dispatch[] = {
+      &&L_OP_PUSH, &&L_OP_ADD, &&L_OP_SUB, &&L_OP_MUL, &&L_OP_DIV,
+      &&L_OP_POW, &&L_OP_LT, &&L_OP_GT, &&L_OP_LE, &&L_OP_GE,
+      &&L_OP_EQ, &&L_OP_NE, &&L_OP_MASK, &&L_OP_HALT
+   };
+#endif
+   int local[VM_STACK];
+   int *stack = local, *sp;
+   struct eval_result result = { PARSE_OK, 0 };
+   const int *pc = prog->code;
+
+   ps->status = PARSE_OK;
+   if (prog->max_depth > VM_STACK
+       && (stack = malloc(prog->max_depth * sizeof(int))) == NULL) {
+      parse_error(ps, PARSE_OUT_OF_MEMORY, 0, "ERROR: out of memory");
+      result.status = ps->status;
+      return result;
+   }
+   sp = stack - 1;
+
+   VM_START
+   VM_CASE(OP_PUSH) *++sp = *pc++; VM_NEXT;
+   VM_CASE(OP_ADD)  sp--; *sp = *sp + sp[1]; VM_NEXT;
+   VM_CASE(OP_SUB)  sp--; *sp = *sp - sp[1]; VM_NEXT;
+   VM_CASE(OP_MUL)  sp--; *sp = *sp * sp[1]; VM_NEXT;
+   VM_CASE(OP_DIV)
+      sp--;
+      if (sp[1] == 0)
+         goto divide_by_zero;
+      if (sp[1] == -1 && *sp == INT_MIN)
+         goto divide_overflow;
+      *sp = *sp / sp[1];
+      pc++; // Skip the site
+      VM_NEXT;
+   VM_CASE(OP_POW)  sp--; if (!ipow(*sp, sp[1], sp)) goto overflow; pc++; VM_NEXT;
+   VM_CASE(OP_LT)   sp--; *sp = *sp < sp[1]; VM_NEXT;
+   VM_CASE(OP_GT)   sp--; *sp = *sp > sp[1]; VM_NEXT;
+   VM_CASE(OP_LE)   sp--; *sp = *sp <= sp[1]; VM_NEXT;
+   VM_CASE(OP_GE)   sp--; *sp = *sp >= sp[1]; VM_NEXT;
+   VM_CASE(OP_EQ)   sp--; *sp = *sp == sp[1]; VM_NEXT;
+   VM_CASE(OP_NE)   sp--; *sp = *sp != sp[1]; VM_NEXT;
+   VM_CASE(OP_MASK) *sp = -*sp & *pc++; VM_NEXT;
+   VM_CASE(OP_HALT) result.value = *sp; goto done;
+   VM_END
+
+   // pc is at the site of the failed operator
+divide_by_zero:
+   parse_error(ps, PARSE_DIVIDE_BY_ZERO, prog->sites[*pc], "Math Error: division by zero");
+   goto done;
+divide_overflow:
+   parse_error(ps, PARSE_OVERFLOW, prog->sites[*pc], "Overflow Error: '/' result out of range");
+   goto done;
+overflow:
+   parse_error(ps, PARSE_OVERFLOW, prog->sites[*pc], "Overflow Error: '^' result out of range");
+done:
+   if (stack != local)
+      free(stack);
+   result.status = ps->status;
+   return result;
+}
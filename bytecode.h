@@ -0,0 +1,50 @@
+#ifndef BYTECODE_H
+#define BYTECODE_H
+/*
+ * Purpose: Compile a <bexpr> once into bytecode and run it many times.
+ * Date:    2025 April 25
+ */
+#include "parser.h"
+
+/*
+ * Instructions for a stack machine. OP_PUSH and OP_MASK are followed by
+ * their operand in the code array, and OP_DIV and OP_POW, which can fail,
+ * by the index in sites of their operator's offset; every other opcode
+ * pops its operands and pushes its result. OP_MASK replaces a 0 or 1 on
+ * the stack with 0 or its operand, which is how a comparison times a
+ * constant compiles.
+ */
+enum opcode {
+   OP_PUSH,
+   OP_ADD,
+   OP_SUB,
+   OP_MUL,
+   OP_DIV,
+   OP_POW,
+   OP_LT,
+   OP_GT,
+   OP_LE,
+   OP_GE,
+   OP_EQ,
+   OP_NE,
+   OP_MASK,
+   OP_HALT
+};
+
+struct program {
+   int *code;        // opcodes and inline operands
+   int length;       // ints used in code
+   int capacity;     // ints allocated for code
+   int depth;        // stack depth at this point of compilation
+   int max_depth;    // stack slots run() needs
+   size_t *sites;    // input offsets of the '/' and '^' operators, for errors
+   int site_count;
+   int site_capacity;
+};
+
+void program_init(struct program *);
+void program_free(struct program *);
+bool compile(struct parser_state *, struct program *);
+struct eval_result run(const struct program *, struct parser_state *);
+
+#endif
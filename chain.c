@@ -0,0 +1,312 @@
+/*
+ * chain.c - parallel evaluation of a long statement. An <expr> is a sum
+ * of terms and a term a chain of <stmt>s joined by * and /, and at paren
+ * depth 0 a + - * or / byte is always one of those operators, so the
+ * statement's text can be cut into ranges without parsing it first:
+ *
+ *    1. each range counts its parentheses, and a prefix sum over the
+ *       ranges gives the depth each one starts at
+ *    2. each range parses, with stmt(), every operand whose operator is
+ *       in the range, and reduces them to a summary
+ *    3. the summaries are combined left to right
+ *
+ * Sums and products wrap, so they can be regrouped; division cannot. A
+ * range that starts inside a term keeps that term's divisions, with the
+ * products between them, to apply once the value of the term so far is
+ * known. So every division has the same dividend as in bexpr(). Steps 1
+ * and 2 run on a task_pool. When any range fails, whether on an error
+ * or on text the cut got wrong, the statement is evaluated again by
+ * bexpr(), which reports the error as it always has.
+ * Date:   2025 May 13
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include "chain.h"
+
+// A '/' in a term that began before the range, and the product after it
+struct deferred {
+   int divisor;
+   unsigned product;
+};
+
+/*
+ * One range of the statement's text and, after step 2, the summary of
+ * the operands whose operator is in it. Applied to the term in progress
+ * before the range, the summary multiplies it by head, divides and
+ * multiplies it by the deferred steps, and if the range closed it, adds
+ * it, then sum, and leaves tail as the term in progress.
+ */
+struct chunk {
+   char *start;
+   char *end;
+   int depth;          // step 1: change in depth, then the depth at start
+   int low;            // step 1: lowest depth reached, relative to start
+   char *first;        // the first top-level operator, or NULL if none
+   char *stop;         // the operator the last operand ended at, or NULL at the end
+   bool failed;
+   bool closed;        // a + or - ended the term in progress
+   unsigned head;
+   struct deferred *steps;
+   int step_count;
+   int step_capacity;
+   unsigned sum;       // terms begun and ended in the range
+   unsigned tail;      // the term begun last
+   bool negative;      // tail is subtracted
+};
+
+struct chain {
+   char *text;         // the statement up to its ';'
+   size_t length;
+   struct chunk *chunks;
+   int count;
+};
+
+/**
+ * Divides as stail() does.
+ * @return: false on a division by zero or INT_MIN / -1
+ */
+static bool divide(unsigned *value, int divisor) {
+   int dividend = (int) *value;
+
+   if (divisor == 0 || (divisor == -1 && dividend == INT_MIN))
+      return false;
+   *value = (unsigned) (dividend / divisor);
+   return true;
+}
+
+// Step 1: the change in depth over a range, and the lowest it goes
+static void count_parens(void *arg, int i) {
+   struct chunk *c = &((struct chain *) arg)->chunks[i];
+   int depth = 0, low = 0;
+   char *p;
+
+   for (p = c->start; p < c->end; p++) {
+      if (*p == '(') {
+         depth++;
+      } else if (*p == ')' && --depth < low) {
+         low = depth;
+      }
+   }
+   c->depth = depth;
+   c->low = low;
+}
+
+// Adds one operand, joined by op, to a range's summary
+static void add_operand(struct chunk *c, char op, int value) {
+   unsigned v = (unsigned) value;
+
+   switch (op) {
+      case '+':
+      case '-':
+         if (c->closed)
+            c->sum += c->negative ? -c->tail : c->tail;
+         c->closed = true;
+         c->tail = v;
+         c->negative = op == '-';
+         return;
+      case '*':
+         if (c->closed)
+            c->tail *= v;
+         else if (c->step_count > 0)
+            c->steps[c->step_count - 1].product *= v;
+         else
+            c->head *= v;
+         return;
+      default:
+         if (c->closed) {
+            c->failed |= !divide(&c->tail, value);
+            return;
+         }
+         if (c->step_count == c->step_capacity) {
+            int capacity = c->step_capacity ? c->step_capacity * 2 : 16;
+            struct deferred *grown = realloc(c->steps, capacity * sizeof(struct deferred));
+            if (grown == NULL) {
+               c->failed = true;
+               return;
+            }
+            c->steps = grown;
+            c->step_capacity = capacity;
+         }
+         c->steps[c->step_count].divisor = value;
+         c->steps[c->step_count++].product = 1;
+   }
+}
+
+/**
+ * Step 2: parses the operands whose operators are in range i, the first
+ * range also taking the operand the statement starts with. The last one
+ * may run past the range; the next range starts at the operator after it.
+ */
+static void reduce_range(void *arg, int i) {
+   struct chain *ch = arg;
+   struct chunk *c = &ch->chunks[i];
+   struct parser_state ps;
+   struct error_log log;
+   char *p = c->start, op = '+';
+   int depth = c->depth, value;
+
+   c->head = 1;
+   if (i > 0) {
+      // The first operator at depth 0
+      for (; p < c->end; p++) {
+         if (*p == '(')
+            depth++;
+         else if (*p == ')')
+            depth--;
+         else if (depth == 0 && (*p == '+' || *p == '-' || *p == '*' || *p == '/'))
+            break;
+      }
+      if (p == c->end)
+         return;
+      c->first = p;
+      op = *p++;
+   }
+
+   error_log_init(&log);
+   for (;;) {
+      parser_init_range(&ps, p, (size_t) (ch->text + ch->length - p));
+      ps.errors = &log; // Errors are reported by bexpr() when it runs again
+      value = stmt(&ps);
+      if (ps.status != PARSE_OK) {
+         c->failed = true;
+         break;
+      }
+      add_operand(c, op, value);
+      if (ps.lex.kind == END_OF_INPUT)
+         break;
+      if (ps.lex.kind != ADD_OP && ps.lex.kind != SUB_OP && ps.lex.kind != MULT_OP
+          && ps.lex.kind != DIV_OP) {
+         c->failed = true;
+         break;
+      }
+      p = ps.token.start;
+      if (p >= c->end) {
+         c->stop = p;
+         break;
+      }
+      op = *p++;
+   }
+   error_log_free(&log);
+}
+
+/**
+ * Step 3: combines the summaries in order, checking that each range
+ * began where the one before it stopped.
+ * @return: false if any range failed or the ranges do not fit together
+ */
+static bool combine(const struct chain *ch, int *value) {
+   unsigned sum = 0, term = 0;
+   bool negative = false;
+   char *next = NULL;
+   int i, j;
+
+   for (i = 0; i < ch->count; i++) {
+      const struct chunk *c = &ch->chunks[i];
+
+      if (c->failed)
+         return false;
+      if (i > 0 && c->first == NULL) {
+         if (next != NULL && next < c->end)
+            return false;
+         continue; // Inside an operand that began earlier
+      }
+      if (i > 0 && c->first != next)
+         return false;
+      term *= c->head;
+      for (j = 0; j < c->step_count; j++) {
+         if (!divide(&term, c->steps[j].divisor))
+            return false;
+         term *= c->steps[j].product;
+      }
+      if (c->closed) {
+         sum += negative ? -term : term;
+         sum += c->sum;
+         term = c->tail;
+         negative = c->negative;
+      }
+      next = c->stop;
+   }
+   if (next != NULL)
+      return false;
+   *value = (int) (sum + (negative ? -term : term));
+   return true;
+}
+
+/**
+ * Evaluates the chain in parallel.
+ * @return: false if it has to be evaluated by bexpr() instead
+ */
+static bool eval_chain(struct task_pool *pool, struct chain *ch, int *value) {
+   size_t size = ch->length / ch->count;
+   int i, depth = 0;
+   bool ok = true;
+
+   for (i = 0; i < ch->count; i++) {
+      ch->chunks[i].start = ch->text + i * size;
+      ch->chunks[i].end = i + 1 < ch->count ? ch->text + (i + 1) * size : ch->text + ch->length;
+   }
+   pool_for(pool, ch->count, count_parens, ch);
+   for (i = 0; i < ch->count; i++) {
+      int change = ch->chunks[i].depth;
+      if (depth + ch->chunks[i].low < 0)
+         return false; // A ')' with no '('
+      ch->chunks[i].depth = depth;
+      depth += change;
+   }
+   if (depth != 0)
+      return false;
+
+   pool_for(pool, ch->count, reduce_range, ch);
+   ok = combine(ch, value);
+   for (i = 0; i < ch->count; i++)
+      free(ch->chunks[i].steps);
+   return ok;
+}
+
+/**
+ * <bexpr> -> <expr> ;
+ * Evaluates the next statement, on the pool's threads if it is at least
+ * CHAIN_SERIAL bytes long, and otherwise, or if it has an error, with
+ * bexpr(). Either way the result, the errors reported and where the
+ * parser is left are those of bexpr().
+ * @param pool: the threads to use
+ * @param ps: the parser state, positioned at the start of a <bexpr>
+ * @return: the status of the evaluation and, if PARSE_OK, its value
+ */
+struct eval_result chain_bexpr(struct task_pool *pool, struct parser_state *ps) {
+   struct eval_result result = { PARSE_OK, 0 };
+   struct chain ch;
+   char *semicolon, *p;
+
+   if (pool->threads < 2 || ps->cached != NULL || ps->lex.kind == END_OF_INPUT)
+      return bexpr(ps);
+   ch.text = ps->token.start;
+   semicolon = memchr(ch.text, ';', (size_t) (ps->lex.end - ch.text));
+   ch.length = semicolon != NULL ? (size_t) (semicolon - ch.text) : 0;
+   if (ch.length < CHAIN_SERIAL || ch.length / CHAIN_CHUNK > INT_MAX)
+      return bexpr(ps);
+   ch.count = (int) (ch.length / CHAIN_CHUNK);
+   if ((ch.chunks = calloc(ch.count, sizeof(struct chunk))) == NULL)
+      return bexpr(ps);
+   if (!eval_chain(pool, &ch, &result.value)) {
+      free(ch.chunks);
+      return bexpr(ps);
+   }
+   free(ch.chunks);
+
+   // Move past the statement as bexpr() would
+   for (p = semicolon; p >= ps->lex.line; p--) {
+      if (*p == '\n') {
+         ps->lex.line_start = p + 1;
+         break;
+      }
+   }
+   ps->lex.line = semicolon + 1;
+   next_token(ps);
+   ps->is_right_paren_error = false;
+   ps->status = PARSE_OK;
+   ps->value = result.value;
+   return result;
+}
@@ -0,0 +1,19 @@
+#ifndef CHAIN_H
+#define CHAIN_H
+/*
+ * Purpose: Evaluate one very long statement on several threads. The
+ *          top-level chain of operands joined by + - * / is cut into
+ *          ranges of text that a task_pool reduces in parallel, and the
+ *          ranges are combined in order, giving what bexpr()'s left to
+ *          right evaluation gives.
+ * Date:    2025 May 13
+ */
+#include "parser.h"
+#include "taskpool.h"
+
+#define CHAIN_SERIAL (64 * 1024)   // statements shorter than this go to bexpr()
+#define CHAIN_CHUNK (16 * 1024)    // bytes of text in each range
+
+struct eval_result chain_bexpr(struct task_pool *, struct parser_state *);
+
+#endif
@@ -0,0 +1,230 @@
+/*
+ * climb.c - evaluates a <bexpr> by precedence climbing. The lookup
+ * tables and the dispatch on the operator are all expanded from
+ * CLIMB_OPERATORS in climb.h when this file is compiled, so the loop
+ * below is the whole grammar above <expp>. A chain of operands costs
+ * one call per operand, not one per level of the grammar as in
+ * parser.c, and a call nests only where an operator binds more tightly
+ * than the one before it, or for '('. A run of a right-associative
+ * operator, such as a tower of '^', is gathered in a loop and applied
+ * right to left, so it nests no calls either. The operators are applied
+ * in the order bexpr() applies them, so both give the same values and
+ * report the same first error.
+ * Date:   2025 May 14
+ */
+
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+#include "climb.h"
+#include "ipow.h"
+
+// Steps of a right-associative run climb_right() keeps on the C stack before it falls back to malloc
+#define CLIMB_RUN 16
+
+// Binding strength of each token kind; 0 for a token that ends an operand chain
+static const unsigned char binding[TOKEN_KIND_COUNT] = {
+#define BINDING(kind, strength, associativity, apply) [kind] = strength,
+   CLIMB_OPERATORS(BINDING)
+#undef BINDING
+};
+
+/*
+ * The least binding strength an operator's right operand takes in: one
+ * more than its own for a left-associative operator, so that the next
+ * operator of the same strength is applied first, its own for a right-
+ * associative one.
+ */
+static const unsigned char right_binding[TOKEN_KIND_COUNT] = {
+#define RIGHT_BINDING(kind, strength, associativity, apply) \
+   [kind] = strength + (associativity == CLIMB_LEFT),
+   CLIMB_OPERATORS(RIGHT_BINDING)
+#undef RIGHT_BINDING
+};
+
+/*
+ * The functions the table names. Each applies its operator to a and b
+ * with the checks bexpr() makes, reporting an error at offset.
+ * @return: false on an error
+ */
+static inline bool climb_add(struct parser_state *ps, int kind, int a, int b, size_t offset,
+                             int *result) {
+   (void) ps, (void) kind, (void) offset;
+   *result = a + b;
+   return true;
+}
+
+static inline bool climb_sub(struct parser_state *ps, int kind, int a, int b, size_t offset,
+                             int *result) {
+   (void) ps, (void) kind, (void) offset;
+   *result = a - b;
+   return true;
+}
+
+static inline bool climb_mul(struct parser_state *ps, int kind, int a, int b, size_t offset,
+                             int *result) {
+   (void) ps, (void) kind, (void) offset;
+   *result = a * b;
+   return true;
+}
+
+static inline bool climb_div(struct parser_state *ps, int kind, int a, int b, size_t offset,
+                             int *result) {
+   (void) kind;
+   if (b == 0) {
+      parse_error(ps, PARSE_DIVIDE_BY_ZERO, offset, "Math Error: division by zero");
+      return false;
+   }
+   if (b == -1 && a == INT_MIN) {
+      parse_error(ps, PARSE_OVERFLOW, offset, "Overflow Error: '/' result out of range");
+      return false;
+   }
+   *result = a / b;
+   return true;
+}
+
+static inline bool climb_compare(struct parser_state *ps, int kind, int a, int b,
+                                 size_t offset, int *result) {
+   (void) ps, (void) offset;
+   *result = compare_values(kind, a, b);
+   return true;
+}
+
+static inline bool climb_pow(struct parser_state *ps, int kind, int a, int b, size_t offset,
+                             int *result) {
+   (void) kind;
+   if (ipow(a, b, result))
+      return true;
+   parse_error(ps, PARSE_OVERFLOW, offset, "Overflow Error: '^' result out of range");
+   return false;
+}
+
+// Applies the operator kind, by a switch the table expands into
+static inline bool apply(struct parser_state *ps, int kind, int a, int b, size_t offset,
+                         int *result) {
+   switch (kind) {
+#define APPLY(op, strength, associativity, fn) \
+      case op: return fn(ps, kind, a, b, offset, result);
+      CLIMB_OPERATORS(APPLY)
+#undef APPLY
+      default: return false;
+   }
+}
+
+static int climb(struct parser_state *, int);
+
+// An operator of a right-associative run and the operand to its right
+struct climb_step {
+   int kind;
+   int operand;
+   size_t offset;
+};
+
+/**
+ * <expp> -> ( <expr> ) | <num>
+ * An operand, with the same errors as expp().
+ * @param ps: the parser state
+ * @return: the value of the operand; see ps->status
+ */
+static int operand(struct parser_state *ps) {
+   int value;
+
+   if (ps->lex.kind != LEFT_PAREN)
+      return num(ps);
+   next_token(ps); // Consume the left parenthesis
+   value = climb(ps, 1);
+   if (ps->status != PARSE_OK)
+      return 0;
+   if (ps->lex.kind != RIGHT_PAREN) {
+      ps->is_right_paren_error = true;
+      parse_error(ps, PARSE_SYNTAX_ERROR, token_offset(ps), "Syntax Error: ')' expected");
+      return 0;
+   }
+   next_token(ps); // Consume the right parenthesis
+   return value;
+}
+
+/**
+ * A run of right-associative operators of one strength, after its first
+ * operand. The operands are gathered left to right, then the operators
+ * applied right to left, which is the order bexpr() applies them in.
+ * Kept out of climb(), so that its steps do not add to every call's frame.
+ * @param ps: the parser state, at the first operator of the run
+ * @param value: the first operand
+ * @param strength: the binding strength of the run's operators
+ * @return: the value of the run; see ps->status
+ */
+#ifdef __GNUC__
+__attribute__((noinline))
+#endif
+static int climb_right(struct parser_state *ps, int value, int strength) {
+   struct climb_step local[CLIMB_RUN], *steps = local, *bigger;
+   int count = 0, capacity = CLIMB_RUN, kind, i;
+
+   do {
+      if (count == capacity) {
+         bigger = malloc(2 * capacity * sizeof(struct climb_step));
+         if (bigger == NULL) {
+            parse_error(ps, PARSE_OUT_OF_MEMORY, token_offset(ps), "ERROR: out of memory");
+            break;
+         }
+         memcpy(bigger, steps, count * sizeof(struct climb_step));
+         if (steps != local)
+            free(steps);
+         steps = bigger;
+         capacity *= 2;
+      }
+      steps[count].kind = ps->lex.kind;
+      steps[count].offset = token_offset(ps);
+      next_token(ps); // Consume the operator
+      steps[count++].operand = climb(ps, strength + 1);
+   } while (ps->status == PARSE_OK && binding[kind = ps->lex.kind] == strength
+            && right_binding[kind] == strength);
+
+   for (i = count - 1; i > 0 && ps->status == PARSE_OK; i--)
+      apply(ps, steps[i].kind, steps[i - 1].operand, steps[i].operand, steps[i].offset,
+            &steps[i - 1].operand);
+   if (ps->status == PARSE_OK)
+      apply(ps, steps[0].kind, value, steps[0].operand, steps[0].offset, &value);
+   if (steps != local)
+      free(steps);
+   return ps->status == PARSE_OK ? value : 0;
+}
+
+/**
+ * An operand and every operator after it, with its right operand, that
+ * binds at least as tightly as least. Called with 1 it is <expr>.
+ * @param ps: the parser state
+ * @param least: the weakest binding strength to apply here
+ * @return: the value; see ps->status
+ */
+static int climb(struct parser_state *ps, int least) {
+   int value = operand(ps), right, kind;
+   size_t offset;
+
+   while (ps->status == PARSE_OK && binding[kind = ps->lex.kind] >= least) {
+      if (right_binding[kind] == binding[kind]) {
+         value = climb_right(ps, value, binding[kind]);
+         continue;
+      }
+      offset = token_offset(ps);
+      next_token(ps); // Consume the operator
+      right = climb(ps, right_binding[kind]);
+      if (ps->status != PARSE_OK || !apply(ps, kind, value, right, offset, &value))
+         return 0;
+   }
+   return ps->status == PARSE_OK ? value : 0;
+}
+
+/**
+ * <bexpr> -> <expr> ;
+ * Evaluates the next <bexpr> like bexpr() does, by precedence climbing.
+ * @param ps: the parser state, positioned at the start of a <bexpr>
+ * @return: the status of the evaluation and, if PARSE_OK, its value
+ */
+struct eval_result climb_bexpr(struct parser_state *ps) {
+   ps->is_right_paren_error = false;
+   ps->status = PARSE_OK;
+
+   return bexpr_finish(ps, climb(ps, 1));
+}
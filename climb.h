@@ -0,0 +1,32 @@
+#ifndef CLIMB_H
+#define CLIMB_H
+/*
+ * Purpose: Evaluate a <bexpr> by precedence climbing over one table of
+ *          operators, instead of one function per level of the grammar.
+ * Date:    2025 May 14
+ */
+#include "parser.h"
+
+/*
+ * The binary operators: token kind, binding strength, associativity
+ * and the function that applies it. The grammar at the top of parser.c
+ * is these rows, weakest first; an operator is added by adding its row.
+ */
+#define CLIMB_OPERATORS(X)                                   \
+   X(ADD_OP,                   1, CLIMB_LEFT,  climb_add)     \
+   X(SUB_OP,                   1, CLIMB_LEFT,  climb_sub)     \
+   X(MULT_OP,                  2, CLIMB_LEFT,  climb_mul)     \
+   X(DIV_OP,                   2, CLIMB_LEFT,  climb_div)     \
+   X(LESS_THAN_OP,             3, CLIMB_LEFT,  climb_compare) \
+   X(LESS_THAN_OR_EQUAL_OP,    3, CLIMB_LEFT,  climb_compare) \
+   X(GREATER_THAN_OP,          3, CLIMB_LEFT,  climb_compare) \
+   X(GREATER_THAN_OR_EQUAL_OP, 3, CLIMB_LEFT,  climb_compare) \
+   X(EQUALS_OP,                3, CLIMB_LEFT,  climb_compare) \
+   X(NOT_EQUALS_OP,            3, CLIMB_LEFT,  climb_compare) \
+   X(EXPON_OP,                 4, CLIMB_RIGHT, climb_pow)
+
+enum climb_associativity { CLIMB_LEFT, CLIMB_RIGHT };
+
+struct eval_result climb_bexpr(struct parser_state *);
+
+#endif
@@ -0,0 +1,527 @@
+/*
+ * columnar.c - compiles a <bexpr> over variables into instructions that
+ * each apply one operator to a whole block of rows, and runs them over
+ * integer columns. The compile functions follow the grammar in parser.c
+ * as bytecode.c's do, with an identifier allowed wherever a number is.
+ * Every row gets the value and status bexpr() would give the statement
+ * with the row's values written in for the variables.
+ * Date:   2025 May 7
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include "columnar.h"
+#include "ipow.h"
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#define COL_X86
+#include <immintrin.h>
+#endif
+
+static bool c_expr(struct parser_state *, struct col_program *, struct col_operand *);
+
+/**
+ * Sets up an empty program.
+ * @param prog: the program to initialize
+ */
+void col_program_init(struct col_program *prog) {
+   memset(prog, 0, sizeof(*prog));
+}
+
+/**
+ * Frees a program.
+ * @param prog: the program to free
+ */
+void col_program_free(struct col_program *prog) {
+   int i;
+
+   for (i = 0; i < prog->name_count; i++)
+      free(prog->names[i]);
+   free(prog->names);
+   free(prog->code);
+   free(prog->constants);
+   col_program_init(prog);
+}
+
+/**
+ * Makes room for one more element in a growing array.
+ * @return: false if out of memory, which is reported as the error
+ */
+static bool reserve(struct parser_state *ps, void **array, int count, int *capacity,
+                    size_t size) {
+   if (count == *capacity) {
+      int bigger = *capacity > 0 ? 2 * *capacity : 16;
+      void *moved = realloc(*array, bigger * size);
+      if (moved == NULL) {
+         parse_error(ps, PARSE_OUT_OF_MEMORY, token_offset(ps), "ERROR: out of memory");
+         return false;
+      }
+      *array = moved;
+      *capacity = bigger;
+   }
+   return true;
+}
+
+/**
+ * Appends dst = a op b. The operands' registers, if any, are the top of
+ * the operand stack, so the result takes the lowest of them.
+ * @return: false if out of memory
+ */
+static bool emit(struct parser_state *ps, struct col_program *prog, int op,
+                 struct col_operand a, struct col_operand b, struct col_operand *out) {
+   struct col_instr *instr;
+
+   if (!reserve(ps, (void **) &prog->code, prog->length, &prog->capacity,
+                sizeof(struct col_instr)))
+      return false;
+   prog->depth -= (a.source == COL_REGISTER) + (b.source == COL_REGISTER);
+   instr = &prog->code[prog->length++];
+   instr->op = op;
+   instr->dst = prog->depth++;
+   instr->a = a;
+   instr->b = b;
+   if (prog->depth > prog->registers)
+      prog->registers = prog->depth;
+   if (op == DIV_OP || op == EXPON_OP)
+      prog->may_fail = true;
+   out->source = COL_REGISTER;
+   out->index = instr->dst;
+   return true;
+}
+
+/**
+ * Finds a variable by name.
+ * @param prog: a compiled program
+ * @param name: the variable
+ * @return: its column number, or -1 if the program does not use it
+ */
+int col_variable(const struct col_program *prog, const char *name) {
+   int i;
+
+   for (i = 0; i < prog->name_count; i++) {
+      if (strcmp(prog->names[i], name) == 0)
+         return i;
+   }
+   return -1;
+}
+
+/**
+ * The column number of the current IDENTIFIER, adding it to the
+ * program's variables the first time it appears.
+ * @return: the column number, or -1 if out of memory
+ */
+static int variable(struct parser_state *ps, struct col_program *prog) {
+   const char *text = ps->token.start;
+   int i, length = ps->token.length;
+   char *name;
+
+   for (i = 0; i < prog->name_count; i++) {
+      if (strncmp(prog->names[i], text, length) == 0 && prog->names[i][length] == '\0')
+         return i;
+   }
+   if (!reserve(ps, (void **) &prog->names, prog->name_count, &prog->name_capacity,
+                sizeof(char *)))
+      return -1;
+   if ((name = malloc(length + 1)) == NULL) {
+      parse_error(ps, PARSE_OUT_OF_MEMORY, token_offset(ps), "ERROR: out of memory");
+      return -1;
+   }
+   memcpy(name, text, length);
+   name[length] = '\0';
+   prog->names[prog->name_count] = name;
+   return prog->name_count++;
+}
+
+/**
+ * <expp> -> ( <expr> ) | <num> | <identifier>
+ */
+static bool c_expp(struct parser_state *ps, struct col_program *prog, struct col_operand *out) {
+   if (ps->lex.kind == LEFT_PAREN) {
+      next_token(ps); // Consume the left parenthesis
+      if (!c_expr(ps, prog, out))
+         return false;
+      if (ps->lex.kind != RIGHT_PAREN) {
+         ps->is_right_paren_error = true;
+         parse_error(ps, PARSE_SYNTAX_ERROR, token_offset(ps), "Syntax Error: ')' expected");
+         return false;
+      }
+      next_token(ps); // Consume the right parenthesis
+      return true;
+   }
+   if (ps->lex.kind == IDENTIFIER) {
+      out->source = COL_COLUMN;
+      if ((out->index = variable(ps, prog)) < 0)
+         return false;
+   } else if (ps->lex.kind == INT_LITERAL) {
+      if (!reserve(ps, (void **) &prog->constants, prog->constant_count,
+                   &prog->constant_capacity, sizeof(int)))
+         return false;
+      prog->constants[prog->constant_count] = token_int(ps);
+      out->source = COL_CONSTANT;
+      out->index = prog->constant_count++;
+   } else {
+      parse_error(ps, PARSE_SYNTAX_ERROR, token_offset(ps),
+                  "Syntax Error: Expected a number or variable");
+      return false;
+   }
+   next_token(ps);
+   return true;
+}
+
+/**
+ * <factor> -> <expp> ^ <factor> | <expp>
+ */
+static bool c_factor(struct parser_state *ps, struct col_program *prog, struct col_operand *out) {
+   struct col_operand right;
+
+   if (!c_expp(ps, prog, out))
+      return false;
+   if (ps->lex.kind != EXPON_OP)
+      return true;
+   next_token(ps);
+   return c_factor(ps, prog, &right) && emit(ps, prog, EXPON_OP, *out, right, out);
+}
+
+/**
+ * <stmt> -> <factor> <ftail>
+ * <ftail> -> <compare_tok> <factor> <ftail> | e
+ */
+static bool c_stmt(struct parser_state *ps, struct col_program *prog, struct col_operand *out) {
+   struct col_operand right;
+
+   if (!c_factor(ps, prog, out))
+      return false;
+   for (;;) {
+      enum token_kind op = ps->lex.kind;
+      switch (op) {
+         case LESS_THAN_OP:
+         case GREATER_THAN_OP:
+         case LESS_THAN_OR_EQUAL_OP:
+         case GREATER_THAN_OR_EQUAL_OP:
+         case NOT_EQUALS_OP:
+         case EQUALS_OP:
+            next_token(ps);
+            if (!c_factor(ps, prog, &right) || !emit(ps, prog, op, *out, right, out))
+               return false;
+            break;
+         default:
+            return true;
+      }
+   }
+}
+
+/**
+ * <term> -> <stmt> <stail>
+ * <stail> -> <mult_div_tok> <stmt> <stail> | e
+ */
+static bool c_term(struct parser_state *ps, struct col_program *prog, struct col_operand *out) {
+   struct col_operand right;
+
+   if (!c_stmt(ps, prog, out))
+      return false;
+   while (ps->lex.kind == MULT_OP || ps->lex.kind == DIV_OP) {
+      enum token_kind op = ps->lex.kind;
+      next_token(ps);
+      if (!c_stmt(ps, prog, &right) || !emit(ps, prog, op, *out, right, out))
+         return false;
+   }
+   return true;
+}
+
+/**
+ * <expr> -> <term> <ttail>
+ * <ttail> -> <add_sub_tok> <term> <ttail> | e
+ */
+static bool c_expr(struct parser_state *ps, struct col_program *prog, struct col_operand *out) {
+   struct col_operand right;
+
+   if (!c_term(ps, prog, out))
+      return false;
+   while (ps->lex.kind == ADD_OP || ps->lex.kind == SUB_OP) {
+      enum token_kind op = ps->lex.kind;
+      next_token(ps);
+      if (!c_term(ps, prog, &right) || !emit(ps, prog, op, *out, right, out))
+         return false;
+   }
+   return true;
+}
+
+/**
+ * <bexpr> -> <expr> ;
+ * Compiles the next <bexpr> into prog, replacing what it held before.
+ * Errors are reported and recovered from as bexpr() does.
+ * @param ps: the parser state, positioned at the start of a <bexpr>
+ * @param prog: an initialized program
+ * @return: false on an error; see ps->status
+ */
+bool col_compile(struct parser_state *ps, struct col_program *prog) {
+   struct col_operand result = { COL_CONSTANT, 0 };
+
+   col_program_free(prog);
+   ps->is_right_paren_error = false;
+   ps->status = PARSE_OK;
+
+   c_expr(ps, prog, &result);
+   prog->result = result;
+   return bexpr_finish(ps, 0).status == PARSE_OK;
+}
+
+/*
+ * The kernels. Each applies one operator to n rows. Only '/' and '^' can
+ * fail; they set the status of a failing row, unless an earlier operator
+ * already failed there, and give it 0 so later operators cannot trap.
+ * '+', '-' and '*' wrap, as the machine instructions bexpr() runs do.
+ */
+typedef void col_kernel(int *dst, const int *a, const int *b, int n, unsigned char *status);
+
+// Marks row i as failed with the given status unless it already failed
+#define FAIL(i, why) do { if (status[i] == PARSE_OK) status[i] = (why); } while (0)
+
+#define SCALAR_KERNEL(name, expression)                                         \
+   static void name##_scalar(int *dst, const int *a, const int *b, int n,      \
+                             unsigned char *status) {                          \
+      (void) status;                                                           \
+      for (int i = 0; i < n; i++)                                              \
+         dst[i] = (expression);                                                \
+   }
+
+SCALAR_KERNEL(add, (int) ((unsigned) a[i] + (unsigned) b[i]))
+SCALAR_KERNEL(sub, (int) ((unsigned) a[i] - (unsigned) b[i]))
+SCALAR_KERNEL(mul, (int) ((unsigned) a[i] * (unsigned) b[i]))
+SCALAR_KERNEL(lt, a[i] < b[i])
+SCALAR_KERNEL(gt, a[i] > b[i])
+SCALAR_KERNEL(le, a[i] <= b[i])
+SCALAR_KERNEL(ge, a[i] >= b[i])
+SCALAR_KERNEL(eq, a[i] == b[i])
+SCALAR_KERNEL(ne, a[i] != b[i])
+
+static void div_scalar(int *dst, const int *a, const int *b, int n, unsigned char *status) {
+   for (int i = 0; i < n; i++) {
+      if (b[i] == 0) {
+         FAIL(i, PARSE_DIVIDE_BY_ZERO);
+         dst[i] = 0;
+      } else if (b[i] == -1 && a[i] == INT_MIN) {
+         FAIL(i, PARSE_OVERFLOW);
+         dst[i] = 0;
+      } else {
+         dst[i] = a[i] / b[i];
+      }
+   }
+}
+
+static void pow_scalar(int *dst, const int *a, const int *b, int n, unsigned char *status) {
+   for (int i = 0; i < n; i++) {
+      if (!ipow(a[i], b[i], &dst[i])) {
+         FAIL(i, PARSE_OVERFLOW);
+         dst[i] = 0;
+      }
+   }
+}
+
+#ifdef COL_X86
+/*
+ * AVX2 kernels, eight rows a step, with the scalar kernel for the rest.
+ * Comparisons turn the all-ones lanes of a compare into 1 with an AND,
+ * and the negated ones (<=, >=, !=) with an ANDNOT.
+ */
+#define AVX2_KERNEL(name, expression)                                           \
+   __attribute__((target("avx2")))                                             \
+   static void name##_avx2(int *dst, const int *a, const int *b, int n,        \
+                           unsigned char *status) {                            \
+      const __m256i one = _mm256_set1_epi32(1);                                \
+      int i = 0;                                                               \
+      (void) one;                                                              \
+      for (; i + 8 <= n; i += 8) {                                             \
+         __m256i x = _mm256_loadu_si256((const __m256i *) (a + i));            \
+         __m256i y = _mm256_loadu_si256((const __m256i *) (b + i));            \
+         _mm256_storeu_si256((__m256i *) (dst + i), (expression));             \
+      }                                                                        \
+      name##_scalar(dst + i, a + i, b + i, n - i, status + i);                 \
+   }
+
+AVX2_KERNEL(add, _mm256_add_epi32(x, y))
+AVX2_KERNEL(sub, _mm256_sub_epi32(x, y))
+AVX2_KERNEL(mul, _mm256_mullo_epi32(x, y))
+AVX2_KERNEL(lt, _mm256_and_si256(_mm256_cmpgt_epi32(y, x), one))
+AVX2_KERNEL(gt, _mm256_and_si256(_mm256_cmpgt_epi32(x, y), one))
+AVX2_KERNEL(le, _mm256_andnot_si256(_mm256_cmpgt_epi32(x, y), one))
+AVX2_KERNEL(ge, _mm256_andnot_si256(_mm256_cmpgt_epi32(y, x), one))
+AVX2_KERNEL(eq, _mm256_and_si256(_mm256_cmpeq_epi32(x, y), one))
+AVX2_KERNEL(ne, _mm256_andnot_si256(_mm256_cmpeq_epi32(x, y), one))
+
+/**
+ * Truncating division of four ints through doubles. A double holds every
+ * int exactly and the rounded quotient of two of them never reaches the
+ * next integer, so truncating it gives the integer quotient.
+ */
+__attribute__((target("avx2")))
+static inline __m128i div4(__m128i x, __m128i y) {
+   return _mm256_cvttpd_epi32(_mm256_div_pd(_mm256_cvtepi32_pd(x), _mm256_cvtepi32_pd(y)));
+}
+
+/**
+ * AVX2 '/'. Rows dividing by 0, or INT_MIN by -1, divide by 1 instead
+ * and are then failed and zeroed. Their statuses are worked out before
+ * the store, since dst may be the register a or b is in.
+ */
+__attribute__((target("avx2")))
+static void div_avx2(int *dst, const int *a, const int *b, int n, unsigned char *status) {
+   const __m256i zero = _mm256_setzero_si256(), one = _mm256_set1_epi32(1);
+   const __m256i minus_one = _mm256_set1_epi32(-1), min = _mm256_set1_epi32(INT_MIN);
+   int i = 0;
+
+   for (; i + 8 <= n; i += 8) {
+      __m256i x = _mm256_loadu_si256((const __m256i *) (a + i));
+      __m256i y = _mm256_loadu_si256((const __m256i *) (b + i));
+      __m256i by_zero = _mm256_cmpeq_epi32(y, zero);
+      __m256i bad = _mm256_or_si256(by_zero,
+                                    _mm256_and_si256(_mm256_cmpeq_epi32(y, minus_one),
+                                                     _mm256_cmpeq_epi32(x, min)));
+      int lanes = _mm256_movemask_ps(_mm256_castsi256_ps(bad));
+      int zero_lanes = _mm256_movemask_ps(_mm256_castsi256_ps(by_zero));
+      __m256i q;
+
+      y = _mm256_blendv_epi8(y, one, bad);
+      q = _mm256_set_m128i(div4(_mm256_extracti128_si256(x, 1), _mm256_extracti128_si256(y, 1)),
+                           div4(_mm256_castsi256_si128(x), _mm256_castsi256_si128(y)));
+      _mm256_storeu_si256((__m256i *) (dst + i), _mm256_andnot_si256(bad, q));
+      for (; lanes != 0; lanes &= lanes - 1) {
+         int k = __builtin_ctz(lanes);
+         FAIL(i + k, zero_lanes >> k & 1 ? PARSE_DIVIDE_BY_ZERO : PARSE_OVERFLOW);
+      }
+   }
+   div_scalar(dst + i, a + i, b + i, n - i, status + i);
+}
+#endif /* COL_X86 */
+
+static col_kernel *kernels[TOKEN_KIND_COUNT] = {
+   [ADD_OP] = add_scalar, [SUB_OP] = sub_scalar, [MULT_OP] = mul_scalar,
+   [DIV_OP] = div_scalar, [EXPON_OP] = pow_scalar,
+   [LESS_THAN_OP] = lt_scalar, [GREATER_THAN_OP] = gt_scalar,
+   [LESS_THAN_OR_EQUAL_OP] = le_scalar, [GREATER_THAN_OR_EQUAL_OP] = ge_scalar,
+   [EQUALS_OP] = eq_scalar, [NOT_EQUALS_OP] = ne_scalar
+};
+
+/**
+ * Switches the kernels to the given level, or the best level below it
+ * that this CPU supports. There are no SSE2 kernels, since SSE2 lacks a
+ * 32-bit multiply, so SCAN_SSE2 gets the scalar ones.
+ * @param level: the highest level wanted
+ * @return: the level now in use
+ */
+enum scan_level col_select(enum scan_level level) {
+   kernels[ADD_OP] = add_scalar;
+   kernels[SUB_OP] = sub_scalar;
+   kernels[MULT_OP] = mul_scalar;
+   kernels[DIV_OP] = div_scalar;
+   kernels[LESS_THAN_OP] = lt_scalar;
+   kernels[GREATER_THAN_OP] = gt_scalar;
+   kernels[LESS_THAN_OR_EQUAL_OP] = le_scalar;
+   kernels[GREATER_THAN_OR_EQUAL_OP] = ge_scalar;
+   kernels[EQUALS_OP] = eq_scalar;
+   kernels[NOT_EQUALS_OP] = ne_scalar;
+#ifdef COL_X86
+   __builtin_cpu_init();
+   if (level >= SCAN_AVX2 && __builtin_cpu_supports("avx2")) {
+      kernels[ADD_OP] = add_avx2;
+      kernels[SUB_OP] = sub_avx2;
+      kernels[MULT_OP] = mul_avx2;
+      kernels[DIV_OP] = div_avx2;
+      kernels[LESS_THAN_OP] = lt_avx2;
+      kernels[GREATER_THAN_OP] = gt_avx2;
+      kernels[LESS_THAN_OR_EQUAL_OP] = le_avx2;
+      kernels[GREATER_THAN_OR_EQUAL_OP] = ge_avx2;
+      kernels[EQUALS_OP] = eq_avx2;
+      kernels[NOT_EQUALS_OP] = ne_avx2;
+      return SCAN_AVX2;
+   }
+#else
+   (void) level;
+#endif
+   return SCAN_SCALAR;
+}
+
+#ifdef COL_X86
+/**
+ * Picks the best kernels before main() runs.
+ */
+__attribute__((constructor))
+static void col_init(void) {
+   col_select(SCAN_AVX2);
+}
+#endif
+
+/**
+ * Runs a program over every row of its input columns.
+ * @param prog: a program filled by col_compile()
+ * @param columns: one column per variable, in col_variable() order
+ * @param rows: the number of rows in every column
+ * @param out: set to the value of each row, or 0 where it failed
+ * @param status: set to each row's enum parse_status, or NULL
+ * @return: the number of rows that failed, or -1 if out of memory
+ */
+long col_eval(const struct col_program *prog, const int *const *columns, size_t rows,
+              int *out, unsigned char *status) {
+   unsigned char block_status[COL_BLOCK];
+   int *registers, *constants;
+   size_t row;
+   long failed = 0;
+   int i, j, n;
+
+   registers = malloc(((size_t) prog->registers + prog->constant_count) * COL_BLOCK * sizeof(int) + 1);
+   if (registers == NULL)
+      return -1;
+   constants = registers + (size_t) prog->registers * COL_BLOCK;
+   for (i = 0; i < prog->constant_count; i++) {
+      for (j = 0; j < COL_BLOCK; j++)
+         constants[i * COL_BLOCK + j] = prog->constants[i];
+   }
+
+   for (row = 0; row < rows; row += COL_BLOCK) {
+      n = rows - row < COL_BLOCK ? (int) (rows - row) : COL_BLOCK;
+      if (prog->may_fail)
+         memset(block_status, PARSE_OK, n);
+
+      for (i = 0; i < prog->length; i++) {
+         const struct col_instr *instr = &prog->code[i];
+         const int *operand[2];
+         const struct col_operand *source[2] = { &instr->a, &instr->b };
+
+         for (j = 0; j < 2; j++) {
+            int index = source[j]->index;
+            switch (source[j]->source) {
+               case COL_REGISTER: operand[j] = registers + (size_t) index * COL_BLOCK; break;
+               case COL_COLUMN: operand[j] = columns[index] + row; break;
+               default: operand[j] = constants + (size_t) index * COL_BLOCK; break;
+            }
+         }
+         // the last instruction leaves the result, so it writes out directly
+         kernels[instr->op](i == prog->length - 1 ? out + row
+                                                  : registers + (size_t) instr->dst * COL_BLOCK,
+                            operand[0], operand[1], n, block_status);
+      }
+      if (prog->length == 0) {
+         if (prog->result.source == COL_COLUMN)
+            memcpy(out + row, columns[prog->result.index] + row, n * sizeof(int));
+         else
+            memcpy(out + row, constants + (size_t) prog->result.index * COL_BLOCK, n * sizeof(int));
+      }
+
+      if (prog->may_fail) {
+         for (j = 0; j < n; j++) {
+            if (block_status[j] != PARSE_OK) {
+               out[row + j] = 0;
+               failed++;
+            }
+         }
+         if (status != NULL)
+            memcpy(status + row, block_status, n);
+      } else if (status != NULL) {
+         memset(status + row, PARSE_OK, n);
+      }
+   }
+   free(registers);
+   return failed;
+}
@@ -0,0 +1,62 @@
+#ifndef COLUMNAR_H
+#define COLUMNAR_H
+/*
+ * Purpose: Compile a <bexpr> whose operands may be variables once, then
+ *          evaluate it over columns of integers, a block of rows and one
+ *          operator at a time, with vector kernels chosen at run time.
+ * Date:    2025 May 7
+ */
+#include <stddef.h>
+#include "parser.h"
+#include "scan.h"
+
+#define COL_BLOCK 1024   // rows each operator is applied to at a time
+
+// Where an operand comes from
+enum col_source {
+   COL_REGISTER,     // a block of intermediate results
+   COL_COLUMN,       // an input column, by variable number
+   COL_CONSTANT      // an integer literal, by constant number
+};
+
+struct col_operand {
+   enum col_source source;
+   int index;
+};
+
+/*
+ * One operator applied to a block: dst = a op b. The registers a
+ * program uses are numbered by operand stack depth, as in bytecode.c,
+ * so a program needs only as many as its deepest subexpression.
+ */
+struct col_instr {
+   int op;                  // the operator's token kind
+   int dst;                 // register the result goes to
+   struct col_operand a;
+   struct col_operand b;
+};
+
+struct col_program {
+   struct col_instr *code;
+   int length;              // instructions used
+   int capacity;            // instructions allocated
+   int *constants;          // values of the literals
+   int constant_count;
+   int constant_capacity;
+   char **names;            // variables, in order of first use
+   int name_count;
+   int name_capacity;
+   int depth;               // operand stack depth while compiling
+   int registers;           // registers col_eval() needs
+   bool may_fail;           // has a '/' or '^', which can fail on a row
+   struct col_operand result;
+};
+
+void col_program_init(struct col_program *);
+void col_program_free(struct col_program *);
+bool col_compile(struct parser_state *, struct col_program *);
+int col_variable(const struct col_program *, const char *);
+long col_eval(const struct col_program *, const int *const *, size_t, int *, unsigned char *);
+enum scan_level col_select(enum scan_level);
+
+#endif
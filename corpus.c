@@ -0,0 +1,260 @@
+/*
+ * corpus.c - generates random statements from the grammar in parser.c
+ * for the benchmarks. gen_corpus() uses rand(), so callers seed with srand()
+ * to get the same corpus on every run; gen_corpus_with() takes its seed,
+ * and knobs for the shape of the statements, in a corpus_options.
+ * Date:   2025 April 24
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include "corpus.h"
+
+/**
+ * Appends a random expression of at most the given depth to out. Divisors
+ * are non-zero literals and always end the expression, since comparisons
+ * bind tighter than '/' and "x / 3 == 2" would divide by zero.
+ * @param out: where to write the expression
+ * @param depth: how many levels of parentheses are allowed
+ * @return: the new end of out
+ */
+char *gen_expr(char *out, int depth) {
+   static const char *ops[] = { "+", "-", "*", "<", ">=", "==" };
+   int terms = 1 + rand() % 4, i;
+
+   for (i = 0; i < terms; i++) {
+      if (i > 0) {
+         if (rand() % 8 == 0) {
+            out += sprintf(out, " / %d", 1 + rand() % 9);
+            break;
+         }
+         out += sprintf(out, " %s ", ops[rand() % 6]);
+      }
+      if (depth > 0 && rand() % 3 == 0) {
+         *out++ = '(';
+         out = gen_expr(out, depth - 1);
+         *out++ = ')';
+      } else {
+         out += sprintf(out, "%d", rand() % 100);
+      }
+   }
+   *out = '\0';
+   return out;
+}
+
+/**
+ * Generates count statements, one per line, each a depth-3 expression.
+ * @param count: the number of statements
+ * @param length: set to the number of bytes generated
+ * @return: the NUL-terminated corpus, or NULL if out of memory
+ */
+char *gen_corpus(int count, size_t *length) {
+   char *input = malloc((size_t) count * CORPUS_MAX_STMT + 1), *end;
+   int i;
+
+   if (input == NULL)
+      return NULL;
+   end = input;
+   *end = '\0';
+   for (i = 0; i < count; i++) {
+      end = gen_expr(end, 3);
+      end += sprintf(end, ";\n");
+   }
+   *length = end - input;
+   return input;
+}
+
+/*
+ * One gen_corpus_with() run: the options, the state of its random
+ * numbers, and the text so far, which grows as needed.
+ */
+struct generator {
+   const struct corpus_options *opt;
+   unsigned long long state;
+   int mix_total;
+   char *text;
+   size_t length;
+   size_t capacity;
+};
+
+// Room a token and the whitespace before it can take
+#define TOKEN_ROOM 32
+
+/**
+ * A random number below n, from xorshift64*, so a seed gives the same
+ * corpus whatever the C library's rand() does.
+ */
+static int below(struct generator *g, int n) {
+   g->state ^= g->state >> 12;
+   g->state ^= g->state << 25;
+   g->state ^= g->state >> 27;
+   return (int) ((g->state * 0x2545F4914F6CDD1DULL) >> 33) % n;
+}
+
+/**
+ * Makes room for one more token.
+ * @return: false if out of memory
+ */
+static bool reserve(struct generator *g) {
+   if (g->length + TOKEN_ROOM > g->capacity) {
+      size_t capacity = g->capacity * 2 + 4096;
+      char *text = realloc(g->text, capacity);
+      if (text == NULL)
+         return false;
+      g->text = text;
+      g->capacity = capacity;
+   }
+   return true;
+}
+
+/**
+ * Appends a token, after whitespace as often as opt->spaces asks.
+ * @return: false if out of memory
+ */
+static bool put(struct generator *g, const char *token) {
+   static const char blanks[] = "  \t\n";
+   int n;
+
+   if (!reserve(g))
+      return false;
+   if (below(g, 100) < g->opt->spaces) {
+      for (n = 1 + below(g, 3); n > 0; n--)
+         g->text[g->length++] = blanks[below(g, 4)];
+   }
+   while (*token != '\0')
+      g->text[g->length++] = *token++;
+   return true;
+}
+
+/**
+ * Appends a literal of 1 to opt->digits digits, at least min.
+ * @return: false if out of memory
+ */
+static bool literal(struct generator *g, int min) {
+   char digits[16];
+   int width = 1 + below(g, g->opt->digits), value = 0, i;
+
+   for (i = 0; i < width; i++)
+      value = value * 10 + below(g, 10);
+   sprintf(digits, "%d", value < min ? min : value);
+   return put(g, digits);
+}
+
+// Picks a class of operator by the weights in opt->mix
+static enum corpus_op pick_op(struct generator *g) {
+   int r = below(g, g->mix_total), op;
+
+   for (op = 0; r >= g->opt->mix[op]; op++)
+      r -= g->opt->mix[op];
+   return (enum corpus_op) op;
+}
+
+/**
+ * Appends an <expr> of 1 to opt->terms operands, each a literal or, while
+ * depth allows, a parenthesized <expr>. As in gen_expr(), a division
+ * ends the <expr>, so no comparison can turn its divisor into 0.
+ * @return: false if out of memory
+ */
+static bool gen_level(struct generator *g, int depth) {
+   static const char *compare[] = { "<", ">", "<=", ">=", "==", "!=" };
+   int terms = 1 + below(g, g->opt->terms), i;
+   bool exponent;
+
+   for (i = 0; i < terms; i++) {
+      exponent = false;
+      if (i > 0) {
+         switch (pick_op(g)) {
+            case CORPUS_ADD:
+               if (!put(g, below(g, 2) ? "+" : "-"))
+                  return false;
+               break;
+            case CORPUS_MUL:
+               if (!put(g, "*"))
+                  return false;
+               break;
+            case CORPUS_DIV:
+               return put(g, "/") && literal(g, 1);
+            case CORPUS_POW:
+               if (!put(g, "^"))
+                  return false;
+               exponent = true;
+               break;
+            default:
+               if (!put(g, compare[below(g, 6)]))
+                  return false;
+         }
+      }
+      if (exponent) {
+         if (!put(g, below(g, 2) ? "1" : "0"))
+            return false;
+      } else if (depth > 0 && below(g, 3) == 0) {
+         if (!put(g, "(") || !gen_level(g, depth - 1) || !put(g, ")"))
+            return false;
+      } else if (!literal(g, 0)) {
+         return false;
+      }
+   }
+   return true;
+}
+
+/**
+ * The options gen_corpus() comes closest to: a seed, 100000 statements
+ * of up to 4 operands over 3 levels, mostly '+' and '-'.
+ * @param opt: set to the defaults
+ */
+void corpus_defaults(struct corpus_options *opt) {
+   static const int mix[CORPUS_OPS] = {
+      [CORPUS_ADD] = 40, [CORPUS_MUL] = 20, [CORPUS_DIV] = 10,
+      [CORPUS_POW] = 5, [CORPUS_COMPARE] = 25
+   };
+
+   opt->seed = 352;
+   opt->statements = 100000;
+   opt->terms = 4;
+   opt->depth = 3;
+   memcpy(opt->mix, mix, sizeof(mix));
+   opt->digits = 2;
+   opt->spaces = 50;
+}
+
+/**
+ * Generates opt->statements statements, one per line.
+ * @param opt: what to generate; out of range knobs are clamped
+ * @param length: set to the number of bytes generated
+ * @return: the NUL-terminated corpus, or NULL if out of memory
+ */
+char *gen_corpus_with(const struct corpus_options *opt, size_t *length) {
+   struct corpus_options fixed = *opt;
+   struct generator g = { &fixed, 0, 0, NULL, 0, 0 };
+   int i;
+
+   fixed.terms = fixed.terms < 1 ? 1 : fixed.terms;
+   fixed.depth = fixed.depth < 0 ? 0 : fixed.depth;
+   fixed.digits = fixed.digits < 1 ? 1 : fixed.digits > 9 ? 9 : fixed.digits;
+   for (i = 0; i < CORPUS_OPS; i++) {
+      fixed.mix[i] = fixed.mix[i] < 0 ? 0 : fixed.mix[i];
+      g.mix_total += fixed.mix[i];
+   }
+   if (g.mix_total == 0) {
+      fixed.mix[CORPUS_ADD] = 1;
+      g.mix_total = 1;
+   }
+   g.state = fixed.seed * 0x9E3779B97F4A7C15ULL + 1; // never 0
+
+   for (i = 0; i < fixed.statements; i++) {
+      if (!gen_level(&g, fixed.depth) || !put(&g, ";")) {
+         free(g.text);
+         return NULL;
+      }
+      g.text[g.length++] = '\n';
+   }
+   if (!reserve(&g)) {
+      free(g.text);
+      return NULL;
+   }
+   g.text[g.length] = '\0';
+   *length = g.length;
+   return g.text;
+}
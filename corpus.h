@@ -0,0 +1,42 @@
+#ifndef CORPUS_H
+#define CORPUS_H
+/*
+ * Purpose: Random well-formed statements for the benchmarks.
+ * Date:    2025 April 24
+ */
+#include <stddef.h>
+
+// Upper bound on the text gen_expr() writes for one depth-3 expression
+#define CORPUS_MAX_STMT 512
+
+// Classes of operators, for corpus_options.mix
+enum corpus_op {
+   CORPUS_ADD,       // + and -
+   CORPUS_MUL,       // *
+   CORPUS_DIV,       // / by a non-zero literal
+   CORPUS_POW,       // ^ 0 or ^ 1, which cannot overflow
+   CORPUS_COMPARE,   // < > <= >= == !=
+   CORPUS_OPS
+};
+
+/*
+ * What gen_corpus_with() generates. Every statement it writes is
+ * well-formed and evaluates without error, and the same options give
+ * the same bytes on every machine.
+ */
+struct corpus_options {
+   unsigned long long seed;
+   int statements;
+   int terms;              // operands in each (sub)expression, 1 to terms
+   int depth;              // levels of parentheses allowed
+   int mix[CORPUS_OPS];    // relative weight of each class of operator
+   int digits;             // widest literal, 1 to 9 digits
+   int spaces;             // percent of gaps between tokens with whitespace
+};
+
+char *gen_expr(char *, int);
+char *gen_corpus(int, size_t *);
+void corpus_defaults(struct corpus_options *);
+char *gen_corpus_with(const struct corpus_options *, size_t *);
+
+#endif
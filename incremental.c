@@ -0,0 +1,323 @@
+/*
+ * incremental.c - evaluates a statement stream against the cache from
+ * the previous run. Statements whose text is unchanged take their value
+ * and tokens from the cache; only new or edited statements are lexed
+ * and evaluated. The cache for the next run is built along the way.
+ * Date:   2025 May 3
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "parser.h"
+#include "incremental.h"
+
+// Bytes before the entries in a cache file: magic, padding, three counts
+#define FILE_HEADER 32
+
+/**
+ * Sets up an empty cache.
+ * @param sc: the cache to initialize
+ * @return: false if out of memory
+ */
+bool stmt_cache_init(struct stmt_cache *sc) {
+   sc->count = 0;
+   sc->capacity = 1024;
+   sc->entries = malloc(sc->capacity * sizeof(struct stmt_entry));
+   sc->table = NULL;
+   sc->table_size = 0;
+   sc->text_length = 0;
+   sc->text_capacity = 64 * 1024;
+   sc->text = malloc(sc->text_capacity);
+   if (!tokcache_init(&sc->tokens, 64 * 1024) || sc->entries == NULL || sc->text == NULL) {
+      stmt_cache_free(sc);
+      return false;
+   }
+   return true;
+}
+
+/**
+ * Tells whether an entry is for the given statement text.
+ * @param sc: the cache holding the entry
+ * @param entry: the entry
+ * @param hash: hash_source() of the text
+ * @param text: the statement
+ * @param length: the number of bytes in the statement
+ * @return: true if the entry has exactly this text
+ */
+static bool same_statement(const struct stmt_cache *sc, const struct stmt_entry *entry,
+                           uint64_t hash, const char *text, uint32_t length) {
+   return entry->hash == hash && entry->length == length
+          && memcmp(sc->text + entry->text_offset, text, length) == 0;
+}
+
+/**
+ * Indexes the entries by hash. When two entries have the
+ * same statement, the first one is kept.
+ * @param sc: the cache to index
+ * @return: false if out of memory
+ */
+static bool build_table(struct stmt_cache *sc) {
+   int size = 16, i, slot;
+
+   while (size < 2 * sc->count)
+      size *= 2;
+   free(sc->table);
+   if ((sc->table = calloc(size, sizeof(int))) == NULL)
+      return false;
+   sc->table_size = size;
+   for (i = 0; i < sc->count; i++) {
+      slot = (int) (sc->entries[i].hash & (size - 1));
+      while (sc->table[slot] != 0) {
+         const struct stmt_entry *entry = &sc->entries[i];
+         if (same_statement(sc, &sc->entries[sc->table[slot] - 1], entry->hash,
+                            sc->text + entry->text_offset, entry->length))
+            break;
+         slot = (slot + 1) & (size - 1);
+      }
+      if (sc->table[slot] == 0)
+         sc->table[slot] = i + 1;
+   }
+   return true;
+}
+
+/**
+ * Finds the entry for a statement. Most statements sit right where they
+ * were last run, just after the previous statement's entry or one past
+ * it when a statement was replaced or removed, so those two are tried
+ * before the table. The table is only built once it is needed.
+ * @param sc: the cache to search
+ * @param hint: the entry after the last one found, or NULL
+ * @param hash: hash_source() of the statement
+ * @param text: the statement
+ * @param length: the number of bytes in the statement
+ * @return: the entry, or NULL if the statement is not cached
+ */
+static const struct stmt_entry *lookup(struct stmt_cache *sc, const struct stmt_entry *hint,
+                                       uint64_t hash, const char *text, uint32_t length) {
+   const struct stmt_entry *end = sc->entries + sc->count;
+   int slot;
+
+   for (int i = 0; hint != NULL && i < 2 && hint + i < end; i++) {
+      if (same_statement(sc, &hint[i], hash, text, length))
+         return &hint[i];
+   }
+   if (sc->count == 0 || (sc->table_size == 0 && !build_table(sc)))
+      return NULL;
+   slot = (int) (hash & (sc->table_size - 1));
+   while (sc->table[slot] != 0) {
+      const struct stmt_entry *entry = &sc->entries[sc->table[slot] - 1];
+      if (same_statement(sc, entry, hash, text, length))
+         return entry;
+      slot = (slot + 1) & (sc->table_size - 1);
+   }
+   return NULL;
+}
+
+/**
+ * Reads the cache saved by the previous run.
+ * @param sc: the cache to fill
+ * @param path: the cache file
+ * @return: false if there is no usable cache file, leaving sc empty
+ */
+bool stmt_cache_load(struct stmt_cache *sc, const char *path) {
+   unsigned char header[FILE_HEADER];
+   uint64_t count, token_bytes, text_bytes;
+   FILE *file;
+   int i;
+
+   if (!stmt_cache_init(sc))
+      return false;
+   if ((file = fopen(path, "rb")) == NULL)
+      return false;
+   if (fread(header, 1, FILE_HEADER, file) != FILE_HEADER
+       || memcmp(header, STMT_CACHE_MAGIC, 4) != 0) {
+      fclose(file);
+      return false;
+   }
+   memcpy(&count, header + 8, 8);
+   memcpy(&token_bytes, header + 16, 8);
+   memcpy(&text_bytes, header + 24, 8);
+
+   free(sc->entries);
+   free(sc->text);
+   tokcache_free(&sc->tokens);
+   sc->entries = count < (uint64_t) INT32_MAX ? malloc(count * sizeof(struct stmt_entry) + 1) : NULL;
+   sc->capacity = (int) count;
+   sc->text = text_bytes < SIZE_MAX ? malloc(text_bytes + 1) : NULL;
+   sc->text_capacity = (size_t) text_bytes + 1;
+   if (sc->entries == NULL || sc->text == NULL || !tokcache_init(&sc->tokens, token_bytes)
+       || fread(sc->entries, sizeof(struct stmt_entry), count, file) != count
+       || fread(sc->tokens.data + sc->tokens.length, 1, token_bytes, file) != token_bytes
+       || fread(sc->text, 1, text_bytes, file) != text_bytes) {
+      fclose(file);
+      stmt_cache_free(sc);
+      stmt_cache_init(sc);
+      return false;
+   }
+   fclose(file);
+   sc->tokens.length += token_bytes;
+   sc->text_length = (size_t) text_bytes;
+   sc->count = (int) count;
+
+   // never trust an entry to point outside the tokens or the text
+   for (i = 0; i < sc->count; i++) {
+      if (sc->entries[i].token_offset > token_bytes
+          || sc->entries[i].token_length > token_bytes - sc->entries[i].token_offset
+          || sc->entries[i].text_offset > text_bytes
+          || sc->entries[i].length > text_bytes - sc->entries[i].text_offset) {
+         sc->count = 0;
+         return false;
+      }
+   }
+   return true;
+}
+
+/**
+ * Writes the cache for the next run.
+ * @param sc: the cache to save
+ * @param path: the cache file
+ * @return: false if the file could not be written
+ */
+bool stmt_cache_save(const struct stmt_cache *sc, const char *path) {
+   unsigned char header[FILE_HEADER] = { 0 };
+   uint64_t count = (uint64_t) sc->count;
+   uint64_t token_bytes = sc->tokens.length - TOKCACHE_HEADER;
+   uint64_t text_bytes = sc->text_length;
+   FILE *file = fopen(path, "wb");
+   bool saved;
+
+   if (file == NULL)
+      return false;
+   memcpy(header, STMT_CACHE_MAGIC, 4);
+   memcpy(header + 8, &count, 8);
+   memcpy(header + 16, &token_bytes, 8);
+   memcpy(header + 24, &text_bytes, 8);
+   saved = fwrite(header, 1, FILE_HEADER, file) == FILE_HEADER
+           && fwrite(sc->entries, sizeof(struct stmt_entry), count, file) == count
+           && fwrite(tokcache_tokens(&sc->tokens), 1, token_bytes, file) == token_bytes
+           && fwrite(sc->text, 1, text_bytes, file) == text_bytes;
+   if (fclose(file) != 0 || !saved) {
+      remove(path);
+      return false;
+   }
+   return true;
+}
+
+/**
+ * Frees the cache.
+ * @param sc: the cache to free
+ */
+void stmt_cache_free(struct stmt_cache *sc) {
+   free(sc->entries);
+   free(sc->table);
+   free(sc->text);
+   tokcache_free(&sc->tokens);
+   sc->entries = NULL;
+   sc->table = NULL;
+   sc->text = NULL;
+   sc->count = sc->capacity = sc->table_size = 0;
+   sc->text_length = sc->text_capacity = 0;
+}
+
+/**
+ * Adds an entry to the end of the cache.
+ * @param sc: the cache
+ * @param entry: the entry to add
+ * @return: false if out of memory
+ */
+static bool add_entry(struct stmt_cache *sc, const struct stmt_entry *entry) {
+   if (sc->count == sc->capacity) {
+      int capacity = sc->capacity > 0 ? 2 * sc->capacity : 1024;
+      struct stmt_entry *bigger = realloc(sc->entries, capacity * sizeof(struct stmt_entry));
+      if (bigger == NULL)
+         return false;
+      sc->entries = bigger;
+      sc->capacity = capacity;
+   }
+   sc->entries[sc->count++] = *entry;
+   return true;
+}
+
+/**
+ * Adds a statement's text to the end of the cache's text.
+ * @param sc: the cache
+ * @param text: the statement
+ * @param length: the number of bytes in the statement
+ * @return: false if out of memory
+ */
+static bool add_text(struct stmt_cache *sc, const char *text, size_t length) {
+   if (length > sc->text_capacity - sc->text_length) {
+      size_t capacity = sc->text_capacity > 0 ? 2 * sc->text_capacity : 64 * 1024;
+      char *bigger;
+      while (length > capacity - sc->text_length)
+         capacity *= 2;
+      if ((bigger = realloc(sc->text, capacity)) == NULL)
+         return false;
+      sc->text = bigger;
+      sc->text_capacity = capacity;
+   }
+   memcpy(sc->text + sc->text_length, text, length);
+   sc->text_length += length;
+   return true;
+}
+
+/**
+ * Evaluates every statement in the batch. A statement found in old
+ * gets its value and tokens from there; any other statement is lexed
+ * once into fresh and evaluated from those tokens. Statements that are
+ * reused print none of the errors they printed when first evaluated.
+ * @param batch: a batch filled by batch_split(); results are set
+ * @param old: the cache from the previous run, possibly empty
+ * @param fresh: an empty cache that gets every statement of this run
+ * @param stats: counts of reused and evaluated statements, or NULL
+ * @return: the number of statements, or -1 if out of memory
+ */
+int incr_eval(struct statement_batch *batch, struct stmt_cache *old,
+              struct stmt_cache *fresh, struct incr_stats *stats) {
+   struct parser_state ps;
+   struct incr_stats counts = { 0, 0 };
+   const struct stmt_entry *cached, *hint = NULL;
+   struct eval_result result;
+   int i;
+
+   for (i = 0; i < batch->count; i++) {
+      char *start = batch->stmts[i] + strspn(batch->stmts[i], " \t\n");
+      struct stmt_entry entry;
+
+      entry.length = (uint32_t) strlen(start);
+      entry.hash = hash_source(start, entry.length);
+      entry.token_offset = fresh->tokens.length - TOKCACHE_HEADER;
+      entry.text_offset = fresh->text_length;
+      if (!add_text(fresh, start, entry.length))
+         return -1;
+      cached = lookup(old, hint, entry.hash, start, entry.length);
+      if (cached != NULL) {
+         hint = cached + 1;
+         if (!tokcache_copy(&fresh->tokens, tokcache_tokens(&old->tokens) + cached->token_offset,
+                            cached->token_length))
+            return -1;
+         entry.result = cached->result;
+         entry.status = cached->status;
+         counts.reused++;
+      } else {
+         if (!tokcache_append(&fresh->tokens, start, entry.length))
+            return -1;
+         parser_init_tokens(&ps, start, entry.length,
+                            tokcache_tokens(&fresh->tokens) + entry.token_offset,
+                            fresh->tokens.data + fresh->tokens.length);
+         result = bexpr(&ps);
+         entry.result = result.value;
+         entry.status = result.status;
+         counts.evaluated++;
+      }
+      entry.token_length = (uint32_t) (fresh->tokens.length - TOKCACHE_HEADER - entry.token_offset);
+      if (!add_entry(fresh, &entry))
+         return -1;
+      batch->results[i].value = entry.result;
+      batch->results[i].status = (enum parse_status) entry.status;
+   }
+   if (stats != NULL)
+      *stats = counts;
+   return batch->count;
+}
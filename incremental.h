@@ -0,0 +1,61 @@
+#ifndef INCREMENTAL_H
+#define INCREMENTAL_H
+/*
+ * Purpose: Re-evaluate only the statements of a file that changed since
+ *          the last run, using an on-disk cache keyed by statement hash.
+ * Date:    2025 May 3
+ */
+#include <stdbool.h>
+#include <stdint.h>
+#include "parallel.h"
+#include "tokcache.h"
+
+#define STMT_CACHE_MAGIC "STC4"
+
+/*
+ * What the cache knows about one statement. A statement is hashed from
+ * its first lexeme through its ';', so blank lines and indentation
+ * before it do not count as changes. Its text is kept as well, so a
+ * hash collision is never taken for the same statement.
+ */
+struct stmt_entry {
+   uint64_t hash;            // hash_source() of the statement
+   uint64_t token_offset;    // where its tokens start in the token stream
+   uint64_t text_offset;     // where its text starts in the cache's text
+   uint32_t length;          // bytes in the statement
+   int32_t result;           // its bexpr() value, if status is PARSE_OK
+   uint32_t token_length;    // bytes of encoded tokens
+   uint32_t status;          // its bexpr() enum parse_status
+};
+
+/*
+ * Every statement of one run with its text, tokens and value. On disk
+ * it is the magic, the entry, token and text byte counts, the entries,
+ * the tokens and then the text, all in native byte order.
+ */
+struct stmt_cache {
+   struct stmt_entry *entries;
+   int count;
+   int capacity;
+   struct token_cache tokens;   // tokens of every entry, one after another
+   char *text;                  // text of every entry, one after another
+   size_t text_length;
+   size_t text_capacity;
+   int *table;                  // entry index + 1 by hash, 0 if empty
+   int table_size;              // a power of two, or 0 until needed
+};
+
+// What incr_eval() did
+struct incr_stats {
+   int reused;       // statements answered from the cache
+   int evaluated;    // statements lexed and evaluated
+};
+
+bool stmt_cache_init(struct stmt_cache *);
+bool stmt_cache_load(struct stmt_cache *, const char *);
+bool stmt_cache_save(const struct stmt_cache *, const char *);
+void stmt_cache_free(struct stmt_cache *);
+int incr_eval(struct statement_batch *, struct stmt_cache *, struct stmt_cache *,
+              struct incr_stats *);
+
+#endif
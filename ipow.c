@@ -0,0 +1,80 @@
+/*
+ * ipow.c - integer exponentiation by squaring with overflow detection.
+ * Replaces the libm pow() call, which went through double and gave wrong
+ * answers once a result no longer fit in 53 bits, and silently wrapped
+ * once it no longer fit in an int.
+ * Date:   2025 April 28
+ */
+
+#include <limits.h>
+#include "ipow.h"
+
+/**
+ * Multiplies two ints, detecting overflow.
+ * @return: false if the product does not fit in an int
+ */
+static inline bool mul_checked(int a, int b, int *product) {
+#if defined(__GNUC__)
+   return !__builtin_mul_overflow(a, b, product);
+#else
+   long long wide = (long long) a * b;
+   *product = (int) wide;
+   return wide >= INT_MIN && wide <= INT_MAX;
+#endif
+}
+
+/**
+ * Computes base ^ exponent in integer arithmetic. Small exponents, the
+ * common case, are multiplied out directly. A negative exponent gives
+ * the truncated value of 1 / base ^ -exponent, as pow() did.
+ * @param base: the base
+ * @param exponent: the exponent
+ * @param result: set to the power
+ * @return: false if the power does not fit in an int, or is 0 raised to
+ *          a negative exponent
+ */
+bool ipow(int base, int exponent, int *result) {
+   int square;
+
+   switch (exponent) {
+      case 0:
+         *result = 1;
+         return true;
+      case 1:
+         *result = base;
+         return true;
+      case 2:
+         return mul_checked(base, base, result);
+      case 3:
+         return mul_checked(base, base, &square) && mul_checked(square, base, result);
+      case 4:
+         return mul_checked(base, base, &square) && mul_checked(square, square, result);
+   }
+
+   if (exponent < 0) {
+      if (base == 0)
+         return false;
+      if (base == 1 || base == -1)
+         *result = (base == -1 && (exponent & 1)) ? -1 : 1;
+      else
+         *result = 0;
+      return true;
+   }
+
+   // 0, 1 and -1 stay in range for any exponent
+   if (base >= -1 && base <= 1) {
+      *result = (base == -1 && !(exponent & 1)) ? 1 : base;
+      return true;
+   }
+
+   *result = 1;
+   for (;;) {
+      if ((exponent & 1) && !mul_checked(*result, base, result))
+         return false;
+      exponent >>= 1;
+      if (exponent == 0)
+         return true;
+      if (!mul_checked(base, base, &base))
+         return false;
+   }
+}
@@ -0,0 +1,11 @@
+#ifndef IPOW_H
+#define IPOW_H
+/*
+ * Purpose: Integer exponentiation for the '^' operator.
+ * Date:    2025 April 28
+ */
+#include <stdbool.h>
+
+bool ipow(int, int, int *);
+
+#endif
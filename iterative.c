@@ -0,0 +1,186 @@
+/*
+ * iterative.c - evaluates a <bexpr> by operator precedence with a stack
+ * of pending operators on the heap, shunting-yard style, in place of the
+ * recursive descent in parser.c. The precedence table
+ * below is the grammar at the top of parser.c flattened: each operator
+ * is reduced exactly when the recursive evaluator would apply it, so
+ * both give the same values and stop at the same first error.
+ * Date:   2025 May 6
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include "iterative.h"
+#include "ipow.h"
+
+// Entries each stack starts with once it is first used
+#define STACK_START 64
+
+/*
+ * Binding strength of each binary operator; 0 for every other token,
+ * which ends the operand chain. '^' is the only right-associative one.
+ * <ttail> +, -  <  <stail> *, /  <  <ftail> comparisons  <  <factor> ^
+ */
+static const unsigned char precedence[TOKEN_KIND_COUNT] = {
+   [ADD_OP] = 1, [SUB_OP] = 1,
+   [MULT_OP] = 2, [DIV_OP] = 2,
+   [LESS_THAN_OP] = 3, [LESS_THAN_OR_EQUAL_OP] = 3,
+   [GREATER_THAN_OP] = 3, [GREATER_THAN_OR_EQUAL_OP] = 3,
+   [EQUALS_OP] = 3, [NOT_EQUALS_OP] = 3,
+   [EXPON_OP] = 4
+};
+
+/**
+ * Sets up an empty stack.
+ * @param st: the stack to initialize
+ */
+void eval_stack_init(struct eval_stack *st) {
+   memset(st, 0, sizeof(*st));
+}
+
+/**
+ * Frees the stack.
+ * @param st: the stack to free
+ */
+void eval_stack_free(struct eval_stack *st) {
+   free(st->ops);
+   eval_stack_init(st);
+}
+
+/**
+ * Doubles the stack.
+ * @param ps: the parser state, for reporting running out of memory
+ * @param st: the stack, which is full
+ * @return: the moved entries, or NULL if out of memory
+ */
+static struct pending_op *grow(struct parser_state *ps, struct eval_stack *st) {
+   int capacity = st->capacity > 0 ? 2 * st->capacity : STACK_START;
+   struct pending_op *bigger = realloc(st->ops, capacity * sizeof(struct pending_op));
+
+   if (bigger == NULL) {
+      parse_error(ps, PARSE_OUT_OF_MEMORY, token_offset(ps), "ERROR: out of memory");
+      return NULL;
+   }
+   st->ops = bigger;
+   st->capacity = capacity;
+   return bigger;
+}
+
+/**
+ * Applies a binary operator with the same checks bexpr() makes.
+ * @param ps: the parser state, for reporting errors
+ * @param op: the operator
+ * @param a: the left operand
+ * @param b: the right operand
+ * @param result: set to the result
+ * @return: false on an error, which is reported at the operator
+ */
+static bool apply(struct parser_state *ps, const struct pending_op *op, int a, int b,
+                  int *result) {
+   switch (op->kind) {
+      case ADD_OP: *result = a + b; return true;
+      case SUB_OP: *result = a - b; return true;
+      case MULT_OP: *result = a * b; return true;
+      case DIV_OP:
+         if (b == 0) {
+            parse_error(ps, PARSE_DIVIDE_BY_ZERO, op->offset, "Math Error: division by zero");
+            return false;
+         }
+         if (b == -1 && a == INT_MIN) {
+            parse_error(ps, PARSE_OVERFLOW, op->offset, "Overflow Error: '/' result out of range");
+            return false;
+         }
+         *result = a / b;
+         return true;
+      case EXPON_OP:
+         if (ipow(a, b, result))
+            return true;
+         parse_error(ps, PARSE_OVERFLOW, op->offset, "Overflow Error: '^' result out of range");
+         return false;
+      default: *result = compare_values(op->kind, a, b); return true;
+   }
+}
+
+/**
+ * <expr>, with every level of the grammar handled by one loop. It
+ * alternates between reading an operand, which is any number of '('
+ * and then a number, and reading what follows it: an operator, a ')',
+ * or anything else, which ends the <expr>. The operand just read stays
+ * in value; the stack holds only operators still waiting for theirs.
+ * @param ps: the parser state
+ * @param st: the stack, whose old contents are ignored
+ * @return: the value of the <expr>; see ps->status
+ */
+static int iter_expr(struct parser_state *ps, struct eval_stack *st) {
+   struct pending_op *ops = st->ops;
+   int count = 0, value, kind, prec, min_prec;
+
+   for (;;) {
+      while (ps->lex.kind == LEFT_PAREN) {
+         if (count == st->capacity && (ops = grow(ps, st)) == NULL)
+            return 0;
+         ops[count].kind = LEFT_PAREN;
+         ops[count].offset = token_offset(ps);
+         count++;
+         next_token(ps);
+      }
+      if (ps->lex.kind != INT_LITERAL) {
+         parse_error(ps, PARSE_SYNTAX_ERROR, token_offset(ps), "Syntax Error: Expected a number");
+         return 0;
+      }
+      value = token_int(ps);
+      next_token(ps);
+
+      for (;;) {
+         kind = ps->lex.kind;
+         prec = precedence[kind];
+
+         // Apply what binds at least as tightly, except that '^' leaves
+         // an earlier '^' for later. Anything but an operator ends the
+         // operand chain, applying everything back to the last '('.
+         min_prec = prec == 0 ? 1 : kind == EXPON_OP ? prec + 1 : prec;
+         while (count > 0 && precedence[ops[count - 1].kind] >= min_prec) {
+            count--;
+            if (!apply(ps, &ops[count], ops[count].left, value, &value))
+               return 0;
+         }
+
+         if (prec > 0) {
+            if (count == st->capacity && (ops = grow(ps, st)) == NULL)
+               return 0;
+            ops[count].kind = kind;
+            ops[count].left = value;
+            ops[count].offset = token_offset(ps);
+            count++;
+            next_token(ps);
+            break;
+         }
+         if (count == 0)
+            return value;
+         if (kind != RIGHT_PAREN) {
+            ps->is_right_paren_error = true;
+            parse_error(ps, PARSE_SYNTAX_ERROR, token_offset(ps), "Syntax Error: ')' expected");
+            return 0;
+         }
+         count--; // Pop the matching left parenthesis
+         next_token(ps); // Consume the right parenthesis
+      }
+   }
+}
+
+/**
+ * <bexpr> -> <expr> ;
+ * Evaluates the next <bexpr> like bexpr() does, using only heap memory
+ * that grows with the input, so depth is limited by memory alone.
+ * @param ps: the parser state, positioned at the start of a <bexpr>
+ * @param st: a stack set up by eval_stack_init(), reused across calls
+ * @return: the status of the evaluation and, if PARSE_OK, its value
+ */
+struct eval_result iter_bexpr(struct parser_state *ps, struct eval_stack *st) {
+   ps->is_right_paren_error = false;
+   ps->status = PARSE_OK;
+
+   return bexpr_finish(ps, iter_expr(ps, st));
+}
@@ -0,0 +1,35 @@
+#ifndef ITERATIVE_H
+#define ITERATIVE_H
+/*
+ * Purpose: Evaluate a <bexpr> with an explicit stack instead of recursion,
+ *          so no operator chain or nesting depth can overflow the C stack.
+ * Date:    2025 May 6
+ */
+#include <stddef.h>
+#include "parser.h"
+
+/*
+ * An operator waiting for its right operand, with its left operand
+ * already evaluated, or an open '('.
+ */
+struct pending_op {
+   int kind;          // token kind of the operator, or LEFT_PAREN
+   int left;          // value of the left operand
+   size_t offset;     // where it is in the input, for errors
+};
+
+/*
+ * The stack of pending operators. It starts empty, doubles whenever it
+ * fills, and keeps its memory from one statement to the next, so a run
+ * over many statements allocates only as deep as the deepest one.
+ */
+struct eval_stack {
+   struct pending_op *ops;
+   int capacity;
+};
+
+void eval_stack_init(struct eval_stack *);
+void eval_stack_free(struct eval_stack *);
+struct eval_result iter_bexpr(struct parser_state *, struct eval_stack *);
+
+#endif
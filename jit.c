@@ -0,0 +1,718 @@
+/*
+ * jit.c - compiles a <bexpr> to x86-64 machine code. The compile
+ * functions follow the grammar in parser.c one for one, like those in
+ * bytecode.c, but emit instructions where those emit opcodes. The value
+ * being computed is kept in eax and the left operands waiting for it on
+ * the machine stack, so a + (b) becomes
+ *
+ *    mov eax, a ; push rax ; mov eax, b ; mov ecx, eax ; pop rax ; add eax, ecx
+ *
+ * except that a right operand that is a single number is folded into
+ * the instruction, as add eax, b. Division checks for 0 and INT_MIN / -1
+ * and '^' calls ipow(); a failure jumps to an exit that returns false,
+ * and jit_bexpr() then hands the statement to bexpr(), which reports the
+ * error as it always has. Code is copied into mmap'd pages that are only
+ * writable while it is copied in.
+ * Date:   2025 May 11
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include "jit.h"
+#include "ipow.h"
+#include "tokcache.h"
+
+#if defined(__x86_64__) && (defined(__unix__) || defined(__APPLE__)) && !defined(JIT_NO_NATIVE)
+#define JIT_NATIVE
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+#define JIT_ENTRIES 64          // cache slots to start with; they double
+#define JIT_CHUNK (64 * 1024)   // bytes of executable memory mapped at a time
+
+#ifdef JIT_NATIVE
+
+/*
+ * What the j_* functions return on success: what is known about the
+ * code they emitted. Errors are ERROR.
+ */
+#define SHAPE_ANY 0        // nothing
+#define SHAPE_CONSTANT 1   // the code is a single mov eax, imm32
+
+#define JUMP_ALWAYS 0      // jmp rel32
+#define JUMP_IF_EQUAL 0x84 // je rel32, the second opcode byte
+
+// A function being compiled
+struct code {
+   unsigned char *bytes;
+   size_t length;
+   size_t capacity;
+   size_t *fails;       // offsets of the rel32 of jumps to the failure exit
+   int fail_count;
+   int fail_capacity;
+   int depth;           // operands pushed on the machine stack
+   bool out_of_memory;
+};
+
+static int j_expr(struct parser_state *, struct code *);
+
+/**
+ * Appends bytes to the code, growing it as needed. Once out of memory
+ * nothing more is appended, and the function is thrown away.
+ */
+static void emit(struct code *c, const void *bytes, size_t n) {
+   if (c->out_of_memory)
+      return;
+   if (c->length + n > c->capacity) {
+      size_t capacity = c->capacity ? c->capacity * 2 : 256;
+      unsigned char *grown = realloc(c->bytes, capacity);
+      if (grown == NULL) {
+         c->out_of_memory = true;
+         return;
+      }
+      c->bytes = grown;
+      c->capacity = capacity;
+   }
+   memcpy(c->bytes + c->length, bytes, n);
+   c->length += n;
+}
+
+#define EMIT(c, ...)                                                          \
+   do {                                                                       \
+      static const unsigned char emit_bytes[] = { __VA_ARGS__ };              \
+      emit(c, emit_bytes, sizeof(emit_bytes));                                \
+   } while (0)
+
+static void emit_u32(struct code *c, uint32_t value) {
+   unsigned char bytes[4] = { value, value >> 8, value >> 16, value >> 24 };
+   emit(c, bytes, 4);
+}
+
+/**
+ * Appends a jump to the failure exit, whose offset is filled in once
+ * the exit has been emitted.
+ * @param condition: JUMP_ALWAYS or JUMP_IF_EQUAL
+ */
+static void emit_fail(struct code *c, int condition) {
+   if (condition == JUMP_ALWAYS) {
+      EMIT(c, 0xE9);
+   } else {
+      unsigned char jcc[2] = { 0x0F, condition };
+      emit(c, jcc, 2);
+   }
+   if (c->fail_count == c->fail_capacity) {
+      int capacity = c->fail_capacity ? c->fail_capacity * 2 : 16;
+      size_t *grown = realloc(c->fails, capacity * sizeof(size_t));
+      if (grown == NULL) {
+         c->out_of_memory = true;
+         return;
+      }
+      c->fails = grown;
+      c->fail_capacity = capacity;
+   }
+   c->fails[c->fail_count++] = c->length;
+   emit_u32(c, 0);
+}
+
+/**
+ * Emits a binary operator. Its left operand was pushed before the code
+ * of the right one, which starts at right and leaves its value in eax.
+ * A right operand that is one number is taken back out of the code and
+ * used as an immediate instead.
+ */
+static void emit_op(struct code *c, enum token_kind op, size_t right, int right_shape) {
+   bool constant = right_shape == SHAPE_CONSTANT && !c->out_of_memory;
+   int32_t k = 0;
+   int pad;
+
+   if (constant) {
+      memcpy(&k, c->bytes + right + 1, 4);
+      c->length = right - 1;      // drop the push and the mov
+   } else {
+      EMIT(c, 0x89, 0xC1, 0x58);  // mov ecx, eax ; pop rax
+   }
+   c->depth--;
+
+   switch (op) {
+      case ADD_OP:
+         if (constant) {
+            EMIT(c, 0x05);        // add eax, k
+            emit_u32(c, k);
+         } else {
+            EMIT(c, 0x01, 0xC8);  // add eax, ecx
+         }
+         return;
+      case SUB_OP:
+         if (constant) {
+            EMIT(c, 0x2D);        // sub eax, k
+            emit_u32(c, k);
+         } else {
+            EMIT(c, 0x29, 0xC8);  // sub eax, ecx
+         }
+         return;
+      case MULT_OP:
+         if (constant) {
+            EMIT(c, 0x69, 0xC0);  // imul eax, eax, k
+            emit_u32(c, k);
+         } else {
+            EMIT(c, 0x0F, 0xAF, 0xC1);  // imul eax, ecx
+         }
+         return;
+      case DIV_OP:
+         if (constant && k == 0) {
+            emit_fail(c, JUMP_ALWAYS);
+         } else if (constant && k == -1) {
+            EMIT(c, 0x3D);                // cmp eax, INT_MIN
+            emit_u32(c, 0x80000000u);
+            emit_fail(c, JUMP_IF_EQUAL);
+            EMIT(c, 0xF7, 0xD8);          // neg eax
+         } else if (constant) {
+            EMIT(c, 0xB9);                // mov ecx, k
+            emit_u32(c, k);
+            EMIT(c, 0x99, 0xF7, 0xF9);    // cdq ; idiv ecx
+         } else {
+            EMIT(c, 0x85, 0xC9);          // test ecx, ecx
+            emit_fail(c, JUMP_IF_EQUAL);
+            EMIT(c, 0x83, 0xF9, 0xFF,     // cmp ecx, -1
+                    0x75, 0x0B,           // jne over the next two instructions
+                    0x3D);                // cmp eax, INT_MIN
+            emit_u32(c, 0x80000000u);
+            emit_fail(c, JUMP_IF_EQUAL);
+            EMIT(c, 0x99, 0xF7, 0xF9);    // cdq ; idiv ecx
+         }
+         return;
+      case EXPON_OP:
+         EMIT(c, 0x89, 0xC7);             // mov edi, eax
+         if (constant) {
+            EMIT(c, 0xBE);                // mov esi, k
+            emit_u32(c, k);
+         } else {
+            EMIT(c, 0x89, 0xCE);          // mov esi, ecx
+         }
+         // Room for the result, keeping rsp a multiple of 16 at the call
+         pad = c->depth % 2 == 0 ? 16 : 8;
+         {
+            unsigned char reserve[4] = { 0x48, 0x83, 0xEC, pad };  // sub rsp, pad
+            uintptr_t target = (uintptr_t) ipow;
+            unsigned char call[10] = { 0x48, 0xB8 };                // mov rax, ipow
+
+            memcpy(call + 2, &target, 8);
+            emit(c, reserve, 4);
+            EMIT(c, 0x48, 0x89, 0xE2);    // mov rdx, rsp
+            emit(c, call, 10);
+            EMIT(c, 0xFF, 0xD0,           // call rax
+                    0x84, 0xC0);          // test al, al
+            emit_fail(c, JUMP_IF_EQUAL);
+            EMIT(c, 0x8B, 0x04, 0x24);    // mov eax, [rsp]
+            reserve[2] = 0xC4;            // add rsp, pad
+            emit(c, reserve, 4);
+         }
+         return;
+      default: {
+         // setl, setg, setle, setge, sete or setne al ; movzx eax, al
+         unsigned char set[6] = { 0x0F, 0, 0xC0, 0x0F, 0xB6, 0xC0 };
+
+         switch (op) {
+            case LESS_THAN_OP: set[1] = 0x9C; break;
+            case GREATER_THAN_OP: set[1] = 0x9F; break;
+            case LESS_THAN_OR_EQUAL_OP: set[1] = 0x9E; break;
+            case GREATER_THAN_OR_EQUAL_OP: set[1] = 0x9D; break;
+            case EQUALS_OP: set[1] = 0x94; break;
+            default: set[1] = 0x95; break;
+         }
+         if (constant) {
+            EMIT(c, 0x3D);                // cmp eax, k
+            emit_u32(c, k);
+         } else {
+            EMIT(c, 0x39, 0xC8);          // cmp eax, ecx
+         }
+         emit(c, set, 6);
+         return;
+      }
+   }
+}
+
+// Saves the left operand before the code of a right one
+static size_t push_left(struct code *c) {
+   EMIT(c, 0x50);                         // push rax
+   c->depth++;
+   return c->length;
+}
+
+/**
+ * <expp> -> ( <expr> ) | <num>
+ */
+static int j_expp(struct parser_state *ps, struct code *c) {
+   if (ps->lex.kind == LEFT_PAREN) {
+      next_token(ps); // Consume the left parenthesis
+      int shape = j_expr(ps, c);
+      if (shape == ERROR || ps->lex.kind != RIGHT_PAREN)
+         return ERROR;
+      next_token(ps); // Consume the right parenthesis
+      return shape;
+   }
+   if (ps->lex.kind != INT_LITERAL)
+      return ERROR;
+   EMIT(c, 0xB8);                         // mov eax, value
+   emit_u32(c, (uint32_t) token_int(ps));
+   next_token(ps);
+   return SHAPE_CONSTANT;
+}
+
+/**
+ * <factor> -> <expp> ^ <factor> | <expp>
+ */
+static int j_factor(struct parser_state *ps, struct code *c) {
+   int shape = j_expp(ps, c);
+   size_t right;
+
+   if (shape == ERROR)
+      return ERROR;
+   if (ps->lex.kind == EXPON_OP) {
+      next_token(ps);
+      right = push_left(c);
+      if ((shape = j_factor(ps, c)) == ERROR)
+         return ERROR;
+      emit_op(c, EXPON_OP, right, shape);
+      return SHAPE_ANY;
+   }
+   return shape;
+}
+
+/**
+ * <stmt> -> <factor> <ftail>
+ * <ftail> -> <compare_tok> <factor> <ftail> | e
+ */
+static int j_stmt(struct parser_state *ps, struct code *c) {
+   int shape = j_factor(ps, c), right_shape;
+   size_t right;
+
+   if (shape == ERROR)
+      return ERROR;
+   while (compare_outcomes[ps->lex.kind] != 0) {
+      enum token_kind op = ps->lex.kind;
+      next_token(ps);
+      right = push_left(c);
+      if ((right_shape = j_factor(ps, c)) == ERROR)
+         return ERROR;
+      emit_op(c, op, right, right_shape);
+      shape = SHAPE_ANY;
+   }
+   return shape;
+}
+
+/**
+ * <term> -> <stmt> <stail>
+ * <stail> -> <mult_div_tok> <stmt> <stail> | e
+ */
+static int j_term(struct parser_state *ps, struct code *c) {
+   int shape = j_stmt(ps, c), right_shape;
+   size_t right;
+
+   if (shape == ERROR)
+      return ERROR;
+   while (ps->lex.kind == MULT_OP || ps->lex.kind == DIV_OP) {
+      enum token_kind op = ps->lex.kind;
+      next_token(ps);
+      right = push_left(c);
+      if ((right_shape = j_stmt(ps, c)) == ERROR)
+         return ERROR;
+      emit_op(c, op, right, right_shape);
+      shape = SHAPE_ANY;
+   }
+   return shape;
+}
+
+/**
+ * <expr> -> <term> <ttail>
+ * <ttail> -> <add_sub_tok> <term> <ttail> | e
+ */
+static int j_expr(struct parser_state *ps, struct code *c) {
+   int shape = j_term(ps, c), right_shape;
+   size_t right;
+
+   if (shape == ERROR)
+      return ERROR;
+   while (ps->lex.kind == ADD_OP || ps->lex.kind == SUB_OP) {
+      enum token_kind op = ps->lex.kind;
+      next_token(ps);
+      right = push_left(c);
+      if ((right_shape = j_term(ps, c)) == ERROR)
+         return ERROR;
+      emit_op(c, op, right, right_shape);
+      shape = SHAPE_ANY;
+   }
+   return shape;
+}
+
+/**
+ * Maps a new chunk of executable memory, big enough for size bytes.
+ * @return: the chunk, or NULL if the system will not map one
+ */
+static struct jit_chunk *map_chunk(size_t size) {
+   size_t page = (size_t) sysconf(_SC_PAGESIZE);
+   struct jit_chunk *chunk = malloc(sizeof(struct jit_chunk));
+   void *base;
+
+   if (chunk == NULL)
+      return NULL;
+   size = size < JIT_CHUNK ? JIT_CHUNK : (size + page - 1) & ~(page - 1);
+   base = mmap(NULL, size, PROT_READ | PROT_EXEC, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+   if (base == MAP_FAILED) {
+      free(chunk);
+      return NULL;
+   }
+   chunk->base = base;
+   chunk->size = size;
+   chunk->used = 0;
+   chunk->next = NULL;
+   return chunk;
+}
+
+/**
+ * Copies finished code into executable memory. Only the pages it goes
+ * to are made writable, and only while it is copied.
+ * @return: the function, or NULL if memory could not be mapped or protected
+ */
+static jit_fn install(struct jit_cache *jc, const struct code *c) {
+   size_t page = (size_t) sysconf(_SC_PAGESIZE), first, last;
+   size_t size = (c->length + 15) & ~(size_t) 15;   // keep functions 16-byte aligned
+   struct jit_chunk *chunk = jc->chunks;
+   unsigned char *fn;
+
+   if (chunk == NULL || chunk->size - chunk->used < size) {
+      if ((chunk = map_chunk(size)) == NULL)
+         return NULL;
+      chunk->next = jc->chunks;
+      jc->chunks = chunk;
+      jc->mapped += chunk->size;
+   }
+   fn = chunk->base + chunk->used;
+   first = chunk->used & ~(page - 1);
+   last = (chunk->used + c->length + page - 1) & ~(page - 1);
+   if (mprotect(chunk->base + first, last - first, PROT_READ | PROT_WRITE) != 0) {
+      jc->available = false;
+      return NULL;
+   }
+   memcpy(fn, c->bytes, c->length);
+   if (mprotect(chunk->base + first, last - first, PROT_READ | PROT_EXEC) != 0) {
+      jc->available = false;
+      return NULL;
+   }
+   __builtin___clear_cache((char *) fn, (char *) fn + c->length);
+   chunk->used += size;
+   jc->code_bytes += c->length;
+   return (jit_fn) fn;
+}
+
+#endif /* JIT_NATIVE */
+
+/**
+ * Unmaps every chunk of executable memory.
+ */
+static void free_chunks(struct jit_cache *jc) {
+   struct jit_chunk *chunk, *next;
+
+   for (chunk = jc->chunks; chunk != NULL; chunk = next) {
+      next = chunk->next;
+#ifdef JIT_NATIVE
+      munmap(chunk->base, chunk->size);
+#endif
+      free(chunk);
+   }
+   jc->chunks = NULL;
+   jc->mapped = 0;
+   jc->code_bytes = 0;
+}
+
+/**
+ * Sets up an empty cache, and finds out whether code can be compiled.
+ * @param jc: the cache to initialize
+ * @param threshold: bexpr() runs of a statement before it is compiled,
+ *                   such as JIT_HOT, or 0 to compile on first sight
+ * @param max_bytes: the most entry and text memory to hold, and apart
+ *                   from it the most code, or 0 for JIT_MAX_BYTES
+ * @return: false if out of memory
+ */
+bool jit_init(struct jit_cache *jc, int threshold, size_t max_bytes) {
+   memset(jc, 0, sizeof(*jc));
+   jc->threshold = threshold;
+   jc->max_bytes = max_bytes > 0 ? max_bytes : JIT_MAX_BYTES;
+   if ((jc->entries = calloc(JIT_ENTRIES, sizeof(struct jit_entry))) == NULL)
+      return false;
+   jc->capacity = JIT_ENTRIES;
+#ifdef JIT_NATIVE
+   jc->chunks = map_chunk(JIT_CHUNK);
+   jc->available = jc->chunks != NULL;
+   if (jc->available)
+      jc->mapped = jc->chunks->size;
+#endif
+   return true;
+}
+
+/**
+ * <bexpr> -> <expr> ;
+ * Compiles the next <bexpr> to a native function. The function gives
+ * the statement's value as bexpr() would, and fails exactly when bexpr()
+ * would report an overflow or a division by zero.
+ * The function lasts until jit_free(), or until jit_bexpr() on the same
+ * cache flushes its code.
+ * @param jc: the cache whose memory the code goes in
+ * @param ps: the parser state, positioned at the start of a <bexpr>
+ * @return: the function, or NULL on a syntax error, when out of
+ *          memory, or when there is no JIT; ps is then anywhere in the
+ *          statement
+ */
+jit_fn jit_compile(struct jit_cache *jc, struct parser_state *ps) {
+#ifdef JIT_NATIVE
+   struct code c;
+   jit_fn fn = NULL;
+   int i;
+
+   if (!jc->available)
+      return NULL;
+   memset(&c, 0, sizeof(c));
+   EMIT(&c, 0x55,                         // push rbp
+            0x48, 0x89, 0xE5,             // mov rbp, rsp
+            0x53,                         // push rbx
+            0x48, 0x89, 0xFB,             // mov rbx, rdi, the value pointer
+            0x48, 0x83, 0xEC, 0x08);      // sub rsp, 8, so rsp is 16-byte aligned
+   if (j_expr(ps, &c) != ERROR && ps->lex.kind == SEMI_COLON) {
+      size_t exit;
+
+      next_token(ps); // Consume the semicolon
+      EMIT(&c, 0x89, 0x03,                // mov [rbx], eax
+               0xB8, 0x01, 0, 0, 0,       // mov eax, 1
+               0x48, 0x8D, 0x65, 0xF8,    // lea rsp, [rbp - 8]
+               0x5B, 0x5D, 0xC3);         // pop rbx ; pop rbp ; ret
+      exit = c.length;
+      EMIT(&c, 0x31, 0xC0,                // xor eax, eax
+               0x48, 0x8D, 0x65, 0xF8,    // lea rsp, [rbp - 8]
+               0x5B, 0x5D, 0xC3);         // pop rbx ; pop rbp ; ret
+      if (!c.out_of_memory) {
+         for (i = 0; i < c.fail_count; i++) {
+            int32_t rel = (int32_t) (exit - (c.fails[i] + 4));
+            memcpy(c.bytes + c.fails[i], &rel, 4);
+         }
+         fn = install(jc, &c);
+      }
+   }
+   free(c.bytes);
+   free(c.fails);
+   if (fn != NULL)
+      jc->compiled++;
+   else
+      jc->rejected++;
+   return fn;
+#else
+   (void) jc;
+   (void) ps;
+   return NULL;
+#endif
+}
+
+/**
+ * Empties slot i, moving back the entries after it in its probe run
+ * that would no longer be found past the hole. The code of the entry
+ * stays mapped until the next flush.
+ */
+static void remove_entry(struct jit_cache *jc, int i) {
+   int mask = jc->capacity - 1, j, home;
+
+   jc->bytes -= sizeof(struct jit_entry) + jc->entries[i].length;
+   free(jc->entries[i].text);
+   jc->count--;
+   for (j = (i + 1) & mask; jc->entries[j].text != NULL; j = (j + 1) & mask) {
+      home = (int) (jc->entries[j].hash & mask);
+      // Move it unless its home slot lies after the hole, up to it
+      if (((j - home) & mask) >= ((j - i) & mask)) {
+         jc->entries[i] = jc->entries[j];
+         i = j;
+      }
+   }
+   jc->entries[i].text = NULL;
+}
+
+/**
+ * Evicts the first entry the clock hand finds that has not been used
+ * since the hand last passed it.
+ */
+static void evict(struct jit_cache *jc) {
+   struct jit_entry *e;
+
+   for (;; jc->hand = (jc->hand + 1) & (jc->capacity - 1)) {
+      e = &jc->entries[jc->hand];
+      if (e->text != NULL && !e->referenced)
+         break;
+      e->referenced = false;
+   }
+   remove_entry(jc, jc->hand);
+   jc->evictions++;
+}
+
+/**
+ * Drops all compiled code, so the memory it holds can be mapped again.
+ * Every statement is compiled again the next time it is run.
+ */
+static void flush(struct jit_cache *jc) {
+   int i;
+
+   for (i = 0; i < jc->capacity; i++)
+      jc->entries[i].fn = NULL;
+   free_chunks(jc);
+   jc->flushes++;
+}
+
+/**
+ * Finds the entry of a statement's text, adding it if it is new and
+ * evicting others to keep the text under the cap.
+ * @return: the entry, or NULL if out of memory or the text alone is
+ *          over the cap
+ */
+static struct jit_entry *lookup(struct jit_cache *jc, const char *text, uint32_t length) {
+   uint64_t hash = hash_source(text, length);
+   size_t need = sizeof(struct jit_entry) + length;
+   struct jit_entry *e;
+   int i;
+
+   if ((jc->count + 1) * 4 > jc->capacity * 3) {
+      // Rehash into twice the slots
+      struct jit_entry *old = jc->entries;
+      int capacity = jc->capacity * 2, j;
+
+      if ((jc->entries = calloc(capacity, sizeof(struct jit_entry))) == NULL) {
+         jc->entries = old;
+         return NULL;
+      }
+      for (j = 0; j < jc->capacity; j++) {
+         if (old[j].text == NULL)
+            continue;
+         for (i = (int) (old[j].hash & (capacity - 1)); jc->entries[i].text != NULL;
+              i = (i + 1) & (capacity - 1))
+            ;
+         jc->entries[i] = old[j];
+      }
+      free(old);
+      jc->capacity = capacity;
+      jc->hand = 0;
+   }
+
+   for (i = (int) (hash & (jc->capacity - 1));; i = (i + 1) & (jc->capacity - 1)) {
+      e = &jc->entries[i];
+      if (e->text == NULL)
+         break;
+      if (e->hash == hash && e->length == length && memcmp(e->text, text, length) == 0) {
+         e->referenced = true;
+         return e;
+      }
+   }
+   if (need > jc->max_bytes)
+      return NULL;
+   if (jc->bytes + need > jc->max_bytes) {
+      while (jc->bytes + need > jc->max_bytes)
+         evict(jc);
+      // Evicting moves entries, so find the free slot again
+      for (i = (int) (hash & (jc->capacity - 1)); jc->entries[i].text != NULL;
+           i = (i + 1) & (jc->capacity - 1))
+         ;
+      e = &jc->entries[i];
+   }
+   if ((e->text = malloc(length > 0 ? length : 1)) == NULL)
+      return NULL;
+   memcpy(e->text, text, length);
+   e->hash = hash;
+   e->length = length;
+   e->runs = 0;
+   e->fn = NULL;
+   e->rejected = false;
+   e->referenced = false;
+   jc->bytes += need;
+   jc->count++;
+   return e;
+}
+
+/**
+ * Moves the parser past a statement that was run natively, to the first
+ * token after its semicolon, as bexpr() would have left it.
+ */
+static void skip_statement(struct parser_state *ps, char *semicolon) {
+   char *p;
+
+   for (p = semicolon; p >= ps->lex.line; p--) {
+      if (*p == '\n') {
+         ps->lex.line_start = p + 1;
+         break;
+      }
+   }
+   ps->lex.line = semicolon + 1;
+   next_token(ps);
+}
+
+/**
+ * <bexpr> -> <expr> ;
+ * Evaluates the next statement with compiled code if it has been run
+ * often enough, compiling it when it reaches the cache's threshold, and
+ * with bexpr() otherwise. A statement that fails in compiled code is run
+ * again by bexpr(), so errors are reported, and the parser left, just as
+ * bexpr() does. Statements read from a token_cache always go to bexpr().
+ * @param jc: the cache
+ * @param ps: the parser state, positioned at the start of a <bexpr>
+ * @return: the status of the evaluation and, if PARSE_OK, its value
+ */
+struct eval_result jit_bexpr(struct jit_cache *jc, struct parser_state *ps) {
+   struct eval_result result = { PARSE_OK, 0 };
+   struct jit_entry *e;
+   char *start, *semicolon;
+
+   if (!jc->available || ps->cached != NULL || ps->lex.kind == END_OF_INPUT)
+      goto interpret;
+   start = ps->token.start;
+   if ((semicolon = memchr(start, ';', (size_t) (ps->lex.end - start))) == NULL
+       || (size_t) (semicolon - start) > UINT32_MAX
+       || (e = lookup(jc, start, (uint32_t) (semicolon - start))) == NULL || e->rejected)
+      goto interpret;
+   if (e->fn == NULL) {
+      struct parser_state copy = *ps;
+
+      if (e->runs < (uint32_t) jc->threshold) {
+         e->runs++;
+         goto interpret;
+      }
+      if (jc->mapped > jc->max_bytes)
+         flush(jc);
+      if ((e->fn = jit_compile(jc, &copy)) == NULL) {
+         e->rejected = true;
+         goto interpret;
+      }
+   }
+   if (!e->fn(&result.value))
+      goto interpret; // Let bexpr() find and report the error
+
+   skip_statement(ps, semicolon);
+   ps->is_right_paren_error = false;
+   ps->status = PARSE_OK;
+   ps->value = result.value;
+   jc->native++;
+   return result;
+
+interpret:
+   jc->interpreted++;
+   return bexpr(ps);
+}
+
+/**
+ * Frees the entries of a cache and unmaps its code.
+ * @param jc: the cache to free
+ */
+void jit_free(struct jit_cache *jc) {
+   int i;
+
+   for (i = 0; i < jc->capacity; i++)
+      free(jc->entries[i].text);
+   free(jc->entries);
+   free_chunks(jc);
+   memset(jc, 0, sizeof(*jc));
+}
@@ -0,0 +1,73 @@
+#ifndef JIT_H
+#define JIT_H
+/*
+ * Purpose: Compile statements that are evaluated again and again to
+ *          x86-64 machine code, and run that instead of parsing them.
+ *          Compiled code is kept in a cache keyed by the statement's
+ *          text, within a memory cap. Where there is no JIT (another CPU, a build with
+ *          -DJIT_NO_NATIVE, or a system that will not map executable
+ *          memory) every statement goes to bexpr(), with the same results.
+ * Date:    2025 May 11
+ */
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "parser.h"
+
+#define JIT_HOT 2                        // default bexpr() runs of a statement before it is compiled
+#define JIT_MAX_BYTES (8 * 1024 * 1024)  // default cap on statement text, and on code
+
+/*
+ * Compiled code of one statement: stores its value and returns true,
+ * or returns false if it divides by zero or overflows.
+ */
+typedef bool (*jit_fn)(int *);
+
+// One statement seen by the cache
+struct jit_entry {
+   uint64_t hash;       // hash_source() of the text
+   char *text;          // the statement up to its ';', or NULL if free
+   uint32_t length;     // bytes in text
+   uint32_t runs;       // bexpr() runs so far, while not compiled
+   jit_fn fn;           // the compiled code, or NULL
+   bool rejected;       // compiling failed, so it always goes to bexpr()
+   bool referenced;     // used since the clock hand last passed?
+};
+
+// An mmap'd block of executable memory that functions are appended to
+struct jit_chunk {
+   unsigned char *base;
+   size_t size;
+   size_t used;
+   struct jit_chunk *next;
+};
+
+/*
+ * The cache and the code it holds. A cache is not locked; each thread
+ * evaluating input owns its own, as it owns its parser_state. Entries
+ * are evicted in CLOCK order once their text would pass max_bytes. Code
+ * cannot be freed one function at a time, so once the executable memory
+ * passes max_bytes it is all unmapped, and statements are compiled
+ * again as they are run.
+ */
+struct jit_cache {
+   struct jit_entry *entries;   // open addressing, linear probing
+   int capacity;                // a power of two
+   int count;
+   int hand;                    // clock hand, an index into entries
+   int threshold;               // runs of bexpr() before compiling
+   bool available;              // false when every statement goes to bexpr()
+   struct jit_chunk *chunks;    // newest first
+   size_t bytes;                // entry and text bytes held
+   size_t mapped;               // executable memory held
+   size_t max_bytes;            // the cap on bytes, and apart from it on mapped
+   uint64_t native, interpreted, compiled, rejected, evictions, flushes;
+   size_t code_bytes;           // code in the executable memory
+};
+
+bool jit_init(struct jit_cache *, int, size_t);
+jit_fn jit_compile(struct jit_cache *, struct parser_state *);
+struct eval_result jit_bexpr(struct jit_cache *, struct parser_state *);
+void jit_free(struct jit_cache *);
+
+#endif
@@ -0,0 +1,310 @@
+/*
+ * memo.c - a sharded, memory-capped cache of bexpr() results keyed by
+ * normalized token stream. Each shard has its own mutex, so evaluators
+ * on different threads only wait for each other when their statements
+ * hash to the same shard. A miss is evaluated outside the lock.
+ * Date:   2025 May 4
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include "parser.h"
+#include "tokcache.h"
+#include "memo.h"
+
+// Keys up to this size are built on the stack
+#define KEY_STACK 256
+
+// Buckets each shard starts with; they double as entries are added
+#define MEMO_BUCKETS 64
+
+/**
+ * Sets up an empty cache.
+ * @param mc: the cache to initialize
+ * @param max_bytes: the most entry and key memory to hold
+ * @param shard_count: the number of shards, or 0 for MEMO_SHARDS
+ * @return: false if out of memory
+ */
+bool memo_init(struct memo_cache *mc, size_t max_bytes, int shard_count) {
+   int i;
+
+   if (shard_count <= 0)
+      shard_count = MEMO_SHARDS;
+   mc->shard_count = shard_count;
+   mc->shards = calloc(shard_count, sizeof(struct memo_shard));
+   if (mc->shards == NULL)
+      return false;
+   for (i = 0; i < shard_count; i++) {
+      struct memo_shard *shard = &mc->shards[i];
+
+      pthread_mutex_init(&shard->lock, NULL);
+      shard->buckets = malloc(MEMO_BUCKETS * sizeof(int));
+      shard->bucket_mask = MEMO_BUCKETS - 1;
+      shard->free = -1;
+      shard->max_bytes = max_bytes / shard_count;
+      if (shard->buckets == NULL) {
+         mc->shard_count = i + 1;
+         memo_free(mc);
+         return false;
+      }
+      memset(shard->buckets, -1, MEMO_BUCKETS * sizeof(int));
+   }
+   return true;
+}
+
+// Whether c can continue an identifier or a number
+static bool is_word(char c) {
+   return isalnum((unsigned char) c) || c == '_';
+}
+
+/**
+ * Writes a statement with its whitespace dropped. A single blank is
+ * kept only where dropping the whitespace would join two lexemes into
+ * one: between two identifier or digit characters, or before an '='
+ * that would end a two-byte operator. Two statements get the same key exactly when they have the
+ * same lexemes, without lexing either of them.
+ * @param text: the NUL-terminated statement
+ * @param key: room for every byte of text
+ * @return: the number of bytes written
+ */
+static size_t make_key(const char *text, char *key) {
+   char *out = key;
+   char last = ' ';   // last byte written, or ' ' at the start
+
+   for (;;) {
+      char c = *text++;
+
+      if (c == ' ' || c == '\t' || c == '\n') {
+         while (*text == ' ' || *text == '\t' || *text == '\n')
+            text++;
+         if ((is_word(last) && is_word(*text))
+             || (strchr("<>=!", last) != NULL && *text == '='))
+            *out++ = ' ';
+         continue;
+      }
+      if (c == '\0')
+         return (size_t) (out - key);
+      *out++ = last = c;
+   }
+}
+
+/**
+ * Doubles a shard's buckets once it holds as many entries as buckets.
+ * The caller holds the shard's lock. Out of memory keeps the old ones.
+ */
+static void grow_buckets(struct memo_shard *shard) {
+   int size = 2 * (shard->bucket_mask + 1), i;
+   int *buckets = malloc(size * sizeof(int));
+
+   if (buckets == NULL)
+      return;
+   memset(buckets, -1, size * sizeof(int));
+   for (i = 0; i < shard->count; i++) {
+      struct memo_entry *entry = &shard->entries[i];
+      if (entry->key != NULL) {
+         entry->next = buckets[entry->hash & (size - 1)];
+         buckets[entry->hash & (size - 1)] = i;
+      }
+   }
+   free(shard->buckets);
+   shard->buckets = buckets;
+   shard->bucket_mask = size - 1;
+}
+
+/**
+ * Finds a key in a shard. The caller holds the shard's lock.
+ * @return: the entry's index, or -1 if it is not there
+ */
+static int find(struct memo_shard *shard, uint64_t hash, const char *key,
+                uint32_t length) {
+   int i = shard->buckets[hash & shard->bucket_mask];
+
+   while (i >= 0) {
+      struct memo_entry *entry = &shard->entries[i];
+      if (entry->hash == hash && entry->key_length == length
+          && memcmp(entry->key, key, length) == 0)
+         return i;
+      i = entry->next;
+   }
+   return -1;
+}
+
+/**
+ * Evicts the first entry the clock hand finds that has not been used
+ * since the hand last passed it. The caller holds the shard's lock.
+ */
+static void evict(struct memo_shard *shard) {
+   struct memo_entry *entry;
+   int *link;
+
+   for (;;) {
+      if (shard->hand >= shard->count)
+         shard->hand = 0;
+      entry = &shard->entries[shard->hand];
+      if (entry->key != NULL && !entry->referenced)
+         break;
+      entry->referenced = false;
+      shard->hand++;
+   }
+
+   link = &shard->buckets[entry->hash & shard->bucket_mask];
+   while (*link != shard->hand)
+      link = &shard->entries[*link].next;
+   *link = entry->next;
+
+   shard->bytes -= sizeof(struct memo_entry) + entry->key_length;
+   free(entry->key);
+   entry->key = NULL;
+   entry->next = shard->free;
+   shard->free = shard->hand++;
+   shard->live--;
+   shard->evictions++;
+}
+
+/**
+ * Adds a key the shard does not hold, evicting entries until it fits
+ * under the cap. The caller holds the shard's lock. Out of memory just
+ * leaves the key out.
+ */
+static void insert(struct memo_shard *shard, uint64_t hash, const char *key,
+                   uint32_t length, struct eval_result result) {
+   size_t need = sizeof(struct memo_entry) + length;
+   struct memo_entry *entry;
+   char *copy;
+   int i;
+
+   if (need > shard->max_bytes)
+      return;
+   while (shard->bytes + need > shard->max_bytes)
+      evict(shard);
+   if (shard->live > shard->bucket_mask)
+      grow_buckets(shard);
+   if ((copy = malloc(length)) == NULL)
+      return;
+   memcpy(copy, key, length);
+
+   if (shard->free >= 0) {
+      i = shard->free;
+      shard->free = shard->entries[i].next;
+   } else {
+      if (shard->count == shard->capacity) {
+         int capacity = shard->capacity > 0 ? 2 * shard->capacity : 64;
+         struct memo_entry *bigger = realloc(shard->entries, capacity * sizeof(struct memo_entry));
+         if (bigger == NULL) {
+            free(copy);
+            return;
+         }
+         shard->entries = bigger;
+         shard->capacity = capacity;
+      }
+      i = shard->count++;
+   }
+
+   entry = &shard->entries[i];
+   entry->hash = hash;
+   entry->key = copy;
+   entry->key_length = length;
+   entry->result = result;
+   entry->referenced = false;
+   entry->next = shard->buckets[hash & shard->bucket_mask];
+   shard->buckets[hash & shard->bucket_mask] = i;
+   shard->bytes += need;
+   shard->live++;
+}
+
+/**
+ * Evaluates one NUL-terminated statement through the cache. A statement
+ * whose tokens were seen before gets the remembered value without being
+ * parsed, so it prints none of the errors it printed the first time.
+ * Safe to call from many threads at once.
+ * @param mc: the cache
+ * @param input: the statement
+ * @return: the bexpr() result of the statement
+ */
+struct eval_result memo_bexpr(struct memo_cache *mc, char *input) {
+   size_t length = strlen(input);
+   char stack_key[KEY_STACK], *key = stack_key;
+   struct memo_shard *shard;
+   struct parser_state ps;
+   uint32_t key_length;
+   uint64_t hash;
+   struct eval_result result;
+   int i;
+
+   if (length > KEY_STACK && (key = malloc(length)) == NULL) {
+      parser_init(&ps, input);
+      return bexpr(&ps);
+   }
+   key_length = (uint32_t) make_key(input, key);
+   hash = hash_source(key, key_length);
+   shard = &mc->shards[(hash >> 32) % (uint64_t) mc->shard_count];
+
+   pthread_mutex_lock(&shard->lock);
+   if ((i = find(shard, hash, key, key_length)) >= 0) {
+      shard->entries[i].referenced = true;
+      shard->hits++;
+      result = shard->entries[i].result;
+      pthread_mutex_unlock(&shard->lock);
+   } else {
+      shard->misses++;
+      pthread_mutex_unlock(&shard->lock);
+
+      parser_init(&ps, input);
+      result = bexpr(&ps);
+
+      // another thread may have added it while this one evaluated
+      pthread_mutex_lock(&shard->lock);
+      if (find(shard, hash, key, key_length) < 0)
+         insert(shard, hash, key, key_length, result);
+      pthread_mutex_unlock(&shard->lock);
+   }
+
+   if (key != stack_key)
+      free(key);
+   return result;
+}
+
+/**
+ * Adds up the counters of every shard.
+ * @param mc: the cache
+ * @param stats: where the totals go
+ */
+void memo_stats(struct memo_cache *mc, struct memo_stats *stats) {
+   int i;
+
+   memset(stats, 0, sizeof(*stats));
+   for (i = 0; i < mc->shard_count; i++) {
+      struct memo_shard *shard = &mc->shards[i];
+
+      pthread_mutex_lock(&shard->lock);
+      stats->hits += shard->hits;
+      stats->misses += shard->misses;
+      stats->evictions += shard->evictions;
+      stats->entries += (size_t) shard->live;
+      stats->bytes += shard->bytes;
+      pthread_mutex_unlock(&shard->lock);
+   }
+}
+
+/**
+ * Frees the cache.
+ * @param mc: the cache to free
+ */
+void memo_free(struct memo_cache *mc) {
+   int i, j;
+
+   for (i = 0; i < mc->shard_count; i++) {
+      struct memo_shard *shard = &mc->shards[i];
+
+      for (j = 0; j < shard->count; j++)
+         free(shard->entries[j].key);
+      free(shard->entries);
+      free(shard->buckets);
+      pthread_mutex_destroy(&shard->lock);
+   }
+   free(mc->shards);
+   mc->shards = NULL;
+   mc->shard_count = 0;
+}
@@ -0,0 +1,68 @@
+#ifndef MEMO_H
+#define MEMO_H
+/*
+ * Purpose: Remember bexpr() results by statement so text seen before is
+ *          never parsed or evaluated again, within a memory cap.
+ * Date:    2025 May 4
+ */
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <pthread.h>
+#include "parser.h"
+
+#define MEMO_SHARDS 16   // default number of independently locked shards
+
+/*
+ * One remembered statement. The key is the statement's lexemes with the
+ * whitespace between them dropped, so statements that only differ in
+ * spacing share an entry.
+ */
+struct memo_entry {
+   uint64_t hash;           // hash_source() of the key
+   char *key;               // the normalized lexemes, or NULL if free
+   uint32_t key_length;     // bytes in key
+   struct eval_result result;   // bexpr() result of the statement
+   int next;                // next entry in the same bucket, or -1
+   bool referenced;         // used since the clock hand last passed?
+};
+
+/*
+ * A slice of the cache with its own lock. Entries are evicted in CLOCK
+ * order once the shard holds more than its share of the memory cap.
+ */
+struct memo_shard {
+   pthread_mutex_t lock;
+   struct memo_entry *entries;
+   int count;               // entries in use or on the free list
+   int live;                // entries in use
+   int capacity;            // size of entries
+   int *buckets;            // first entry for each hash, or -1
+   int bucket_mask;         // number of buckets - 1
+   int free;                // first free entry, chained through next
+   int hand;                // clock hand, an index into entries
+   size_t bytes;            // entry and key bytes held
+   size_t max_bytes;        // this shard's share of the cap
+   uint64_t hits, misses, evictions;
+};
+
+struct memo_cache {
+   struct memo_shard *shards;
+   int shard_count;
+};
+
+// Totals over every shard
+struct memo_stats {
+   uint64_t hits;
+   uint64_t misses;
+   uint64_t evictions;
+   size_t entries;
+   size_t bytes;
+};
+
+bool memo_init(struct memo_cache *, size_t, int);
+struct eval_result memo_bexpr(struct memo_cache *, char *);
+void memo_stats(struct memo_cache *, struct memo_stats *);
+void memo_free(struct memo_cache *);
+
+#endif
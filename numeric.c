@@ -0,0 +1,203 @@
+/*
+ * numeric.c - evaluates a <bexpr> like bexpr() does, but in value_t, so
+ * the same grammar runs on int, checked 64-bit or arbitrary-precision
+ * numbers depending on how it is compiled. The parse functions follow
+ * the grammar in parser.c one for one. A result that does not fit the
+ * number type is an error rather than a wrapped value.
+ * Date:   2025 May 5
+ */
+
+#include "numeric.h"
+
+static bool n_expr(struct parser_state *, value_t *);
+
+/**
+ * Applies a binary operator, reporting a result that cannot be
+ * represented.
+ * @param ps: the parser state, where errors go
+ * @param op: the operator's token kind
+ * @param offset: byte offset of the operator, for errors
+ * @param r: set to the result; may be a or b
+ * @param a: the left operand
+ * @param b: the right operand
+ * @return: false on overflow or division by zero; see ps->status
+ */
+static bool apply(struct parser_state *ps, enum token_kind op, size_t offset, value_t *r,
+                  const value_t *a, const value_t *b) {
+   int order;
+
+   switch (op) {
+      case ADD_OP:
+         if (val_add(r, a, b))
+            return true;
+         parse_error(ps, PARSE_OVERFLOW, offset, "Overflow Error: '+' result out of range");
+         return false;
+      case SUB_OP:
+         if (val_sub(r, a, b))
+            return true;
+         parse_error(ps, PARSE_OVERFLOW, offset, "Overflow Error: '-' result out of range");
+         return false;
+      case MULT_OP:
+         if (val_mul(r, a, b))
+            return true;
+         parse_error(ps, PARSE_OVERFLOW, offset, "Overflow Error: '*' result out of range");
+         return false;
+      case DIV_OP:
+         if (val_is_zero(b)) {
+            parse_error(ps, PARSE_DIVIDE_BY_ZERO, offset, "Math Error: division by zero");
+            return false;
+         }
+         if (val_div(r, a, b))
+            return true;
+         parse_error(ps, PARSE_OVERFLOW, offset, "Overflow Error: '/' result out of range");
+         return false;
+      case EXPON_OP:
+         if (val_pow(r, a, b))
+            return true;
+         parse_error(ps, PARSE_OVERFLOW, offset, "Overflow Error: '^' result out of range");
+         return false;
+      default:
+         break;
+   }
+
+   order = val_cmp(a, b);
+   switch (op) {
+      case LESS_THAN_OP: return val_bool(r, order < 0);
+      case GREATER_THAN_OP: return val_bool(r, order > 0);
+      case LESS_THAN_OR_EQUAL_OP: return val_bool(r, order <= 0);
+      case GREATER_THAN_OR_EQUAL_OP: return val_bool(r, order >= 0);
+      case EQUALS_OP: return val_bool(r, order == 0);
+      default: return val_bool(r, order != 0);
+   }
+}
+
+/**
+ * <expp> -> ( <expr> ) | <num>
+ */
+static bool n_expp(struct parser_state *ps, value_t *out) {
+   if (ps->lex.kind == LEFT_PAREN) {
+      next_token(ps); // Consume the left parenthesis
+      if (!n_expr(ps, out))
+         return false;
+      if (ps->lex.kind != RIGHT_PAREN) {
+         ps->is_right_paren_error = true;
+         parse_error(ps, PARSE_SYNTAX_ERROR, token_offset(ps), "Syntax Error: ')' expected");
+         return false;
+      }
+      next_token(ps); // Consume the right parenthesis
+      return true;
+   }
+   if (ps->lex.kind != INT_LITERAL) {
+      parse_error(ps, PARSE_SYNTAX_ERROR, token_offset(ps), "Syntax Error: Expected a number");
+      return false;
+   }
+   if (!val_digits(out, ps->token.start, ps->token.length)) {
+      parse_error(ps, PARSE_OVERFLOW, token_offset(ps), "Overflow Error: literal out of range");
+      return false;
+   }
+   next_token(ps);
+   return true;
+}
+
+/**
+ * <factor> -> <expp> ^ <factor> | <expp>
+ */
+static bool n_factor(struct parser_state *ps, value_t *out) {
+   value_t exponent;
+   size_t offset;
+   bool ok;
+
+   if (!n_expp(ps, out))
+      return false;
+   if (ps->lex.kind != EXPON_OP)
+      return true;
+   offset = token_offset(ps);
+   next_token(ps);
+   val_init(&exponent);
+   ok = n_factor(ps, &exponent) && apply(ps, EXPON_OP, offset, out, out, &exponent);
+   val_free(&exponent);
+   return ok;
+}
+
+/**
+ * <stmt> -> <factor> <ftail>
+ * <ftail> -> <compare_tok> <factor> <ftail> | e
+ */
+static bool n_stmt(struct parser_state *ps, value_t *out) {
+   value_t right;
+   bool ok;
+
+   if (!n_factor(ps, out))
+      return false;
+   val_init(&right);
+   for (ok = true; ok; ) {
+      enum token_kind op = ps->lex.kind;
+      if (op != LESS_THAN_OP && op != GREATER_THAN_OP && op != LESS_THAN_OR_EQUAL_OP
+          && op != GREATER_THAN_OR_EQUAL_OP && op != NOT_EQUALS_OP && op != EQUALS_OP)
+         break;
+      size_t offset = token_offset(ps);
+      next_token(ps);
+      ok = n_factor(ps, &right) && apply(ps, op, offset, out, out, &right);
+   }
+   val_free(&right);
+   return ok;
+}
+
+/**
+ * <term> -> <stmt> <stail>
+ * <stail> -> <mult_div_tok> <stmt> <stail> | e
+ */
+static bool n_term(struct parser_state *ps, value_t *out) {
+   value_t right;
+   bool ok;
+
+   if (!n_stmt(ps, out))
+      return false;
+   val_init(&right);
+   for (ok = true; ok && (ps->lex.kind == MULT_OP || ps->lex.kind == DIV_OP); ) {
+      enum token_kind op = ps->lex.kind;
+      size_t offset = token_offset(ps);
+      next_token(ps);
+      ok = n_stmt(ps, &right) && apply(ps, op, offset, out, out, &right);
+   }
+   val_free(&right);
+   return ok;
+}
+
+/**
+ * <expr> -> <term> <ttail>
+ * <ttail> -> <add_sub_tok> <term> <ttail> | e
+ */
+static bool n_expr(struct parser_state *ps, value_t *out) {
+   value_t right;
+   bool ok;
+
+   if (!n_term(ps, out))
+      return false;
+   val_init(&right);
+   for (ok = true; ok && (ps->lex.kind == ADD_OP || ps->lex.kind == SUB_OP); ) {
+      enum token_kind op = ps->lex.kind;
+      size_t offset = token_offset(ps);
+      next_token(ps);
+      ok = n_term(ps, &right) && apply(ps, op, offset, out, out, &right);
+   }
+   val_free(&right);
+   return ok;
+}
+
+/**
+ * <bexpr> -> <expr> ;
+ * Evaluates the next <bexpr> in the selected number type. Errors are
+ * reported and recovered from as bexpr() does.
+ * @param ps: the parser state, positioned at the start of a <bexpr>
+ * @param result: an initialized value_t, set to the value
+ * @return: the status of the evaluation, which is also ps->status;
+ *          result holds the value only if it is PARSE_OK
+ */
+enum parse_status num_bexpr(struct parser_state *ps, value_t *result) {
+   ps->is_right_paren_error = false;
+   ps->status = PARSE_OK;
+
+   n_expr(ps, result);
+   return bexpr_finish(ps, 0).status;
+}
@@ -0,0 +1,15 @@
+#ifndef NUMERIC_H
+#define NUMERIC_H
+/*
+ * Purpose: Evaluate a <bexpr> in the number type value.h selects, with
+ *          overflow reported instead of wrapping. numeric.c and every
+ *          file calling it must be built with the same VALUE_* macro.
+ * Date:    2025 May 5
+ */
+#include <stdbool.h>
+#include "parser.h"
+#include "value.h"
+
+enum parse_status num_bexpr(struct parser_state *, value_t *);
+
+#endif
@@ -0,0 +1,181 @@
+/*
+ * optimize.c - constant folding and algebraic simplification of trees
+ * built by ast_parse(). The pass reads a tree and writes a simplified
+ * copy after it in the same arena:
+ *
+ *    - operators whose operands are all constant become a constant
+ *    - x + 0, 0 + x, x - 0, x * 1, 1 * x, x / 1 and x ^ 1 become x
+ *    - x ^ 0 becomes 1
+ *    - x * 0 and 0 * x become 0 when x cannot fail, which drops the dead
+ *      comparison in a select like (a < b) * 0
+ *
+ * A constant '/' or '^' that fails, such as a division by zero, is left
+ * in place so it still fails when the tree is evaluated, and so is an x
+ * that can fail under x ^ 0. Nodes a later rewrite leaves unreachable
+ * from the root are dropped at the end, so ast_eval() runs only what
+ * the result depends on. Powers are not unrolled into multiplications:
+ * ipow() already multiplies small exponents out directly, and unrolled
+ * multiplications would lose its overflow check.
+ * Date:   2025 April 27
+ */
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include "optimize.h"
+
+// folded.node of a constant that has no output node yet
+#define NO_NODE -2
+
+/*
+ * What a node of the source tree became: a constant that has not been
+ * given a node yet, or a node in the output tree.
+ */
+struct folded {
+   bool is_const;
+   int value;     // the constant, when is_const
+   int node;      // the output node, or NO_NODE if none was needed yet
+   bool may_fail; // the node has a '/' or '^' under it, so must be kept
+};
+
+/**
+ * Makes sure a folded operand has an output node, adding an INT_LITERAL
+ * for a constant the first time it is needed.
+ * @return: the node, or ERROR if out of memory
+ */
+static int materialize(struct ast_arena *arena, struct folded *f) {
+   if (f->node == NO_NODE)
+      f->node = ast_new_node(arena, INT_LITERAL, f->value, 0, 0); // Never fails, so no offset
+   return f->node;
+}
+
+/**
+ * Adds an operator node over two folded operands, keeping the offset of
+ * the operator it came from for the errors it reports.
+ * @return: the result, with node ERROR if out of memory
+ */
+static struct folded emit(struct ast_arena *arena, int kind, size_t offset, struct folded *l,
+                          struct folded *r) {
+   struct folded out = { false, 0, ERROR, false };
+   int left = materialize(arena, l), right = materialize(arena, r);
+
+   if (left != ERROR && right != ERROR)
+      out.node = ast_new_node(arena, kind, left, right, offset);
+   out.may_fail = l->may_fail || r->may_fail || kind == DIV_OP || kind == EXPON_OP;
+   return out;
+}
+
+/**
+ * Simplifies one operator given its already simplified operands.
+ * @return: the result, with node ERROR if out of memory
+ */
+static struct folded simplify(struct ast_arena *arena, int kind, size_t offset, struct folded *l,
+                              struct folded *r) {
+   struct folded out = { true, 0, NO_NODE, false };
+
+   if (l->is_const && r->is_const && ast_apply(kind, l->value, r->value, &out.value))
+      return out;
+   if (r->is_const) {
+      if ((kind == ADD_OP || kind == SUB_OP) && r->value == 0)
+         return *l;
+      if ((kind == MULT_OP || kind == DIV_OP || kind == EXPON_OP) && r->value == 1)
+         return *l;
+      if (kind == EXPON_OP && r->value == 0 && !l->may_fail) {
+         out.value = 1;
+         return out;
+      }
+      if (kind == MULT_OP && r->value == 0 && !l->may_fail)
+         return out;
+   }
+   if (l->is_const) {
+      if (kind == ADD_OP && l->value == 0)
+         return *r;
+      if (kind == MULT_OP && l->value == 1)
+         return *r;
+      if (kind == MULT_OP && l->value == 0 && !r->may_fail)
+         return out;
+   }
+   return emit(arena, kind, offset, l, r);
+}
+
+/**
+ * Drops the nodes of an output tree that are not reachable from its
+ * root, moving the rest down in order, so children still come before
+ * their parents and the root is the last node.
+ * @param arena: the arena holding the tree, whose last nodes it is
+ * @param out: the tree, updated in place
+ * @return: the number of nodes kept, or ERROR if out of memory
+ */
+static int compact(struct ast_arena *arena, struct ast *out) {
+   int size = arena->count - out->first, kept = 0, i;
+   struct ast_node *n = arena->nodes + out->first;
+   size_t *offsets = arena->offsets + out->first;
+   int *map = malloc(size * sizeof(int));
+
+   if (map == NULL)
+      return ERROR;
+   for (i = 0; i < size; i++)
+      map[i] = -1; // Not reached yet
+   map[out->root - out->first] = 0;
+   for (i = size - 1; i >= 0; i--) {
+      if (map[i] >= 0 && n[i].kind != INT_LITERAL) {
+         map[n[i].left - out->first] = 0;
+         map[n[i].right - out->first] = 0;
+      }
+   }
+   for (i = 0; i < size; i++) {
+      if (map[i] < 0)
+         continue;
+      n[kept] = n[i];
+      offsets[kept] = offsets[i];
+      if (n[kept].kind != INT_LITERAL) {
+         n[kept].left = out->first + map[n[i].left - out->first];
+         n[kept].right = out->first + map[n[i].right - out->first];
+      }
+      map[i] = kept++;
+   }
+   free(map);
+   arena->count = out->first + kept;
+   out->root = arena->count - 1;
+   return kept;
+}
+
+/**
+ * Writes a simplified copy of a tree after the last node in its arena.
+ * The original tree is left as it was.
+ * @param arena: the arena holding the tree; the copy is added to it
+ * @param tree: the tree to simplify
+ * @param out: set to the simplified tree
+ * @return: the number of nodes eliminated, or ERROR if out of memory
+ */
+int ast_fold(struct ast_arena *arena, const struct ast *tree, struct ast *out) {
+   int size = tree->root - tree->first + 1, i;
+   struct folded *f = malloc(size * sizeof(struct folded)), *root;
+
+   if (f == NULL)
+      return ERROR;
+   out->first = arena->count;
+   for (i = 0; i < size; i++) {
+      // copy the node, since adding nodes may move the array
+      struct ast_node n = arena->nodes[tree->first + i];
+      if (n.kind == INT_LITERAL) {
+         f[i].is_const = true;
+         f[i].value = n.left;
+         f[i].node = NO_NODE;
+         f[i].may_fail = false;
+      } else {
+         f[i] = simplify(arena, n.kind, arena->offsets[tree->first + i],
+                         &f[n.left - tree->first], &f[n.right - tree->first]);
+         if (f[i].node == ERROR) {
+            free(f);
+            return ERROR;
+         }
+      }
+   }
+
+   root = &f[size - 1];
+   out->root = materialize(arena, root);
+   free(f);
+   if (out->root == ERROR || (i = compact(arena, out)) == ERROR)
+      return ERROR;
+   return size - i;
+}
@@ -0,0 +1,11 @@
+#ifndef OPTIMIZE_H
+#define OPTIMIZE_H
+/*
+ * Purpose: Simplify a parsed tree before it is evaluated many times.
+ * Date:    2025 April 27
+ */
+#include "ast.h"
+
+int ast_fold(struct ast_arena *, const struct ast *, struct ast *);
+
+#endif
@@ -0,0 +1,157 @@
+/*
+ * parallel.c - splits a statement stream at ';' and evaluates the
+ * statements with bexpr() on a pool of threads. Each thread has its own
+ * parser_state, so no evaluation state is shared between threads.
+ * Date:   2025 April 24
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include "parser.h"
+#include "parallel.h"
+
+// Statements a worker claims at a time
+#define CHUNK 64
+
+struct worker_args {
+   struct statement_batch *batch;
+   atomic_int *next;   // first statement not yet claimed
+   pthread_mutex_t lock;   // guards batch->errors
+};
+
+/**
+ * Splits input into statements, copying it so each statement can be
+ * NUL-terminated right after its ';'. Text after the last ';' is kept
+ * as its own statement unless it is only whitespace.
+ * @param batch: the batch to fill
+ * @param input: the statement stream
+ * @param length: the number of bytes in input
+ * @return: the number of statements, or -1 if out of memory
+ */
+int batch_split(struct statement_batch *batch, const char *input, size_t length) {
+   size_t i, semis = 0;
+   char *out;
+
+   for (i = 0; i < length; i++) {
+      if (input[i] == ';')
+         semis++;
+   }
+
+   memset(batch, 0, sizeof(*batch));
+   batch->text = malloc(length + semis + 2);
+   batch->stmts = malloc((semis + 1) * sizeof(char *));
+   batch->results = malloc((semis + 1) * sizeof(struct eval_result));
+   if (batch->text == NULL || batch->stmts == NULL || batch->results == NULL) {
+      batch_free(batch);
+      return -1;
+   }
+
+   out = batch->text;
+   batch->stmts[0] = out;
+   for (i = 0; i < length; i++) {
+      *out++ = input[i];
+      if (input[i] == ';') {
+         *out++ = '\0';
+         batch->stmts[++batch->count] = out;
+      }
+   }
+   *out = '\0';
+
+   // keep a trailing statement that is missing its ';'
+   if (batch->stmts[batch->count][strspn(batch->stmts[batch->count], " \t\n")] != '\0')
+      batch->count++;
+   return batch->count;
+}
+
+/**
+ * Worker loop: claims CHUNK statements at a time until none are left.
+ * Errors are logged locally with offsets in the original input, which
+ * is the offset in text less the NULs batch_split() added before the
+ * statement, and handed to the batch once at the end.
+ * @param arg: the worker_args shared by all workers
+ */
+static void *worker(void *arg) {
+   struct worker_args *args = arg;
+   struct statement_batch *batch = args->batch;
+   struct parser_state ps;
+   struct error_log errors;
+   size_t j, logged = 0;
+   int first, i, last;
+
+   error_log_init(&errors);
+   while ((first = atomic_fetch_add(args->next, CHUNK)) < batch->count) {
+      last = first + CHUNK < batch->count ? first + CHUNK : batch->count;
+      for (i = first; i < last; i++) {
+         parser_init(&ps, batch->stmts[i]);
+         ps.errors = &errors;
+         batch->results[i] = bexpr(&ps);
+         for (; logged < errors.count; logged++)
+            errors.errors[logged].offset += (size_t) (batch->stmts[i] - batch->text) - i;
+      }
+   }
+
+   if (errors.count > 0 || errors.dropped > 0) {
+      pthread_mutex_lock(&args->lock);
+      for (j = 0; j < errors.count; j++)
+         error_log_add(&batch->errors, &errors.errors[j]);
+      batch->errors.dropped += errors.dropped;
+      pthread_mutex_unlock(&args->lock);
+   }
+   error_log_free(&errors);
+   return NULL;
+}
+
+// Orders errors by where they are in the input
+static int by_offset(const void *a, const void *b) {
+   size_t x = ((const struct parse_error *) a)->offset;
+   size_t y = ((const struct parse_error *) b)->offset;
+   return (x > y) - (x < y);
+}
+
+/**
+ * Evaluates every statement in the batch on the given number of threads.
+ * The calling thread does the work itself when threads is 1 or less.
+ * Errors replace whatever batch->errors held before.
+ * @param batch: a batch filled by batch_split()
+ * @param threads: the number of threads to use
+ */
+void batch_eval(struct statement_batch *batch, int threads) {
+   atomic_int next = 0;
+   struct worker_args args = { batch, &next, PTHREAD_MUTEX_INITIALIZER };
+   pthread_t *ids;
+   int i, started = 0;
+
+   batch->errors.count = batch->errors.dropped = 0;
+   if (threads <= 1 || (ids = malloc(threads * sizeof(pthread_t))) == NULL) {
+      worker(&args);
+      return;
+   }
+   for (i = 0; i < threads; i++) {
+      if (pthread_create(&ids[started], NULL, worker, &args) == 0)
+         started++;
+   }
+   if (started == 0)
+      worker(&args); // no threads could be created; do the work here
+   for (i = 0; i < started; i++)
+      pthread_join(ids[i], NULL);
+   free(ids);
+
+   // each worker's errors are in order, but the workers interleave
+   if (batch->errors.count > 1)
+      qsort(batch->errors.errors, batch->errors.count, sizeof(struct parse_error), by_offset);
+}
+
+/**
+ * Frees the memory held by a batch.
+ * @param batch: the batch to free
+ */
+void batch_free(struct statement_batch *batch) {
+   free(batch->text);
+   free(batch->stmts);
+   free(batch->results);
+   error_log_free(&batch->errors);
+   memset(batch, 0, sizeof(*batch));
+}
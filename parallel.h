@@ -0,0 +1,29 @@
+#ifndef PARALLEL_H
+#define PARALLEL_H
+/*
+ * Purpose: Evaluate a stream of <bexpr> statements on several threads.
+ * Date:    2025 April 24
+ */
+#include <stddef.h>
+#include "parser.h"
+
+/*
+ * A stream split at ';' boundaries. Every statement is NUL-terminated
+ * inside text, and results[i] is the value of stmts[i], so results come
+ * back in input order no matter which thread evaluated them. A statement
+ * that fails does not stop the others; its error is collected in errors
+ * with its offset in the original input.
+ */
+struct statement_batch {
+   char *text;       // copy of the input, one NUL after each ';'
+   char **stmts;     // start of each statement in text
+   struct eval_result *results;   // bexpr() result of each statement
+   int count;        // number of statements
+   struct error_log errors;       // every error, in input order
+};
+
+int batch_split(struct statement_batch *, const char *, size_t);
+void batch_eval(struct statement_batch *, int);
+void batch_free(struct statement_batch *);
+
+#endif
@@ -10,9 +10,12 @@
 #include <stdlib.h>
 #include <string.h>
 #include <ctype.h>
-#include <math.h>
+#include <limits.h>
 #include "tokenizer.h"
 #include "parser.h"
+#include "ipow.h"
+#include "tokcache.h"
+#include "stats.h"
 #include <stdbool.h>
 
 /*
@@ -31,38 +34,235 @@
  * <num> ::=  {0 | 1 | 2 | 3 | 4 | 5 | 6 | 7 | 8 | 9}+
  */
 
-// Constants
-#define ERROR -1
-#define TSIZE 20
+// Bits are less, equal, greater, from the lowest; see parser.h
+const unsigned char compare_outcomes[TOKEN_KIND_COUNT] = {
+   [LESS_THAN_OP] = 1, [LESS_THAN_OR_EQUAL_OP] = 3,
+   [EQUALS_OP] = 2, [NOT_EQUALS_OP] = 5,
+   [GREATER_THAN_OP] = 4, [GREATER_THAN_OR_EQUAL_OP] = 6
+};
 
-// Global variables
-bool is_right_paren_error;
-char token[TSIZE];
-char current_category[TSIZE];
-int value;
+/**
+ * Points the parser at a NUL-terminated input and reads the first token.
+ * @param ps: the parser state to initialize
+ * @param input: the text to parse, one or more <bexpr>s
+ */
+void parser_init(struct parser_state *ps, char *input) {
+   parser_init_range(ps, input, strlen(input));
+}
+
+/**
+ * Points the parser at the first length bytes of an input, which need
+ * not be NUL-terminated, and reads the first token. Parsing a slice of
+ * a large input this way does not read the rest of it.
+ * @param ps: the parser state to initialize
+ * @param input: the text to parse
+ * @param length: the number of bytes of it to parse
+ */
+void parser_init_range(struct parser_state *ps, char *input, size_t length) {
+   ps->lex.line = ps->lex.line_start = input;
+   ps->lex.end = input + length;
+   ps->is_right_paren_error = false;
+   ps->value = 0;
+   ps->status = PARSE_OK;
+   ps->input = input;
+   ps->errors = NULL;
+   ps->cached = NULL;
+   next_token(ps);
+}
+
+/**
+ * Points the parser at an input whose tokens come from a token_cache
+ * built from it, so the input is never lexed. The input is still read
+ * for the text of each lexeme.
+ * @param ps: the parser state to initialize
+ * @param input: the text the cache was built from
+ * @param tc: the cached tokens of input
+ */
+void parser_init_cached(struct parser_state *ps, char *input,
+                        const struct token_cache *tc) {
+   parser_init_tokens(ps, input, tc->source_length,
+                      tokcache_tokens(tc), tc->data + tc->length);
+}
+
+/**
+ * Points the parser at an input and a run of encoded tokens lexed from
+ * it, such as one statement's share of a larger token stream.
+ * @param ps: the parser state to initialize
+ * @param input: the text the tokens were lexed from
+ * @param length: the number of bytes in input
+ * @param tokens: the first encoded token
+ * @param tokens_end: the end of the encoded tokens
+ */
+void parser_init_tokens(struct parser_state *ps, char *input, size_t length,
+                        const unsigned char *tokens, const unsigned char *tokens_end) {
+   ps->lex.line = ps->lex.line_start = input;
+   ps->lex.end = input + length;
+   ps->is_right_paren_error = false;
+   ps->value = 0;
+   ps->status = PARSE_OK;
+   ps->input = input;
+   ps->errors = NULL;
+   ps->cached = tokens;
+   ps->cached_end = tokens_end;
+   next_token(ps);
+}
+
+/**
+ * Decodes the next token from the token cache. A stream that does not
+ * fit the input ends it early rather than reading past either one.
+ * @param ps: the parser state
+ */
+static void next_cached_token(struct parser_state *ps) {
+   struct lexer_state *lex = &ps->lex;
+   const unsigned char *p = ps->cached;
+   uint64_t gap = 0, length = 0;
+   enum token_kind kind = END_OF_INPUT;
+   int value = 0;
+
+   if (p < ps->cached_end) {
+      unsigned char first = *p++;
+
+      kind = (enum token_kind) (first & TOKCACHE_KIND_MASK);
+      gap = first >> TOKCACHE_GAP_SHIFT & 3;
+      if (gap == TOKCACHE_LONG_GAP) {
+         gap = tokcache_varint(&p, ps->cached_end);
+      }
+      if (kind == INT_LITERAL) {
+         value = (int) tokcache_varint(&p, ps->cached_end);
+         length = first & TOKCACHE_HAS_LENGTH ? tokcache_varint(&p, ps->cached_end)
+                                              : (uint64_t) tokcache_digits((unsigned int) value);
+      } else if (kind == IDENTIFIER) {
+         length = first & TOKCACHE_HAS_LENGTH ? tokcache_varint(&p, ps->cached_end) : 0;
+      } else {
+         length = (uint64_t) tokcache_fixed_length(kind);
+      }
+      if (kind > INVALID || length == 0 || gap + length > (uint64_t) (lex->end - lex->line))
+         kind = END_OF_INPUT;
+   }
+   if (kind == END_OF_INPUT) {
+      ps->cached = ps->cached_end;
+      lex->line = lex->end;
+      lex->kind = END_OF_INPUT;
+      lex->lexeme_offset = (int) (lex->line - lex->line_start);
+      lex->lexeme_length = 0;
+      ps->token = (struct lexeme) { END_OF_INPUT, lex->line, 0, 0 };
+      return;
+   }
+   ps->cached = p;
+   lex->line += gap;
+   lex->kind = kind;
+   lex->lexeme_offset = (int) (lex->line - lex->line_start);
+   lex->lexeme_length = (int) length;
+   lex->line += length;
+   ps->token = (struct lexeme) { kind, lex->line - length, (int) length, value };
+}
+
+/**
+ * Skips whitespace and reads the next token into the parser state, as a
+ * descriptor pointing into the input. The current token is always the
+ * one the grammar functions look at next.
+ * @param ps: the parser state
+ */
+void next_token(struct parser_state *ps) {
+   if (ps->cached != NULL) {
+      next_cached_token(ps);
+      return;
+   }
+   next_lexeme(&ps->lex, &ps->token);
+}
+
+/**
+ * Byte offset of the current token from the start of the input.
+ * @param ps: the parser state
+ * @return: the offset, which is the input length at END_OF_INPUT
+ */
+size_t token_offset(const struct parser_state *ps) {
+   return (size_t) (ps->token.start - ps->input);
+}
+
+/**
+ * Records an error in the current <bexpr>. Only the first one counts:
+ * anything after it is a consequence of it, so later calls do nothing
+ * until bexpr() starts the next statement. The error goes to the
+ * parser's error_log if it has one, and to stderr otherwise.
+ * @param ps: the parser state
+ * @param status: what went wrong
+ * @param offset: byte offset of the token at fault
+ * @param message: static text describing the error
+ */
+void parse_error(struct parser_state *ps, enum parse_status status, size_t offset,
+                 const char *message) {
+   if (ps->status != PARSE_OK) {
+      return;
+   }
+   ps->status = status;
+   if (ps->errors != NULL) {
+      struct parse_error error = { status, offset, message };
+      error_log_add(ps->errors, &error);
+   } else {
+      fprintf(stderr, "%s\n", message);
+   }
+}
+
+/**
+ * Skips the rest of a failed <bexpr>, through its ';', so the next
+ * bexpr() call starts cleanly at the following statement.
+ * @param ps: the parser state
+ */
+static void recover(struct parser_state *ps) {
+   while (ps->lex.kind != SEMI_COLON && ps->lex.kind != END_OF_INPUT) {
+      next_token(ps);
+   }
+   if (ps->lex.kind == SEMI_COLON) {
+      next_token(ps); // Consume the semicolon
+   }
+}
 
 /**
  * <bexpr> -> <expr> ;
  * The function for the non-terminal <bexpr> that views
  * the boolean expression as an expression followed by a semicolon.
- * @return: the number of the evaluated expression or an error
+ * On an error the rest of the statement is skipped, so calling bexpr()
+ * again goes on with the next one.
+ * @param ps: the parser state
+ * @return: the status of the evaluation and, if PARSE_OK, its value
  */
-int bexpr(char *token) {
-   is_right_paren_error = false;
+struct eval_result bexpr(struct parser_state *ps) {
+   struct eval_result result;
 
-   int result = expr(token); // Evaluate the expression
-   if (result == ERROR) {
-      return result; // Return error if the expression is invalid
-   }
+   ps->is_right_paren_error = false;
+   ps->status = PARSE_OK;
+
+   STATS_TIMED(PHASE_EVAL, result = bexpr_finish(ps, expr(ps))); // Evaluate the expression
+   STATS_STATEMENT();
+   return result;
+}
+
+/**
+ * The ';' that ends a <bexpr>, for any evaluator of <expr>: checks for
+ * it and consumes it, or skips to the next statement after an error.
+ * @param ps: the parser state, just past an <expr>
+ * @param value: the value of the <expr>
+ * @return: the status of the evaluation and, if PARSE_OK, its value
+ */
+struct eval_result bexpr_finish(struct parser_state *ps, int value) {
+   struct eval_result result;
+
+   result.value = value;
 
    // Check for the semicolon at the end
-   if (strcmp(current_category, "SEMI_COLON") == 0) {
-      get_token(token); // Consume the semicolon
-      return result; // Return the evaluated result
-   } else {
-      fprintf(stderr, "Syntax Error: ';' expected\n");
-      return ERROR; // Return error if semicolon is missing
+   if (ps->status == PARSE_OK && ps->lex.kind != SEMI_COLON) {
+      parse_error(ps, PARSE_SYNTAX_ERROR, token_offset(ps), "Syntax Error: ';' expected");
    }
+   result.status = ps->status;
+   if (result.status != PARSE_OK) {
+      recover(ps); // Resynchronize at the next statement
+      result.value = 0;
+      return result;
+   }
+   next_token(ps); // Consume the semicolon
+   ps->value = result.value;
+   return result;
 }
 
 /**
@@ -70,16 +270,21 @@ int bexpr(char *token) {
  * The function for the non-terminal <expr> that views
  * the expression as a series of terms and addition and
  * subtraction operators.
- * @param token: the line being read
- * @return: the number of the evaluated expression or an error
+ * @param ps: the parser state
+ * @return: the number of the evaluated expression; see ps->status
  */
-int expr(char *token) {
-   int subtotal = term(token); // Parse the term
-   if (subtotal == ERROR) {
-      return subtotal; // Return error if term parsing fails
+int expr(struct parser_state *ps) {
+   int subtotal;
+
+   STATS_ENTER(); // Each '(' recurses through here
+   subtotal = term(ps); // Parse the term
+   if (ps->status != PARSE_OK) {
+      subtotal = 0; // Give up if term parsing fails
    } else {
-      return ttail(token, subtotal); // Parse the term tail
+      subtotal = ttail(ps, subtotal); // Parse the term tail
    }
+   STATS_LEAVE();
+   return subtotal;
 }
 
 /**
@@ -88,40 +293,39 @@ int expr(char *token) {
  * the rest of an arithmetic expression after the initial
  * term. So it expects an addition or subtraction operator
  * first or the empty string.
- * @param token: the line being read
+ * @param ps: the parser state
  * @param subtotal: the number we have evaluated up to this
  *                  point
- * @return: the number of the evaluated expression or an error
+ * @return: the number of the evaluated expression; see ps->status
  */
-int ttail(char *token, int subtotal)
+int ttail(struct parser_state *ps, int subtotal)
 {
    int term_value;
 
-   if (!strncmp(token, "+", 1))
-   {
-      add_sub_tok(token);
-      term_value = term(token);
-
-      // if term returned an error, give up otherwise call ttail
-      if (term_value == ERROR)
-         return term_value;
-      else
-         return ttail(token, (subtotal + term_value));
-   }
-   else if(!strncmp(token, "-", 1))
+   switch (ps->lex.kind)
    {
-      add_sub_tok(token);
-      term_value = term(token);
-
-      // if term returned an error, give up otherwise call ttail
-      if (term_value == ERROR)
-         return term_value;
-      else
-         return ttail(token, (subtotal - term_value));
+      case ADD_OP:
+         add_sub_tok(ps);
+         term_value = term(ps);
+
+         // if term returned an error, give up otherwise call ttail
+         if (ps->status != PARSE_OK)
+            return 0;
+         else
+            return ttail(ps, (subtotal + term_value));
+      case SUB_OP:
+         add_sub_tok(ps);
+         term_value = term(ps);
+
+         // if term returned an error, give up otherwise call ttail
+         if (ps->status != PARSE_OK)
+            return 0;
+         else
+            return ttail(ps, (subtotal - term_value));
+      /* empty string */
+      default:
+         return subtotal;
    }
-   /* empty string */
-   else
-      return subtotal;
 }
 
 
@@ -130,15 +334,15 @@ int ttail(char *token, int subtotal)
  * The function for the non-terminal <term> that views
  * the expression as a series of statements and multiplication or
  * division operators.
- * @param token: the current token being processed
- * @return: the number of the evaluated term or an error
+ * @param ps: the parser state
+ * @return: the number of the evaluated term; see ps->status
  */
-int term(char *token) {
-   int term_value = stmt(token); // Parse the statement
-   if (term_value == ERROR) {
-      return term_value; // Return error if statement parsing fails
+int term(struct parser_state *ps) {
+   int term_value = stmt(ps); // Parse the statement
+   if (ps->status != PARSE_OK) {
+      return 0; // Give up if statement parsing fails
    } else {
-      return stail(token, term_value); // Parse the statement tail
+      return stail(ps, term_value); // Parse the statement tail
    }
 }
 
@@ -146,15 +350,15 @@ int term(char *token) {
  * <stmt> -> <factor> <ftail>
  * The function for the non-terminal <stmt> that views
  * the expression as a series of factors and logical operators.
- * @param token: the current token being processed
- * @return: the number of the evaluated statement or an error
+ * @param ps: the parser state
+ * @return: the number of the evaluated statement; see ps->status
  */
-int stmt(char *token) {
-   int stmt_value = factor(token); // Parse the factor
-   if (stmt_value == ERROR) {
-      return stmt_value; // Return error if factor parsing fails
+int stmt(struct parser_state *ps) {
+   int stmt_value = factor(ps); // Parse the factor
+   if (ps->status != PARSE_OK) {
+      return 0; // Give up if factor parsing fails
    } else {
-      return ftail(token, stmt_value); // Parse the factor tail
+      return ftail(ps, stmt_value); // Parse the factor tail
    }
 }
 
@@ -162,34 +366,42 @@ int stmt(char *token) {
  * <stail> -> <mult_div_tok> <stmt> <stail> | e
  * The function for the non-terminal <stail> that processes
  * multiplication or division operations in a term.
- * @param token: the current token being processed
+ * @param ps: the parser state
  * @param subtotal: the number we have evaluated up to this point
- * @return: the number of the evaluated term or an error
+ * @return: the number of the evaluated term; see ps->status
  */
-int stail(char *token, int subtotal) {
+int stail(struct parser_state *ps, int subtotal) {
    int stmt_value;
-
-   get_token(token); // Get the next token
-   if (strcmp(current_category, "MULT_OP") == 0) {
-      mul_div_tok(token); // Process multiplication operator
-      stmt_value = stmt(token); // Parse the next statement
-
-      if (stmt_value == ERROR) {
-         return stmt_value; // Return error if statement parsing fails
-      } else {
-         return stail(token, subtotal * stmt_value); // Continue parsing
-      }
-   } else if (strcmp(current_category, "DIV_OP") == 0) {
-      mul_div_tok(token); // Process division operator
-      stmt_value = stmt(token); // Parse the next statement
-
-      if (stmt_value == ERROR) {
-         return stmt_value; // Return error if statement parsing fails
-      } else {
-         return stail(token, subtotal / stmt_value); // Continue parsing
-      }
-   } else {
-      return subtotal; // Return subtotal if no operator is found
+   size_t op_offset;
+
+   switch (ps->lex.kind) {
+      case MULT_OP:
+         mul_div_tok(ps); // Process multiplication operator
+         stmt_value = stmt(ps); // Parse the next statement
+
+         if (ps->status != PARSE_OK) {
+            return 0; // Give up if statement parsing fails
+         } else {
+            return stail(ps, subtotal * stmt_value); // Continue parsing
+         }
+      case DIV_OP:
+         op_offset = token_offset(ps);
+         mul_div_tok(ps); // Process division operator
+         stmt_value = stmt(ps); // Parse the next statement
+
+         if (ps->status != PARSE_OK) {
+            return 0; // Give up if statement parsing fails
+         } else if (stmt_value == 0) {
+            parse_error(ps, PARSE_DIVIDE_BY_ZERO, op_offset, "Math Error: division by zero");
+            return 0;
+         } else if (stmt_value == -1 && subtotal == INT_MIN) {
+            parse_error(ps, PARSE_OVERFLOW, op_offset, "Overflow Error: '/' result out of range");
+            return 0;
+         } else {
+            return stail(ps, subtotal / stmt_value); // Continue parsing
+         }
+      default:
+         return subtotal; // Return subtotal if no operator is found
    }
 }
 
@@ -197,23 +409,28 @@ int stail(char *token, int subtotal) {
  * <factor> -> <expp> ^ <factor> | <expp>
  * The function for the non-terminal <factor> that views
  * the expression as a series of <expp> and factors.
- * @param token: the current token being processed
- * @return: the number of the evaluated factor or an error
+ * @param ps: the parser state
+ * @return: the number of the evaluated factor; see ps->status
  */
-int factor(char *token) {
-   int factor_value = expp(token); // Parse the <expp>
-   if (factor_value == ERROR) {
-      return factor_value; // Return error if <expp> parsing fails
+int factor(struct parser_state *ps) {
+   int factor_value = expp(ps); // Parse the <expp>
+   if (ps->status != PARSE_OK) {
+      return 0; // Give up if <expp> parsing fails
    }
 
-   get_token(token); // Get the next token
-   if (strcmp(current_category, "EXPON_OP") == 0) {
-      expon_tok(token); // Process the exponentiation operator
-      int next_factor = factor(token); // Parse the next <factor>
-      if (next_factor == ERROR) {
-         return ERROR; // Return error if the next <factor> parsing fails
+   if (ps->lex.kind == EXPON_OP) {
+      size_t op_offset = token_offset(ps);
+      expon_tok(ps); // Process the exponentiation operator
+      STATS_ENTER(); // So does each '^'
+      int next_factor = factor(ps); // Parse the next <factor>
+      STATS_LEAVE();
+      if (ps->status != PARSE_OK) {
+         return 0; // Give up if the next <factor> parsing fails
+      }
+      if (!ipow(factor_value, next_factor, &factor_value)) { // Compute the power
+         parse_error(ps, PARSE_OVERFLOW, op_offset, "Overflow Error: '^' result out of range");
+         return 0;
       }
-      return pow(factor_value, next_factor); // Compute the power
    }
 
    return factor_value; // Return the value of <expp> if no exponentiation
@@ -223,59 +440,25 @@ int factor(char *token) {
  * <ftail> -> <compare_tok> <factor> <ftail> | e
  * The function for the non-terminal <ftail> that processes
  * comparison operators in a statement.
- * @param token: the current token being processed
+ * @param ps: the parser state
  * @param subtotal: the number we have evaluated up to this point
- * @return: the number of the evaluated statement or an error
+ * @return: the number of the evaluated statement; see ps->status
  */
-int ftail(char *token, int subtotal) {
-    get_token(token); // Get the next token
+int ftail(struct parser_state *ps, int subtotal) {
+    enum token_kind op = ps->lex.kind;
     int factor_value;
 
-    if (strcmp(current_category, "LESS_THAN_OP") == 0) {
-        compare_tok(token); // Process '<' operator
-        factor_value = factor(token); // Parse the next <factor>
-        if (factor_value == ERROR) {
-            return ERROR; // Return error if <factor> parsing fails
-        }
-        return ftail(token, subtotal < factor_value); // Continue parsing
-    } else if (strcmp(current_category, "GREATER_THAN_OP") == 0) {
-        compare_tok(token); // Process '>' operator
-        factor_value = factor(token); // Parse the next <factor>
-        if (factor_value == ERROR) {
-            return ERROR; // Return error if <factor> parsing fails
-        }
-        return ftail(token, subtotal > factor_value); // Continue parsing
-    } else if (strcmp(current_category, "NOT_EQUALS_OP") == 0) {
-        compare_tok(token); // Process '!=' operator
-        factor_value = factor(token); // Parse the next <factor>
-        if (factor_value == ERROR) {
-            return ERROR; // Return error if <factor> parsing fails
-        }
-        return ftail(token, subtotal != factor_value); // Continue parsing
-    } else if (strcmp(current_category, "EQUALS_OP") == 0) {
-        compare_tok(token); // Process '==' operator
-        factor_value = factor(token); // Parse the next <factor>
-        if (factor_value == ERROR) {
-            return ERROR; // Return error if <factor> parsing fails
-        }
-        return ftail(token, subtotal == factor_value); // Continue parsing
-    } else if (strcmp(current_category, "GREATER_THAN_OR_EQUAL_OP") == 0) {
-        compare_tok(token); // Process '>=' operator
-        factor_value = factor(token); // Parse the next <factor>
-        if (factor_value == ERROR) {
-            return ERROR; // Return error if <factor> parsing fails
-        }
-        return ftail(token, subtotal >= factor_value); // Continue parsing
-    } else if (strcmp(current_category, "LESS_THAN_OR_EQUAL_OP") == 0) {
-        compare_tok(token); // Process '<=' operator
-        factor_value = factor(token); // Parse the next <factor>
-        if (factor_value == ERROR) {
-            return ERROR; // Return error if <factor> parsing fails
-        }
-        return ftail(token, subtotal <= factor_value); // Continue parsing
+    if (compare_outcomes[op] == 0) {
+        return subtotal; // Return subtotal if no comparison operator is found
+    }
+    compare_tok(ps); // Process the comparison operator
+    factor_value = factor(ps); // Parse the next <factor>
+    if (ps->status != PARSE_OK) {
+        return 0; // Give up if <factor> parsing fails
     }
 
-    return subtotal; // Return subtotal if no comparison operator is found
+    // One table lookup for every operator, so mixed operators cost no mispredictions
+    return ftail(ps, compare_values(op, subtotal, factor_value)); // Continue parsing
 }
 
 /**
@@ -283,39 +466,41 @@ int ftail(char *token, int subtotal) {
  * The function for the non-terminal <expp> that views
  * the expression as a series of terms and addition and
  * subtraction operators.
- * @param token: the current token being processed
- * @return: the number of the evaluated expression or an error
+ * @param ps: the parser state
+ * @return: the number of the evaluated expression; see ps->status
  */
-int expp(char *token) {
-   get_token(token); // Get the next token
+int expp(struct parser_state *ps) {
    int expp_value;
 
-   if (strcmp(current_category, "LEFT_PAREN") == 0) {
-      get_token(token); // Consume the left parenthesis
-      expp_value = expr(token); // Parse the expression inside parentheses
+   if (ps->lex.kind == LEFT_PAREN) {
+      next_token(ps); // Consume the left parenthesis
+      expp_value = expr(ps); // Parse the expression inside parentheses
+      if (ps->status != PARSE_OK) {
+         return 0;
+      }
 
-      if (strcmp(current_category, "RIGHT_PAREN") == 0) {
-         get_token(token); // Consume the right parenthesis
+      if (ps->lex.kind == RIGHT_PAREN) {
+         next_token(ps); // Consume the right parenthesis
          return expp_value; // Return the evaluated expression
       } else {
-         is_right_paren_error = true; // Set error flag for mismatched parentheses
-         return ERROR; // Return error
+         ps->is_right_paren_error = true; // Set error flag for mismatched parentheses
+         parse_error(ps, PARSE_SYNTAX_ERROR, token_offset(ps), "Syntax Error: ')' expected");
+         return 0;
       }
    } else {
-      return num(token); // Parse and return the numeric value
+      return num(ps); // Parse and return the numeric value
    }
 }
 
 /**
  * <add_sub_tok> ::= + | -
  * The terminal state for addition or subtraction tokens.
- * @param token: the current token being processed
+ * @param ps: the parser state
  */
-void add_sub_tok(char *token) {
-   get_token(token); // Advance to the next token
-   if (strcmp(current_category, "ADD_OP") == 0 || strcmp(current_category, "SUB_OP") == 0) {
+void add_sub_tok(struct parser_state *ps) {
+   if (ps->lex.kind == ADD_OP || ps->lex.kind == SUB_OP) {
       // Valid addition or subtraction operator
-      return;
+      next_token(ps); // Advance to the next token
    } else {
       fprintf(stderr, "Syntax Error: Expected '+' or '-'\n");
    }
@@ -324,13 +509,12 @@ void add_sub_tok(char *token) {
 /**
  * <mul_div_tok> ::= * | /
  * The terminal state for multiplication or division tokens.
- * @param token: the current token being processed
+ * @param ps: the parser state
  */
-void mul_div_tok(char *token) {
-   get_token(token); // Advance to the next token
-   if (strcmp(current_category, "MULT_OP") == 0 || strcmp(current_category, "DIV_OP") == 0) {
+void mul_div_tok(struct parser_state *ps) {
+   if (ps->lex.kind == MULT_OP || ps->lex.kind == DIV_OP) {
       // Valid multiplication or division operator
-      return;
+      next_token(ps); // Advance to the next token
    } else {
       fprintf(stderr, "Syntax Error: Expected '*' or '/'\n");
    }
@@ -339,59 +523,100 @@ void mul_div_tok(char *token) {
 /**
  * <compare_tok> ::= < | > | <= | >= | != | ==
  * The terminal state for comparison tokens.
- * @param token: the current token being processed
+ * @param ps: the parser state
  */
-void compare_tok(char *token) {
-   get_token(token); // Advance to the next token
-   if (strcmp(current_category, "LESS_THAN_OP") == 0 ||
-       strcmp(current_category, "GREATER_THAN_OP") == 0 ||
-       strcmp(current_category, "LESS_THAN_OR_EQUAL_OP") == 0 ||
-       strcmp(current_category, "GREATER_THAN_OR_EQUAL_OP") == 0 ||
-       strcmp(current_category, "NOT_EQUALS_OP") == 0 ||
-       strcmp(current_category, "EQUALS_OP") == 0) {
+void compare_tok(struct parser_state *ps) {
+   if (compare_outcomes[ps->lex.kind] != 0) {
       // Valid comparison operator
-      return;
-       } else {
-          fprintf(stderr, "Syntax Error: Expected a comparison operator\n");
-       }
+      next_token(ps); // Advance to the next token
+   } else {
+      fprintf(stderr, "Syntax Error: Expected a comparison operator\n");
+   }
+}
+
+/**
+ * ^
+ * The terminal state for the exponentiation token.
+ * @param ps: the parser state
+ */
+void expon_tok(struct parser_state *ps) {
+   if (ps->lex.kind == EXPON_OP) {
+      next_token(ps); // Advance to the next token
+   } else {
+      fprintf(stderr, "Syntax Error: Expected '^'\n");
+   }
 }
 
 /**
  * <num> ::= {0 | 1 | 2 | 3 | 4 | 5 | 6 | 7 | 8 | 9}+
  * Parses a numeric token and returns its integer value.
- * @param token: the current token being processed
- * @return: the numeric value if valid, or ERROR if invalid
+ * @param ps: the parser state
+ * @return: the numeric value if valid; see ps->status
  */
-int num(char *token) {
-   if (is_number(token)) { // Check if the token is a valid number
-      int number = atoi(token); // Convert the token to an integer
-      get_token(token); // Advance to the next token
+int num(struct parser_state *ps) {
+   if (is_number(&ps->token)) { // Check if the token is a valid number
+      int number = token_int(ps); // Convert the token to an integer
+      next_token(ps); // Advance to the next token
       return number; // Return the parsed number
    } else {
-      fprintf(stderr, "Syntax Error: Expected a number\n");
-      return ERROR; // Return error if the token is not a number
+      parse_error(ps, PARSE_SYNTAX_ERROR, token_offset(ps), "Syntax Error: Expected a number");
+      return 0;
    }
 }
 
+/**
+ * The value of the current INT_LITERAL, decoded from every digit of the
+ * lexeme when it was read, or taken from the token cache.
+ * @param ps: the parser state
+ * @return: the value of the lexeme
+ */
+int token_int(struct parser_state *ps) {
+   return ps->token.value;
+}
+
 /**
  * Determines if the token is a number
  * @param token the token to check
  * @return if it is a number
  */
-int is_number(char *token){
-   return isdigit(*token);
+int is_number(const struct lexeme *token){
+   return token->length > 0 && isdigit((unsigned char) *token->start);
+}
+
+/**
+ * Sets up an empty error log.
+ * @param log: the log to initialize
+ */
+void error_log_init(struct error_log *log) {
+   memset(log, 0, sizeof(*log));
 }
 
 /**
- * Removes leading whitespace in a string
- * @param string the string to remove whitespace from
+ * Appends an error to a log.
+ * @param log: the log
+ * @param error: the error to copy in
+ * @return: false if out of memory, in which case the error is only counted
  */
-char* remove_white_space(char *string){
-   while(strncmp(string, " ", 1) == 0
-       || strncmp(string, "\t", 1) == 0
-       || strncmp(string, "\n", 1) == 0){
-      string++;
-       }
-   return string;
+bool error_log_add(struct error_log *log, const struct parse_error *error) {
+   if (log->count == log->capacity) {
+      size_t capacity = log->capacity > 0 ? 2 * log->capacity : 16;
+      struct parse_error *bigger = realloc(log->errors, capacity * sizeof(struct parse_error));
+      if (bigger == NULL) {
+         log->dropped++;
+         return false;
+      }
+      log->errors = bigger;
+      log->capacity = capacity;
+   }
+   log->errors[log->count++] = *error;
+   return true;
 }
 
+/**
+ * Frees the errors held by a log.
+ * @param log: the log to free
+ */
+void error_log_free(struct error_log *log) {
+   free(log->errors);
+   error_log_init(log);
+}
@@ -3,23 +3,114 @@
 /*
  * Author:  William Kreahling and Mark Holliday
  * Purpose: Function Prototypes for parser.c
- * Date:    2025 March 30 
+ * Date:    2025 March 30
  */
-int bexpr(char *);	// bexpr is short for boolean_expression
-int expr(char *);     // expr is short for expression
-int term(char *);
-int ttail(char *, int);       // ttail is short for term_tail
-int stmt(char *);
-int stail(char *, int);      // stail is short for statement_tail
-int factor(char *);
-int ftail(char *, int);	// ftail is short for factor_tail
-int expp(char *);     // expp is short for exponentiation
-
-void add_sub_tok(char *);
-void mul_div_tok(char *);
-void compare_tok(char *);
-void expon_tok(char *); // helper function
-int num(char *);
-int is_number(char *);  // helper function
+#include <stdbool.h>
+#include <stddef.h>
+#include "tokenizer.h"
+#include "tokcache.h"
+
+// Constants
+#define ERROR -1   // failure value of functions that never return a negative
+
+/*
+ * How an evaluation ended. The value that goes with any status but
+ * PARSE_OK means nothing; -1 is as good a result as any other.
+ */
+enum parse_status {
+   PARSE_OK,
+   PARSE_SYNTAX_ERROR,
+   PARSE_OVERFLOW,
+   PARSE_DIVIDE_BY_ZERO,
+   PARSE_OUT_OF_MEMORY
+};
+
+// What bexpr() returns: a value and whether it can be used
+struct eval_result {
+   enum parse_status status;
+   int value;
+};
+
+// One error, found at a byte offset in the input
+struct parse_error {
+   enum parse_status status;
+   size_t offset;             // where the offending token starts
+   const char *message;       // the text that would go to stderr
+};
+
+/*
+ * Errors gathered instead of printed, in the order they were found.
+ * Errors that arrive when there is no memory to grow are only counted.
+ */
+struct error_log {
+   struct parse_error *errors;
+   size_t count;
+   size_t capacity;
+   size_t dropped;
+};
+
+/*
+ * Bit 0, 1 or 2 of compare_outcomes[kind] is the value of the comparison
+ * kind when its left operand is less than, equal to or greater than its
+ * right one. Every token that is not a comparison has 0.
+ */
+extern const unsigned char compare_outcomes[TOKEN_KIND_COUNT];
+
+/**
+ * Applies a comparison operator without branching on it: the order of
+ * a and b selects one bit of the operator's outcomes.
+ * @return: 1 if a kind b holds, otherwise 0
+ */
+static inline int compare_values(int kind, int a, int b) {
+   return compare_outcomes[kind] >> ((a > b) - (a < b) + 1) & 1;
+}
+
+/*
+ * Everything one evaluation needs. Each thread evaluating input owns
+ * its own parser_state, so bexpr() can run on many inputs at once.
+ */
+struct parser_state {
+   struct lexer_state lex;      // lexer position and current lexeme
+   struct lexeme token;         // the current token, a view into the input
+   bool is_right_paren_error;   // set when a ')' is missing
+   int value;                   // value of the last complete <bexpr>
+   enum parse_status status;    // first error in the current <bexpr>
+   char *input;                 // start of the input, for error offsets
+   struct error_log *errors;    // where errors go, or NULL for stderr
+   const unsigned char *cached;      // next token in a token_cache, or NULL
+   const unsigned char *cached_end;  // end of the cached tokens
+};
+
+void parser_init(struct parser_state *, char *);
+void parser_init_range(struct parser_state *, char *, size_t);
+void parser_init_cached(struct parser_state *, char *, const struct token_cache *);
+void parser_init_tokens(struct parser_state *, char *, size_t,
+                        const unsigned char *, const unsigned char *);
+void next_token(struct parser_state *);
+void parse_error(struct parser_state *, enum parse_status, size_t, const char *);
+size_t token_offset(const struct parser_state *);
+
+void error_log_init(struct error_log *);
+bool error_log_add(struct error_log *, const struct parse_error *);
+void error_log_free(struct error_log *);
+
+struct eval_result bexpr(struct parser_state *);	// bexpr is short for boolean_expression
+struct eval_result bexpr_finish(struct parser_state *, int);
+int expr(struct parser_state *);     // expr is short for expression
+int term(struct parser_state *);
+int ttail(struct parser_state *, int);       // ttail is short for term_tail
+int stmt(struct parser_state *);
+int stail(struct parser_state *, int);      // stail is short for statement_tail
+int factor(struct parser_state *);
+int ftail(struct parser_state *, int);	// ftail is short for factor_tail
+int expp(struct parser_state *);     // expp is short for exponentiation
+
+void add_sub_tok(struct parser_state *);
+void mul_div_tok(struct parser_state *);
+void compare_tok(struct parser_state *);
+void expon_tok(struct parser_state *); // helper function
+int num(struct parser_state *);
+int is_number(const struct lexeme *);  // helper function
+int token_int(struct parser_state *);  // helper function
 
 #endif
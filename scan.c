@@ -0,0 +1,298 @@
+/*
+ * scan.c - kernels that find the end of a run of whitespace or digits and
+ * convert digit runs to integers, 16 (SSE2) or 32 (AVX2) bytes at a time.
+ * Every kernel has a scalar version, which is used on other CPUs, for the
+ * tail of a run shorter than one vector, and as the reference the vector
+ * versions must agree with.
+ * Date:   2025 April 30
+ */
+
+#include <stdint.h>
+#include <string.h>
+#include "scan.h"
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#define SCAN_X86
+#include <immintrin.h>
+#endif
+
+/**
+ * Scalar skip_space.
+ */
+static char *skip_space_scalar(char *p, char *end, int *newlines, char **line_start) {
+    while (p < end && (*p == ' ' || *p == '\t' || *p == '\n')) {
+        if (*p == '\n') {
+            (*newlines)++;
+            *line_start = p + 1;
+        }
+        p++;
+    }
+    return p;
+}
+
+/**
+ * Scalar skip_digits.
+ */
+static char *skip_digits_scalar(char *p, char *end) {
+    while (p < end && (unsigned char) (*p - '0') <= 9)
+        p++;
+    return p;
+}
+
+/**
+ * Scalar parse_digits.
+ */
+static int parse_digits_scalar(const char *p, int length) {
+    unsigned value = 0;
+
+    while (length-- > 0)
+        value = value * 10 + (unsigned) (*p++ - '0');
+    return (int) value;
+}
+
+#ifdef SCAN_X86
+/**
+ * Records the newlines marked in mask, a bit per byte starting at p.
+ */
+static inline void note_newlines(char *p, uint32_t mask, int *newlines, char **line_start) {
+    if (mask != 0) {
+        *newlines += __builtin_popcount(mask);
+        *line_start = p + 32 - __builtin_clz(mask); // just past the last one
+    }
+}
+
+/**
+ * SSE2 skip_space, 16 bytes a step.
+ */
+__attribute__((target("sse2")))
+static char *skip_space_sse2(char *p, char *end, int *newlines, char **line_start) {
+    const __m128i blank = _mm_set1_epi8(' '), tab = _mm_set1_epi8('\t');
+    const __m128i newline = _mm_set1_epi8('\n');
+
+    while (end - p >= 16) {
+        __m128i v = _mm_loadu_si128((const __m128i *) p);
+        __m128i is_nl = _mm_cmpeq_epi8(v, newline);
+        __m128i is_ws = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, blank),
+                                                  _mm_cmpeq_epi8(v, tab)), is_nl);
+        uint32_t other = ~(uint32_t) _mm_movemask_epi8(is_ws) & 0xFFFF;
+        uint32_t nl = (uint32_t) _mm_movemask_epi8(is_nl);
+
+        if (other != 0) {
+            int stop = __builtin_ctz(other);
+            note_newlines(p, nl & ((1u << stop) - 1), newlines, line_start);
+            return p + stop;
+        }
+        note_newlines(p, nl, newlines, line_start);
+        p += 16;
+    }
+    return skip_space_scalar(p, end, newlines, line_start);
+}
+
+/**
+ * SSE2 skip_digits, 16 bytes a step.
+ */
+__attribute__((target("sse2")))
+static char *skip_digits_sse2(char *p, char *end) {
+    const __m128i zero = _mm_set1_epi8('0'), below = _mm_set1_epi8(-1);
+    const __m128i ten = _mm_set1_epi8(10);
+
+    while (end - p >= 16) {
+        __m128i d = _mm_sub_epi8(_mm_loadu_si128((const __m128i *) p), zero);
+        __m128i digit = _mm_and_si128(_mm_cmpgt_epi8(d, below), _mm_cmplt_epi8(d, ten));
+        uint32_t other = ~(uint32_t) _mm_movemask_epi8(digit) & 0xFFFF;
+
+        if (other != 0)
+            return p + __builtin_ctz(other);
+        p += 16;
+    }
+    return skip_digits_scalar(p, end);
+}
+
+/**
+ * Combines the digits of v pairwise, as combine_digits_avx2() does, but
+ * with SSE2 alone: the bytes are widened to 16 bits and paired up with
+ * pmaddwd, since pmaddubsw needs SSSE3. Lane 0 ends up with the value of
+ * bytes 0-7 and lane 1 with the value of bytes 8-15.
+ */
+__attribute__((target("sse2")))
+static inline __m128i combine_digits_sse2(__m128i v) {
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i ten_one = _mm_setr_epi16(10, 1, 10, 1, 10, 1, 10, 1);
+    __m128i low, high;
+
+    v = _mm_sub_epi8(v, _mm_set1_epi8('0'));
+    low = _mm_madd_epi16(_mm_unpacklo_epi8(v, zero), ten_one);
+    high = _mm_madd_epi16(_mm_unpackhi_epi8(v, zero), ten_one);
+    v = _mm_madd_epi16(_mm_packs_epi32(low, high),
+                       _mm_setr_epi16(100, 1, 100, 1, 100, 1, 100, 1));
+    v = _mm_packs_epi32(v, v);
+    return _mm_madd_epi16(v, _mm_setr_epi16(10000, 1, 10000, 1, 10000, 1, 10000, 1));
+}
+
+/**
+ * SSE2 parse_digits. Leading digits that do not fill a group of 8 are
+ * taken one at a time; the rest are converted 16 or 8 at a time straight
+ * from the input, without copying.
+ */
+__attribute__((target("sse2")))
+static int parse_digits_sse2(const char *p, int length) {
+    uint64_t value;
+    int head = length % 8;
+    __m128i v;
+
+    if (length < 8)
+        return parse_digits_scalar(p, length);
+    value = (unsigned) parse_digits_scalar(p, head);
+    p += head;
+    length -= head;
+
+    for (; length >= 16; length -= 16, p += 16) {
+        v = combine_digits_sse2(_mm_loadu_si128((const __m128i *) p));
+        value = value * 10000000000000000ULL
+                + (uint64_t) (uint32_t) _mm_cvtsi128_si32(v) * 100000000ULL
+                + (uint32_t) _mm_cvtsi128_si32(_mm_srli_si128(v, 4));
+    }
+    if (length == 8) {
+        v = combine_digits_sse2(_mm_loadl_epi64((const __m128i *) p));
+        value = value * 100000000ULL + (uint32_t) _mm_cvtsi128_si32(v);
+    }
+    return (int) (unsigned) value;
+}
+
+/**
+ * AVX2 skip_space, 32 bytes a step.
+ */
+__attribute__((target("avx2")))
+static char *skip_space_avx2(char *p, char *end, int *newlines, char **line_start) {
+    const __m256i blank = _mm256_set1_epi8(' '), tab = _mm256_set1_epi8('\t');
+    const __m256i newline = _mm256_set1_epi8('\n');
+
+    while (end - p >= 32) {
+        __m256i v = _mm256_loadu_si256((const __m256i *) p);
+        __m256i is_nl = _mm256_cmpeq_epi8(v, newline);
+        __m256i is_ws = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(v, blank),
+                                                        _mm256_cmpeq_epi8(v, tab)), is_nl);
+        uint32_t other = ~(uint32_t) _mm256_movemask_epi8(is_ws);
+        uint32_t nl = (uint32_t) _mm256_movemask_epi8(is_nl);
+
+        if (other != 0) {
+            int stop = __builtin_ctz(other);
+            note_newlines(p, stop == 0 ? 0 : nl & (0xFFFFFFFFu >> (32 - stop)),
+                          newlines, line_start);
+            return p + stop;
+        }
+        note_newlines(p, nl, newlines, line_start);
+        p += 32;
+    }
+    return skip_space_sse2(p, end, newlines, line_start);
+}
+
+/**
+ * AVX2 skip_digits, 32 bytes a step.
+ */
+__attribute__((target("avx2")))
+static char *skip_digits_avx2(char *p, char *end) {
+    const __m256i zero = _mm256_set1_epi8('0'), below = _mm256_set1_epi8(-1);
+    const __m256i ten = _mm256_set1_epi8(10);
+
+    while (end - p >= 32) {
+        __m256i d = _mm256_sub_epi8(_mm256_loadu_si256((const __m256i *) p), zero);
+        __m256i digit = _mm256_and_si256(_mm256_cmpgt_epi8(d, below), _mm256_cmpgt_epi8(ten, d));
+        uint32_t other = ~(uint32_t) _mm256_movemask_epi8(digit);
+
+        if (other != 0)
+            return p + __builtin_ctz(other);
+        p += 32;
+    }
+    return skip_digits_sse2(p, end);
+}
+
+/**
+ * Combines the digits of v pairwise: bytes to 2-digit, 4-digit and then
+ * 8-digit values. Lane 0 ends up with the value of bytes 0-7 and lane 1
+ * with the value of bytes 8-15.
+ */
+__attribute__((target("avx2")))
+static inline __m128i combine_digits_avx2(__m128i v) {
+    v = _mm_sub_epi8(v, _mm_set1_epi8('0'));
+    v = _mm_maddubs_epi16(v, _mm_setr_epi8(10, 1, 10, 1, 10, 1, 10, 1,
+                                           10, 1, 10, 1, 10, 1, 10, 1));
+    v = _mm_madd_epi16(v, _mm_setr_epi16(100, 1, 100, 1, 100, 1, 100, 1));
+    v = _mm_packus_epi32(v, v);
+    return _mm_madd_epi16(v, _mm_setr_epi16(10000, 1, 10000, 1, 10000, 1, 10000, 1));
+}
+
+/**
+ * parse_digits for CPUs with AVX2, which also have the SSSE3 and SSE4.1
+ * multiply-add and pack instructions that save parse_digits_sse2() its
+ * widening step.
+ */
+__attribute__((target("avx2")))
+static int parse_digits_avx2(const char *p, int length) {
+    uint64_t value;
+    int head = length % 8;
+    __m128i v;
+
+    if (length < 8)
+        return parse_digits_scalar(p, length);
+    value = (unsigned) parse_digits_scalar(p, head);
+    p += head;
+    length -= head;
+
+    for (; length >= 16; length -= 16, p += 16) {
+        v = combine_digits_avx2(_mm_loadu_si128((const __m128i *) p));
+        value = value * 10000000000000000ULL
+                + (uint64_t) (uint32_t) _mm_cvtsi128_si32(v) * 100000000ULL
+                + (uint32_t) _mm_extract_epi32(v, 1);
+    }
+    if (length == 8) {
+        v = combine_digits_avx2(_mm_loadl_epi64((const __m128i *) p));
+        value = value * 100000000ULL + (uint32_t) _mm_cvtsi128_si32(v);
+    }
+    return (int) (unsigned) value;
+}
+#endif /* SCAN_X86 */
+
+char *(*skip_space)(char *, char *, int *, char **) = skip_space_scalar;
+char *(*skip_digits)(char *, char *) = skip_digits_scalar;
+int (*parse_digits)(const char *, int) = parse_digits_scalar;
+
+/**
+ * Switches the kernels to the given level, or the best level below it
+ * that this CPU supports.
+ * @param level: the highest level wanted
+ * @return: the level now in use
+ */
+enum scan_level scan_select(enum scan_level level) {
+    skip_space = skip_space_scalar;
+    skip_digits = skip_digits_scalar;
+    parse_digits = parse_digits_scalar;
+#ifdef SCAN_X86
+    __builtin_cpu_init();
+    if (level >= SCAN_AVX2 && __builtin_cpu_supports("avx2")) {
+        skip_space = skip_space_avx2;
+        skip_digits = skip_digits_avx2;
+        parse_digits = parse_digits_avx2;
+        return SCAN_AVX2;
+    }
+    if (level >= SCAN_SSE2 && __builtin_cpu_supports("sse2")) {
+        skip_space = skip_space_sse2;
+        skip_digits = skip_digits_sse2;
+        parse_digits = parse_digits_sse2;
+        return SCAN_SSE2;
+    }
+#else
+    (void) level;
+#endif
+    return SCAN_SCALAR;
+}
+
+#ifdef SCAN_X86
+/**
+ * Picks the best kernels before main() runs.
+ */
+__attribute__((constructor))
+static void scan_init(void) {
+    scan_select(SCAN_AVX2);
+}
+#endif
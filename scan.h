@@ -0,0 +1,33 @@
+#ifndef SCAN_H
+#define SCAN_H
+/*
+ * Purpose: Byte-scanning kernels for the lexer, with SSE2 and AVX2
+ *          versions chosen at run time.
+ * Date:    2025 April 30
+ */
+
+/* Instruction sets the kernels can use, from slowest to fastest */
+enum scan_level {
+    SCAN_SCALAR,
+    SCAN_SSE2,
+    SCAN_AVX2
+};
+
+/*
+ * The kernels. They start out as the best versions this CPU supports.
+ * None of them reads at or past end.
+ *
+ * skip_space   - first byte at or after p that is not ' ', '\t' or '\n';
+ *                adds the newlines it passes to *newlines and points
+ *                *line_start just past the last one
+ * skip_digits  - first byte at or after p that is not 0-9
+ * parse_digits - value of length decimal digits, wrapping like unsigned
+ *                int arithmetic
+ */
+extern char *(*skip_space)(char *p, char *end, int *newlines, char **line_start);
+extern char *(*skip_digits)(char *p, char *end);
+extern int (*parse_digits)(const char *p, int length);
+
+enum scan_level scan_select(enum scan_level level);
+
+#endif
@@ -0,0 +1,517 @@
+/*
+ * server.c - the evaluator daemon described in server.h. One thread runs
+ * an epoll loop over the listening socket and every client, all of them
+ * non-blocking. Each wakeup reads what every ready client sent, then
+ * evaluates the complete statements of all of them as one batch: with
+ * bexpr() on this thread, or with batch_eval() on a pool of threads when
+ * the batch is large. Replies are queued per client and written as the
+ * socket takes them; a client whose replies back up past SERVER_BUFFER
+ * is not read from until it catches up.
+ * Date:   2025 May 12
+ */
+
+#define _GNU_SOURCE   // for accept4()
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include "parser.h"
+#include "parallel.h"
+#include "server.h"
+
+#define SERVER_EVENTS 256          // events taken from each epoll_wait()
+#define SERVER_READ (64 * 1024)    // bytes read from a client per wakeup
+
+// The word after "error" in a reply, by parse_status
+static const char *status_words[] = {
+   "ok", "syntax", "overflow", "divide-by-zero", "out-of-memory"
+};
+
+struct client {
+   int fd;
+   char *in;               // received text not yet evaluated
+   size_t in_used;
+   size_t in_capacity;     // one byte more is allocated, for a NUL
+   char *out;              // replies not yet sent
+   size_t out_used;
+   size_t out_sent;
+   size_t out_capacity;
+   uint32_t events;        // what epoll is watching for
+   bool eof;               // the client shut down its side
+   bool dead;              // the connection failed; close it
+   bool touched;           // on this wakeup's list
+   struct client *next;    // next on this wakeup's list
+   struct client *older;   // neighbours on the list of every client
+   struct client *newer;
+};
+
+/**
+ * Queues a reply line. If there is no memory for it the connection is
+ * dropped, since its replies would no longer line up.
+ */
+static void queue(struct client *c, const char *line, size_t length) {
+   if (c->out_used + length > c->out_capacity) {
+      size_t capacity = c->out_capacity ? c->out_capacity * 2 : 4096;
+      char *grown = realloc(c->out, capacity);
+      if (grown == NULL) {
+         c->dead = true;
+         return;
+      }
+      c->out = grown;
+      c->out_capacity = capacity;
+   }
+   memcpy(c->out + c->out_used, line, length);
+   c->out_used += length;
+}
+
+// Queues the reply to one statement
+static void reply(struct client *c, struct eval_result result) {
+   char line[32];
+   int length = result.status == PARSE_OK ? sprintf(line, "ok %d\n", result.value)
+                                          : sprintf(line, "error %s\n", status_words[result.status]);
+
+   queue(c, line, length);
+}
+
+/**
+ * Evaluates a NUL-terminated run of statements with bexpr(), queuing a
+ * reply to each.
+ */
+static uint64_t eval_text(struct client *c, char *text, struct error_log *log) {
+   struct parser_state ps;
+   uint64_t statements = 0;
+
+   parser_init(&ps, text);
+   ps.errors = log;
+   while (ps.lex.kind != END_OF_INPUT) {
+      reply(c, bexpr(&ps));
+      log->count = 0; // Only the status goes in the reply
+      statements++;
+   }
+   return statements;
+}
+
+/**
+ * The bytes of a client's input that are complete statements: up to
+ * its last ';', or everything once the client has shut down.
+ */
+static size_t complete(const struct client *c) {
+   size_t n = c->in_used;
+
+   if (c->eof)
+      return n;
+   while (n > 0 && c->in[n - 1] != ';')
+      n--;
+   return n;
+}
+
+// Drops the evaluated bytes from the front of a client's input
+static void consume(struct client *c, size_t n) {
+   memmove(c->in, c->in + n, c->in_used - n);
+   c->in_used -= n;
+}
+
+/**
+ * Evaluates the complete statements of every client on the list as one
+ * batch. A small batch is evaluated client by client in place. A large
+ * one is copied into a statement_batch and spread over the threads; a
+ * last statement with no ';' is left to bexpr() afterwards so it cannot
+ * run into the next client's text.
+ * @return: the number of statements evaluated
+ */
+static uint64_t eval_batch(struct client *list, int threads, struct error_log *log,
+                           struct server_stats *stats) {
+   struct statement_batch batch;
+   struct client *c;
+   size_t bytes = 0, n, terminated;
+   uint64_t statements = 0;
+   char *text = NULL, saved;
+   int i = 0;
+
+   for (c = list; c != NULL; c = c->next)
+      bytes += c->dead ? 0 : complete(c);
+   if (bytes == 0)
+      return 0;
+
+   if (threads > 1 && bytes >= SERVER_PARALLEL && (text = malloc(bytes)) != NULL) {
+      bytes = 0;
+      for (c = list; c != NULL; c = c->next) {
+         if (c->dead)
+            continue;
+         for (terminated = complete(c); terminated > 0 && c->in[terminated - 1] != ';'; )
+            terminated--;
+         memcpy(text + bytes, c->in, terminated);
+         bytes += terminated;
+      }
+      if (batch_split(&batch, text, bytes) >= 0) {
+         batch_eval(&batch, threads);
+         for (c = list; c != NULL; c = c->next) {
+            if (c->dead)
+               continue;
+            for (terminated = complete(c); terminated > 0 && c->in[terminated - 1] != ';'; )
+               terminated--;
+            for (n = 0; n < terminated; n++) {
+               if (c->in[n] == ';')
+                  reply(c, batch.results[i++]);
+            }
+            consume(c, terminated);
+         }
+         statements = (uint64_t) batch.count;
+         stats->parallel++;
+         batch_free(&batch);
+      }
+      free(text);
+   }
+
+   // Whatever is left: the whole batch if it was small, or last statements
+   for (c = list; c != NULL; c = c->next) {
+      if (c->dead || (n = complete(c)) == 0)
+         continue;
+      saved = c->in[n];
+      c->in[n] = '\0';
+      statements += eval_text(c, c->in, log);
+      c->in[n] = saved;
+      consume(c, n);
+   }
+   return statements;
+}
+
+/**
+ * Reads what a client has sent, up to SERVER_READ bytes so one busy
+ * client cannot starve the others. A statement longer than
+ * SERVER_BUFFER gets a too-long reply and ends the connection. A NUL
+ * byte, which would end the text bexpr() sees, is read as '?', which is
+ * not a lexeme, so its statement gets a syntax error.
+ */
+static void read_client(struct client *c) {
+   size_t total = 0;
+   ssize_t got;
+
+   while (total < SERVER_READ && !c->eof) {
+      if (c->in_capacity - c->in_used < 4096) {
+         size_t capacity = c->in_capacity ? c->in_capacity * 2 : 16384;
+         char *grown;
+
+         if (c->in_used >= SERVER_BUFFER) {
+            if (complete(c) > 0)
+               return; // Evaluate those before deciding
+            queue(c, "error too-long\n", 15);
+            c->in_used = 0;
+            c->eof = true;
+            return;
+         }
+         if ((grown = realloc(c->in, capacity + 1)) == NULL) {
+            c->dead = true;
+            return;
+         }
+         c->in = grown;
+         c->in_capacity = capacity;
+      }
+      got = read(c->fd, c->in + c->in_used, c->in_capacity - c->in_used);
+      if (got > 0) {
+         char *nul = c->in + c->in_used;
+         while ((nul = memchr(nul, '\0', c->in + c->in_used + got - nul)) != NULL)
+            *nul = '?';
+         c->in_used += got;
+         total += got;
+      } else if (got == 0) {
+         c->eof = true;
+      } else if (errno == EINTR) {
+         continue;
+      } else {
+         if (errno != EAGAIN && errno != EWOULDBLOCK)
+            c->dead = true;
+         return;
+      }
+   }
+}
+
+// Sends as many queued replies as the socket takes
+static void flush_client(struct client *c) {
+   while (c->out_sent < c->out_used) {
+      ssize_t sent = send(c->fd, c->out + c->out_sent, c->out_used - c->out_sent, MSG_NOSIGNAL);
+      if (sent > 0) {
+         c->out_sent += sent;
+      } else if (sent < 0 && errno == EINTR) {
+         continue;
+      } else {
+         if (sent == 0 || (errno != EAGAIN && errno != EWOULDBLOCK))
+            c->dead = true;
+         return;
+      }
+   }
+   c->out_used = c->out_sent = 0;
+}
+
+// Closes a client and frees it, taking it off the list of every client
+static void drop(struct client **clients, struct client *c) {
+   if (c->newer != NULL)
+      c->newer->older = c->older;
+   else
+      *clients = c->older;
+   if (c->older != NULL)
+      c->older->newer = c->newer;
+   close(c->fd); // Also takes it out of the epoll set
+   free(c->in);
+   free(c->out);
+   free(c);
+}
+
+/**
+ * After a wakeup: closes a client that failed or is finished, or
+ * watches it for whatever it now needs.
+ */
+static void settle(int ep, struct client **clients, struct client *c) {
+   struct epoll_event ev;
+   size_t pending;
+
+   if (!c->dead)
+      flush_client(c);
+   pending = c->out_used - c->out_sent;
+   if (c->dead || (c->eof && pending == 0 && c->in_used == 0)) {
+      drop(clients, c);
+      return;
+   }
+   ev.events = (c->eof || pending > SERVER_BUFFER ? 0 : EPOLLIN | EPOLLRDHUP)
+               | (pending > 0 ? EPOLLOUT : 0);
+   ev.data.ptr = c;
+   if (ev.events != c->events) {
+      epoll_ctl(ep, EPOLL_CTL_MOD, c->fd, &ev);
+      c->events = ev.events;
+   }
+}
+
+// Takes every waiting connection
+static void accept_clients(int ep, int listen_fd, struct client **clients,
+                           struct server_stats *stats) {
+   struct epoll_event ev;
+   struct client *c;
+   int fd;
+
+   while ((fd = accept4(listen_fd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC)) >= 0) {
+      if ((c = calloc(1, sizeof(struct client))) == NULL) {
+         close(fd);
+         continue;
+      }
+      c->fd = fd;
+      c->events = ev.events = EPOLLIN | EPOLLRDHUP;
+      ev.data.ptr = c;
+      if (epoll_ctl(ep, EPOLL_CTL_ADD, fd, &ev) != 0) {
+         close(fd);
+         free(c);
+         continue;
+      }
+      if ((c->older = *clients) != NULL)
+         c->older->newer = c;
+      *clients = c;
+      stats->connections++;
+   }
+}
+
+/**
+ * Creates a non-blocking socket listening at path, replacing any socket
+ * file a previous daemon left there.
+ * @param path: where the socket goes
+ * @return: the socket, or -1 with a message on stderr
+ */
+int server_listen(const char *path) {
+   struct sockaddr_un addr;
+   int fd;
+
+   memset(&addr, 0, sizeof(addr));
+   addr.sun_family = AF_UNIX;
+   if (strlen(path) >= sizeof(addr.sun_path)) {
+      fprintf(stderr, "ERROR: socket path too long: %s\n", path);
+      return -1;
+   }
+   strcpy(addr.sun_path, path);
+   if ((fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0)) < 0) {
+      fprintf(stderr, "ERROR: could not create a socket: %s\n", strerror(errno));
+      return -1;
+   }
+   unlink(path);
+   if (bind(fd, (struct sockaddr *) &addr, sizeof(addr)) != 0 || listen(fd, SOMAXCONN) != 0) {
+      fprintf(stderr, "ERROR: could not listen at %s: %s\n", path, strerror(errno));
+      close(fd);
+      return -1;
+   }
+   return fd;
+}
+
+/**
+ * Serves clients until *stop is set, normally by a signal handler
+ * installed without SA_RESTART. Clients still connected then are closed.
+ * @param listen_fd: a socket from server_listen()
+ * @param threads: threads for large batches; 1 evaluates everything here
+ * @param stop: set to non-zero to return
+ * @param stats: counts of what was served; may be NULL
+ * @return: 0, or -1 if epoll failed
+ */
+int server_run(int listen_fd, int threads, volatile sig_atomic_t *stop,
+               struct server_stats *stats) {
+   struct epoll_event events[SERVER_EVENTS], ev;
+   struct server_stats local;
+   struct error_log log;
+   struct client *clients = NULL, *list, *c, *next;
+   uint64_t statements;
+   int ep, n, i, status = 0;
+
+   if (stats == NULL)
+      stats = &local;
+   memset(stats, 0, sizeof(*stats));
+   if ((ep = epoll_create1(EPOLL_CLOEXEC)) < 0) {
+      fprintf(stderr, "ERROR: epoll_create1: %s\n", strerror(errno));
+      return -1;
+   }
+   ev.events = EPOLLIN;
+   ev.data.ptr = NULL;
+   epoll_ctl(ep, EPOLL_CTL_ADD, listen_fd, &ev);
+   error_log_init(&log);
+
+   while (!*stop) {
+      if ((n = epoll_wait(ep, events, SERVER_EVENTS, -1)) < 0) {
+         if (errno == EINTR)
+            continue;
+         fprintf(stderr, "ERROR: epoll_wait: %s\n", strerror(errno));
+         status = -1;
+         break;
+      }
+
+      // Read from every ready client before evaluating any of it
+      list = NULL;
+      for (i = 0; i < n; i++) {
+         if ((c = events[i].data.ptr) == NULL) {
+            accept_clients(ep, listen_fd, &clients, stats);
+            continue;
+         }
+         if (events[i].events & EPOLLERR)
+            c->dead = true;
+         else if (events[i].events & (EPOLLIN | EPOLLRDHUP | EPOLLHUP))
+            read_client(c);
+         if (!c->touched) {
+            c->touched = true;
+            c->next = list;
+            list = c;
+         }
+      }
+
+      if ((statements = eval_batch(list, threads, &log, stats)) > 0) {
+         stats->batches++;
+         stats->statements += statements;
+      }
+      for (c = list; c != NULL; c = next) {
+         next = c->next;
+         c->touched = false;
+         settle(ep, &clients, c);
+      }
+   }
+
+   while (clients != NULL)
+      drop(&clients, clients); // Whoever is still connected
+
+   error_log_free(&log);
+   close(ep);
+   return status;
+}
+
+/**
+ * Serves one request without a daemon: reads statements from in_fd to
+ * its end and writes their replies to out_fd. This is what a process
+ * started per request does, for comparison.
+ * @return: 0, or -1 if reading or writing failed
+ */
+int server_oneshot(int in_fd, int out_fd) {
+   struct client c;
+   struct error_log log;
+   ssize_t got;
+   int status = 0;
+
+   memset(&c, 0, sizeof(c));
+   error_log_init(&log);
+   for (;;) {
+      if (c.in_used == c.in_capacity) {
+         size_t capacity = c.in_capacity ? c.in_capacity * 2 : 65536;
+         char *grown = realloc(c.in, capacity + 1);
+         if (grown == NULL) {
+            status = -1;
+            break;
+         }
+         c.in = grown;
+         c.in_capacity = capacity;
+      }
+      got = read(in_fd, c.in + c.in_used, c.in_capacity - c.in_used);
+      if (got > 0) {
+         c.in_used += got;
+      } else if (got < 0 && errno == EINTR) {
+         continue;
+      } else {
+         status = got < 0 ? -1 : 0;
+         break;
+      }
+   }
+   if (status == 0) {
+      c.in[c.in_used] = '\0';
+      eval_text(&c, c.in, &log);
+      while (c.out_sent < c.out_used) {
+         got = write(out_fd, c.out + c.out_sent, c.out_used - c.out_sent);
+         if (got < 0 && errno == EINTR)
+            continue;
+         if (got <= 0) {
+            status = -1;
+            break;
+         }
+         c.out_sent += got;
+      }
+   }
+   error_log_free(&log);
+   free(c.in);
+   free(c.out);
+   return status;
+}
+
+#ifndef SERVER_NO_MAIN
+static volatile sig_atomic_t stopping;
+
+static void on_stop(int sig) {
+   (void) sig;
+   stopping = 1;
+}
+
+/**
+ * main - Runs the daemon until SIGINT or SIGTERM, or serves stdin once.
+ */
+int main(int argc, char *argv[]) {
+   struct server_stats stats;
+   struct sigaction sa;
+   int fd, status, threads = argc > 2 ? atoi(argv[2]) : (int) sysconf(_SC_NPROCESSORS_ONLN);
+
+   if (argc < 2 || argc > 3) {
+      fprintf(stderr, "Usage: server socketPath [threads]\n"
+                      "       server - evaluates stdin once and writes the replies to stdout\n");
+      return 1;
+   }
+   if (strcmp(argv[1], "-") == 0)
+      return server_oneshot(STDIN_FILENO, STDOUT_FILENO) == 0 ? 0 : 1;
+   if ((fd = server_listen(argv[1])) < 0)
+      return 1;
+
+   memset(&sa, 0, sizeof(sa));
+   sa.sa_handler = on_stop; // No SA_RESTART, so epoll_wait() returns
+   sigemptyset(&sa.sa_mask);
+   sigaction(SIGINT, &sa, NULL);
+   sigaction(SIGTERM, &sa, NULL);
+
+   status = server_run(fd, threads, &stopping, &stats);
+   close(fd);
+   unlink(argv[1]);
+   fprintf(stderr, "%llu connections, %llu statements in %llu batches (%llu on threads)\n",
+           (unsigned long long) stats.connections, (unsigned long long) stats.statements,
+           (unsigned long long) stats.batches, (unsigned long long) stats.parallel);
+   return status == 0 ? 0 : 1;
+}
+#endif /* SERVER_NO_MAIN */
@@ -0,0 +1,41 @@
+#ifndef SERVER_H
+#define SERVER_H
+/*
+ * Purpose: A resident evaluator. The daemon takes statements over a Unix
+ *          domain socket, so callers pay for process startup and opening
+ *          files once instead of on every request.
+ *
+ *          The protocol is the language itself. A client writes
+ *          statements, each ended by ';', in pieces of any size, and
+ *          reads one line per statement, in order:
+ *
+ *             ok <value>
+ *             error <syntax | overflow | divide-by-zero | out-of-memory | too-long>
+ *
+ *          A client may write any number of statements before it reads
+ *          their replies. When it shuts down its side of the connection,
+ *          any text after its last ';' is evaluated as a last statement,
+ *          as bexpr() would, and the connection closes once every reply
+ *          is sent. Statements that arrive from different clients in the
+ *          same wakeup are evaluated as one batch.
+ * Date:    2025 May 12
+ */
+#include <stdint.h>
+#include <signal.h>
+
+#define SERVER_BUFFER (1024 * 1024)    // longest statement; most unsent replies per client
+#define SERVER_PARALLEL (256 * 1024)   // batch bytes before it is split over threads
+
+// Counts kept by server_run()
+struct server_stats {
+   uint64_t connections;
+   uint64_t batches;       // wakeups that evaluated anything
+   uint64_t statements;
+   uint64_t parallel;      // batches split over threads
+};
+
+int server_listen(const char *);
+int server_run(int, int, volatile sig_atomic_t *, struct server_stats *);
+int server_oneshot(int, int);
+
+#endif
@@ -0,0 +1,179 @@
+/*
+ * stats.c - keeps the list of per-thread counters from stats.h and
+ * prints their sum. Lexing and evaluation are timed one call in
+ * STATS_SAMPLE, so the time of a phase is estimated as the average of
+ * the timed calls, less the cost of reading the clock, times the number
+ * of calls. Counts are read without stopping other threads, so a dump
+ * taken while they run is approximate.
+ * Date:   2025 May 10
+ */
+
+#ifdef PARSER_STATS
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <pthread.h>
+#include "stats.h"
+
+__thread struct stats stats_local;
+volatile sig_atomic_t stats_requested;
+
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_once_t once = PTHREAD_ONCE_INIT;
+static pthread_key_t exiting;     // calls retire() as each thread exits
+static struct stats *threads;     // counters of live threads
+static struct stats retired;      // counters of threads that have exited
+static uint64_t overhead;         // ticks of reading the clock twice
+
+static const char *phase_names[PHASE_COUNT] = { "io", "lex", "eval" };
+
+// Adds one thread's counters to a total
+static void add(struct stats *total, const struct stats *s) {
+   int i;
+
+   for (i = 0; i < PHASE_COUNT; i++) {
+      total->events[i] += s->events[i] + s->period[i] - s->countdown[i];
+      total->timed[i] += s->timed[i];
+      total->ticks[i] += s->ticks[i];
+   }
+   for (i = 0; i < TOKEN_KIND_COUNT; i++)
+      total->tokens[i] += s->tokens[i];
+   for (i = 0; i < STATS_DEPTHS; i++)
+      total->depths[i] += s->depths[i];
+   total->bytes_copied += s->bytes_copied;
+   total->bytes_read += s->bytes_read;
+   total->bytes_written += s->bytes_written;
+}
+
+// Moves the counters of an exiting thread to the shared total
+static void retire(void *self) {
+   struct stats *s = self, **p;
+
+   pthread_mutex_lock(&lock);
+   add(&retired, s);
+   for (p = &threads; *p != NULL; p = &(*p)->next) {
+      if (*p == s) {
+         *p = s->next;
+         break;
+      }
+   }
+   pthread_mutex_unlock(&lock);
+}
+
+static void on_signal(int sig) {
+   (void) sig;
+   stats_requested = 1;
+}
+
+static void dump_at_exit(void) {
+   stats_dump();
+}
+
+// Set up once per process, by the first thread to count anything
+static void init(void) {
+   struct sigaction sa;
+
+   pthread_key_create(&exiting, retire);
+   memset(&sa, 0, sizeof(sa));
+   sa.sa_handler = on_signal;
+   sa.sa_flags = SA_RESTART;
+   sigemptyset(&sa.sa_mask);
+   sigaction(SIGUSR1, &sa, NULL);
+   atexit(dump_at_exit);
+
+   overhead = UINT64_MAX;
+   for (int i = 0; i < 1000; i++) {
+      uint64_t start = stats_clock(), ticks = stats_clock() - start;
+      if (ticks < overhead)
+         overhead = ticks;
+   }
+}
+
+/**
+ * Starts a sampled call of a phase: brings the call count up to date,
+ * links the thread's counters for the dump on its first call, and sets
+ * the countdown to the next sample.
+ * @return: the time the call starts
+ */
+uint64_t stats_sample(enum stats_phase phase) {
+   struct stats *s = &stats_local;
+
+   if (!s->linked) {
+      pthread_once(&once, init);
+      pthread_mutex_lock(&lock);
+      s->next = threads;
+      threads = s;
+      s->linked = true;
+      pthread_mutex_unlock(&lock);
+      pthread_setspecific(exiting, s);
+   }
+   s->events[phase] += s->period[phase] - s->countdown[phase];
+   // I/O calls are few and long, so every one is timed
+   s->period[phase] = s->countdown[phase] = phase == PHASE_IO ? 1 : STATS_SAMPLE;
+   return stats_clock();
+}
+
+/**
+ * Ends a sampled call, and prints the dump if SIGUSR1 asked for one.
+ * @param phase: the phase of the call
+ * @param start: what stats_sample() returned
+ */
+void stats_sampled(enum stats_phase phase, uint64_t start) {
+   uint64_t ticks = stats_clock() - start;
+
+   stats_local.ticks[phase] += ticks > overhead ? ticks - overhead : 0;
+   stats_local.timed[phase]++;
+   if (stats_requested)
+      stats_dump();
+}
+
+/**
+ * Prints the counters of every thread, live or exited, to stderr.
+ */
+void stats_dump(void) {
+   struct stats total;
+   const struct stats *s;
+   uint64_t statements = 0;
+   int i, last = 0;
+
+   stats_requested = 0;
+   pthread_mutex_lock(&lock);
+   total = retired;
+   for (s = threads; s != NULL; s = s->next)
+      add(&total, s);
+   pthread_mutex_unlock(&lock);
+
+   fprintf(stderr, "--- stats, pid %d ---\n", (int) getpid());
+   fprintf(stderr, "%-5s %14s %10s %16s %12s\n", "phase", "calls", "timed",
+           "est. M" STATS_TICKS, STATS_TICKS "/call");
+   for (i = 0; i < PHASE_COUNT; i++) {
+      double per_call = total.timed[i] ? (double) total.ticks[i] / total.timed[i] : 0;
+      fprintf(stderr, "%-5s %14llu %10llu %16.1f %12.1f\n", phase_names[i],
+              (unsigned long long) total.events[i], (unsigned long long) total.timed[i],
+              per_call * total.events[i] / 1e6, per_call);
+   }
+
+   fprintf(stderr, "tokens:");
+   for (i = 0; i < TOKEN_KIND_COUNT; i++) {
+      if (total.tokens[i] != 0)
+         fprintf(stderr, " %s=%llu", category_name(i), (unsigned long long) total.tokens[i]);
+   }
+
+   for (i = 0; i < STATS_DEPTHS; i++) {
+      statements += total.depths[i];
+      if (total.depths[i] != 0)
+         last = i;
+   }
+   fprintf(stderr, "\nrecursion depth of %llu statements:", (unsigned long long) statements);
+   for (i = 0; i <= last && statements > 0; i++) {
+      fprintf(stderr, " %d%s=%llu", i, i == STATS_DEPTHS - 1 ? "+" : "",
+              (unsigned long long) total.depths[i]);
+   }
+   fprintf(stderr, "\nbytes: copied=%llu read=%llu written=%llu\n",
+           (unsigned long long) total.bytes_copied, (unsigned long long) total.bytes_read,
+           (unsigned long long) total.bytes_written);
+}
+
+#endif /* PARSER_STATS */
@@ -0,0 +1,130 @@
+#ifndef STATS_H
+#define STATS_H
+/*
+ * Purpose: Optional counters for where time and work go: cycles in I/O,
+ *          lexing and evaluation, tokens by kind, how deep statements
+ *          recurse and how many bytes are copied. Build with
+ *          -DPARSER_STATS (make CPPFLAGS=-DPARSER_STATS) to compile them
+ *          in; without it every hook below is an empty statement and
+ *          stats.c is empty. A build with them prints a summary to
+ *          stderr at exit, and on SIGUSR1 at the next sampled call.
+ * Date:    2025 May 10
+ */
+#include "tokenizer.h"
+
+enum stats_phase {
+   PHASE_IO,      // read() and write() of the input and the report
+   PHASE_LEX,     // scan_token()
+   PHASE_EVAL,    // bexpr(), including the lexing it asks for
+   PHASE_COUNT
+};
+
+#ifdef PARSER_STATS
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <signal.h>
+
+#define STATS_DEPTHS 64   // depth histogram buckets; the last takes the rest
+#define STATS_SAMPLE 64   // lexing and evaluation time one call in this many
+
+/*
+ * Counters of one thread. Threads count into their own copy with no
+ * locking; the copies are linked so the dump can add them up, and a
+ * thread's counts move to a shared total when it exits. A call of a
+ * phase only counts down to its next sample; the sample, a call to
+ * stats_sample(), does the rest, which keeps the cost of a call that is
+ * not timed to one decrement.
+ */
+struct stats {
+   int countdown[PHASE_COUNT];     // calls left until the next sample
+   int period[PHASE_COUNT];        // what countdown was last set to
+   uint64_t events[PHASE_COUNT];   // calls up to the last sample
+   uint64_t timed[PHASE_COUNT];    // calls that were timed
+   uint64_t ticks[PHASE_COUNT];    // ticks spent in the timed calls
+   uint64_t tokens[TOKEN_KIND_COUNT];
+   uint64_t depths[STATS_DEPTHS];  // statements by deepest recursion
+   uint64_t bytes_copied;          // lexemes copied, buffered output
+   uint64_t bytes_read;
+   uint64_t bytes_written;
+   int depth;                      // current recursion depth
+   int max_depth;                  // deepest in the current statement
+   bool linked;
+   struct stats *next;
+};
+
+extern __thread struct stats stats_local;
+extern volatile sig_atomic_t stats_requested;
+
+uint64_t stats_sample(enum stats_phase);
+void stats_sampled(enum stats_phase, uint64_t);
+void stats_dump(void);
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define STATS_TICKS "cycles"
+static inline uint64_t stats_clock(void) {
+   return __rdtsc();
+}
+#else
+#include <time.h>
+#define STATS_TICKS "ns"
+static inline uint64_t stats_clock(void) {
+   struct timespec ts;
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return (uint64_t) ts.tv_sec * 1000000000u + ts.tv_nsec;
+}
+#endif
+
+// Records the deepest recursion of a finished statement
+static inline void stats_statement(void) {
+   struct stats *s = &stats_local;
+
+   s->depths[s->max_depth < STATS_DEPTHS ? s->max_depth : STATS_DEPTHS - 1]++;
+   s->max_depth = 0;
+}
+
+static inline void stats_enter(void) {
+   struct stats *s = &stats_local;
+
+   if (++s->depth > s->max_depth)
+      s->max_depth = s->depth;
+}
+
+/*
+ * Runs statement as one call of phase, timing it if the call is sampled.
+ * The first call of any phase on a thread is sampled, which is when the
+ * thread's counters are linked for the dump.
+ */
+#define STATS_TIMED(phase, statement)                                         \
+   do {                                                                       \
+      if (__builtin_expect(--stats_local.countdown[phase] <= 0, 0)) {         \
+         uint64_t stats_start = stats_sample(phase);                         \
+         statement;                                                          \
+         stats_sampled(phase, stats_start);                                  \
+      } else {                                                               \
+         statement;                                                          \
+      }                                                                      \
+   } while (0)
+#define STATS_TOKEN(kind)     (stats_local.tokens[kind]++)
+#define STATS_ENTER()         stats_enter()
+#define STATS_LEAVE()         (stats_local.depth--)
+#define STATS_STATEMENT()     stats_statement()
+#define STATS_COPIED(n)       (stats_local.bytes_copied += (n))
+#define STATS_READ(n)         (stats_local.bytes_read += (n))
+#define STATS_WRITTEN(n)      (stats_local.bytes_written += (n))
+
+#else
+
+#define STATS_TIMED(phase, statement) do { statement; } while (0)
+#define STATS_TOKEN(kind)     ((void) 0)
+#define STATS_ENTER()         ((void) 0)
+#define STATS_LEAVE()         ((void) 0)
+#define STATS_STATEMENT()     ((void) 0)
+#define STATS_COPIED(n)       ((void) 0)
+#define STATS_READ(n)         ((void) 0)
+#define STATS_WRITTEN(n)      ((void) 0)
+
+#endif /* PARSER_STATS */
+
+#endif
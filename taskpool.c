@@ -0,0 +1,192 @@
+/*
+ * taskpool.c - the work-stealing loop pool from taskpool.h. A loop
+ * starts as one range on the caller's deque. Whoever holds a range pushes
+ * its upper half back and keeps splitting the lower half, so the deques
+ * hold large ranges at the top, where thieves take from, and small ones
+ * at the bottom, where the owner takes from. Iterations are expected to
+ * be coarse, so each deque has a plain mutex.
+ * Date:   2025 May 13
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <sched.h>
+#include "taskpool.h"
+
+static void push(struct pool_deque *d, struct pool_range r) {
+   pthread_mutex_lock(&d->lock);
+   d->ranges[d->bottom++ % POOL_DEQUE] = r;
+   pthread_mutex_unlock(&d->lock);
+}
+
+// Takes the newest range of a thread's own deque
+static bool pop(struct pool_deque *d, struct pool_range *r) {
+   bool found;
+
+   pthread_mutex_lock(&d->lock);
+   if ((found = d->bottom != d->top))
+      *r = d->ranges[--d->bottom % POOL_DEQUE];
+   pthread_mutex_unlock(&d->lock);
+   return found;
+}
+
+// Takes the oldest, and so largest, range of some other thread's deque
+static bool steal(struct task_pool *pool, int self, struct pool_range *r) {
+   int i;
+
+   for (i = 1; i < pool->threads; i++) {
+      struct pool_deque *d = &pool->deques[(self + i) % pool->threads];
+      bool found;
+
+      pthread_mutex_lock(&d->lock);
+      if ((found = d->bottom != d->top))
+         *r = d->ranges[d->top++ % POOL_DEQUE];
+      pthread_mutex_unlock(&d->lock);
+      if (found) {
+         atomic_fetch_add(&pool->steals, 1);
+         return true;
+      }
+   }
+   return false;
+}
+
+// Runs iterations until every one of the current loop has finished
+static void work(struct task_pool *pool, int self) {
+   struct pool_deque *own = &pool->deques[self];
+   struct pool_range r;
+
+   while (atomic_load(&pool->remaining) > 0) {
+      if (!pop(own, &r) && !steal(pool, self, &r)) {
+         sched_yield(); // The last iterations are running elsewhere
+         continue;
+      }
+      while (r.hi - r.lo > 1) {
+         int mid = r.lo + (r.hi - r.lo) / 2;
+         push(own, (struct pool_range) { mid, r.hi });
+         r.hi = mid;
+      }
+      pool->fn(pool->arg, r.lo);
+      atomic_fetch_sub(&pool->remaining, 1);
+   }
+}
+
+static void *worker(void *arg) {
+   struct task_pool *pool = ((void **) arg)[0];
+   int self = (int) (intptr_t) ((void **) arg)[1];
+   unsigned seen = 0;
+
+   free(arg);
+   for (;;) {
+      pthread_mutex_lock(&pool->lock);
+      while (!pool->stopping && pool->generation == seen)
+         pthread_cond_wait(&pool->start, &pool->lock);
+      seen = pool->generation;
+      pthread_mutex_unlock(&pool->lock);
+      if (pool->stopping)
+         return NULL;
+
+      work(pool, self);
+
+      pthread_mutex_lock(&pool->lock);
+      if (--pool->active == 0)
+         pthread_cond_signal(&pool->done);
+      pthread_mutex_unlock(&pool->lock);
+   }
+}
+
+/**
+ * Starts a pool. The thread calling pool_for() is one of the threads,
+ * so a pool of 1 starts none and runs loops on the caller alone.
+ * @param pool: the pool to initialize
+ * @param threads: the number of threads, at least 1
+ * @return: false if out of memory or no thread could be started
+ */
+bool pool_init(struct task_pool *pool, int threads) {
+   int i;
+
+   memset(pool, 0, sizeof(*pool));
+   pool->threads = threads < 1 ? 1 : threads;
+   pool->deques = calloc(pool->threads, sizeof(struct pool_deque));
+   pool->ids = malloc(pool->threads * sizeof(pthread_t));
+   if (pool->deques == NULL || pool->ids == NULL) {
+      free(pool->deques);
+      free(pool->ids);
+      return false;
+   }
+   pthread_mutex_init(&pool->lock, NULL);
+   pthread_cond_init(&pool->start, NULL);
+   pthread_cond_init(&pool->done, NULL);
+   for (i = 0; i < pool->threads; i++)
+      pthread_mutex_init(&pool->deques[i].lock, NULL);
+
+   for (i = 1; i < pool->threads; i++) {
+      void **arg = malloc(2 * sizeof(void *));
+      if (arg == NULL)
+         break;
+      arg[0] = pool;
+      arg[1] = (void *) (intptr_t) i;
+      if (pthread_create(&pool->ids[i], NULL, worker, arg) != 0) {
+         free(arg);
+         break;
+      }
+   }
+   if (i < pool->threads) {
+      // Run with the threads that did start
+      pool->threads = i;
+   }
+   return true;
+}
+
+/**
+ * Runs fn(arg, i) for every i from 0 to count - 1, spread over the
+ * pool's threads, and returns when all have finished. Loops on one pool
+ * must not overlap.
+ * @param pool: the pool
+ * @param count: the number of iterations
+ * @param fn: the loop body
+ * @param arg: passed to every call of fn
+ */
+void pool_for(struct task_pool *pool, int count, void (*fn)(void *, int), void *arg) {
+   if (count <= 0)
+      return;
+   pool->fn = fn;
+   pool->arg = arg;
+   atomic_store(&pool->remaining, count);
+   push(&pool->deques[0], (struct pool_range) { 0, count });
+
+   pthread_mutex_lock(&pool->lock);
+   pool->active = pool->threads - 1;
+   pool->generation++;
+   pthread_cond_broadcast(&pool->start);
+   pthread_mutex_unlock(&pool->lock);
+
+   work(pool, 0);
+
+   pthread_mutex_lock(&pool->lock);
+   while (pool->active > 0)
+      pthread_cond_wait(&pool->done, &pool->lock);
+   pthread_mutex_unlock(&pool->lock);
+}
+
+/**
+ * Stops the pool's threads and frees it.
+ * @param pool: the pool to free
+ */
+void pool_free(struct task_pool *pool) {
+   int i;
+
+   pthread_mutex_lock(&pool->lock);
+   pool->stopping = true;
+   pthread_cond_broadcast(&pool->start);
+   pthread_mutex_unlock(&pool->lock);
+   for (i = 1; i < pool->threads; i++)
+      pthread_join(pool->ids[i], NULL);
+   for (i = 0; i < pool->threads; i++)
+      pthread_mutex_destroy(&pool->deques[i].lock);
+   pthread_mutex_destroy(&pool->lock);
+   pthread_cond_destroy(&pool->start);
+   pthread_cond_destroy(&pool->done);
+   free(pool->deques);
+   free(pool->ids);
+   memset(pool, 0, sizeof(*pool));
+}
@@ -0,0 +1,51 @@
+#ifndef TASKPOOL_H
+#define TASKPOOL_H
+/*
+ * Purpose: A pool of threads that run the iterations of a parallel loop
+ *          with work stealing: each thread splits the ranges it holds in
+ *          half until it is down to one iteration, and a thread that runs
+ *          out takes the largest range another thread has left.
+ * Date:    2025 May 13
+ */
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#include <pthread.h>
+
+#define POOL_DEQUE 64   // ranges a thread can hold; splitting holds at most ~log2(count)
+
+// Iterations lo to hi - 1 of the current loop
+struct pool_range {
+   int lo;
+   int hi;
+};
+
+// One thread's ranges: it takes from the bottom, thieves from the top
+struct pool_deque {
+   pthread_mutex_t lock;
+   struct pool_range ranges[POOL_DEQUE];
+   unsigned top;
+   unsigned bottom;
+};
+
+struct task_pool {
+   int threads;                 // including the thread calling pool_for()
+   struct pool_deque *deques;   // one per thread; the caller has deques[0]
+   pthread_t *ids;              // the threads other than the caller
+   pthread_mutex_t lock;        // guards the fields below
+   pthread_cond_t start;
+   pthread_cond_t done;
+   unsigned generation;         // bumped for each loop
+   int active;                  // threads not yet done with the loop
+   bool stopping;
+   void (*fn)(void *, int);     // the loop body and its argument
+   void *arg;
+   atomic_int remaining;        // iterations not yet finished
+   atomic_ullong steals;        // ranges taken from another thread
+};
+
+bool pool_init(struct task_pool *, int);
+void pool_for(struct task_pool *, int, void (*)(void *, int), void *);
+void pool_free(struct task_pool *);
+
+#endif
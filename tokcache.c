@@ -0,0 +1,298 @@
+/**
+ * tokcache.c - Writes a lexed source out as a compact binary token
+ * stream and loads it back, so inputs that have not changed since the
+ * last run never go through the lexer again.
+ *
+ * @version 05/02/2025
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "tokenizer.h"
+#include "tokcache.h"
+#include "scan.h"
+
+#define HASH_K1 0x9e3779b97f4a7c15ULL
+#define HASH_K2 0xbf58476d1ce4e5b9ULL
+
+/**
+* mix - Folds one 64-bit word into a running hash.
+*/
+static inline uint64_t mix(uint64_t hash, uint64_t word) {
+    hash ^= word * HASH_K1;
+    hash = (hash << 31) | (hash >> 33);
+    return hash * HASH_K2;
+}
+
+/**
+* hash_source - Hashes a source eight bytes at a time. Not for security;
+* it only has to notice that a source has changed.
+*/
+uint64_t hash_source(const char *text, size_t length) {
+    uint64_t hash = HASH_K2 ^ length, word;
+    size_t i;
+
+    for (i = 0; i + 8 <= length; i += 8) {
+        memcpy(&word, text + i, 8);
+        hash = mix(hash, word);
+    }
+    if (i < length) {
+        word = 0;
+        memcpy(&word, text + i, length - i);
+        hash = mix(hash, word);
+    }
+    hash ^= hash >> 32;
+    return hash * HASH_K1;
+}
+
+/**
+* reserve - Makes room for extra more bytes in tc->data.
+* @return false if out of memory
+*/
+static bool reserve(struct token_cache *tc, size_t extra) {
+    unsigned char *bigger;
+    size_t capacity = tc->capacity;
+
+    if (tc->length + extra <= capacity)
+        return true;
+    while (capacity < tc->length + extra)
+        capacity *= 2;
+    bigger = realloc(tc->data, capacity);
+    if (bigger == NULL)
+        return false;
+    tc->data = bigger;
+    tc->capacity = capacity;
+    return true;
+}
+
+/**
+* put_varint - Appends value 7 bits at a time, low bits first. The
+* caller has reserved room for it.
+*/
+static void put_varint(struct token_cache *tc, uint64_t value) {
+    while (value >= 0x80) {
+        tc->data[tc->length++] = (unsigned char) (value | 0x80);
+        value >>= 7;
+    }
+    tc->data[tc->length++] = (unsigned char) value;
+}
+
+/**
+* put_u64 - Stores value little-endian at p.
+*/
+static void put_u64(unsigned char *p, uint64_t value) {
+    for (int i = 0; i < 8; i++)
+        p[i] = (unsigned char) (value >> (8 * i));
+}
+
+/**
+* get_u64 - Reads a little-endian value stored by put_u64().
+*/
+static uint64_t get_u64(const unsigned char *p) {
+    uint64_t value = 0;
+    for (int i = 7; i >= 0; i--)
+        value = (value << 8) | p[i];
+    return value;
+}
+
+/**
+* tokcache_init - Starts an empty stream with room for about size bytes
+* of tokens.
+* @return false if out of memory
+*/
+bool tokcache_init(struct token_cache *tc, size_t size) {
+    tc->capacity = TOKCACHE_HEADER + size + 64;
+    tc->data = malloc(tc->capacity);
+    tc->length = TOKCACHE_HEADER;
+    tc->source_hash = 0;
+    tc->source_length = 0;
+    return tc->data != NULL;
+}
+
+/**
+* tokcache_append - Lexes text and adds its tokens to the end of the
+* stream. The first gap is counted from the start of text.
+* @return false if out of memory
+*/
+bool tokcache_append(struct token_cache *tc, char *text, size_t length) {
+    struct lexer_state lex;
+    char *previous = text;
+    int newlines = 0;
+
+    lex.line = lex.line_start = text;
+    lex.end = text + length;
+    for (;;) {
+        size_t gap;
+        unsigned char *first;
+        unsigned int value;
+
+        lex.line = skip_space(lex.line, lex.end, &newlines, &lex.line_start);
+        if (lex.line == lex.end)
+            break;
+        gap = (size_t) (lex.line - previous);
+        if (!reserve(tc, 32))   /* A token with all its fields fits in 32 */
+            return false;
+        scan_token(&lex);
+        first = &tc->data[tc->length++];
+        *first = (unsigned char) lex.kind;
+        if (gap < TOKCACHE_LONG_GAP) {
+            *first |= (unsigned char) (gap << TOKCACHE_GAP_SHIFT);
+        } else {
+            *first |= TOKCACHE_LONG_GAP << TOKCACHE_GAP_SHIFT;
+            put_varint(tc, gap);
+        }
+        if (lex.kind == INT_LITERAL) {
+            value = (unsigned int) parse_digits(lex.line - lex.lexeme_length,
+                                                lex.lexeme_length);
+            put_varint(tc, value);
+            if (lex.lexeme_length != tokcache_digits(value)) {
+                *first |= TOKCACHE_HAS_LENGTH;
+                put_varint(tc, (uint64_t) lex.lexeme_length);
+            }
+        } else if (lex.kind == IDENTIFIER) {
+            *first |= TOKCACHE_HAS_LENGTH;
+            put_varint(tc, (uint64_t) lex.lexeme_length);
+        }
+        previous = lex.line;
+    }
+    return true;
+}
+
+/**
+* tokcache_copy - Adds tokens encoded elsewhere to the end of the stream.
+* @return false if out of memory
+*/
+bool tokcache_copy(struct token_cache *tc, const unsigned char *tokens, size_t length) {
+    if (!reserve(tc, length))
+        return false;
+    memcpy(tc->data + tc->length, tokens, length);
+    tc->length += length;
+    return true;
+}
+
+/**
+* tokcache_build - Lexes text and encodes its tokens under a header.
+* @return false if out of memory
+*/
+bool tokcache_build(struct token_cache *tc, char *text, size_t length) {
+    if (!tokcache_init(tc, length / 2) || !tokcache_append(tc, text, length))
+        return false;
+    tc->source_hash = hash_source(text, length);
+    tc->source_length = length;
+    memcpy(tc->data, TOKCACHE_MAGIC, 4);
+    put_u64(tc->data + 4, tc->source_hash);
+    put_u64(tc->data + 12, (uint64_t) length);
+    put_u64(tc->data + 20, (uint64_t) (tc->length - TOKCACHE_HEADER));
+    return true;
+}
+
+/**
+* tokcache_write - Writes the whole stream to fd.
+* @return false if a write failed
+*/
+bool tokcache_write(const struct token_cache *tc, int fd) {
+    const unsigned char *p = tc->data;
+    size_t left = tc->length;
+
+    while (left > 0) {
+        ssize_t wrote = write(fd, p, left);
+        if (wrote < 0) {
+            if (errno == EINTR)
+                continue;
+            return false;
+        }
+        p += wrote;
+        left -= (size_t) wrote;
+    }
+    return true;
+}
+
+/**
+* tokcache_load - Reads the stream at path if it was built from exactly
+* this text. Only the header is checked; the tokens are decoded later,
+* with bounds checks, by whoever reads them.
+* @return false if there is no usable stream, leaving tc empty
+*/
+bool tokcache_load(struct token_cache *tc, const char *path,
+                   const char *text, size_t length) {
+    struct stat info;
+    size_t got = 0;
+    int fd = open(path, O_RDONLY);
+
+    tc->data = NULL;
+    tc->length = tc->capacity = 0;
+    if (fd < 0)
+        return false;
+    if (fstat(fd, &info) < 0 || info.st_size < TOKCACHE_HEADER
+        || (tc->data = malloc((size_t) info.st_size)) == NULL) {
+        close(fd);
+        return false;
+    }
+    tc->capacity = (size_t) info.st_size;
+
+    /* A source of the wrong size can be turned away from the header alone */
+    while (got < tc->capacity) {
+        ssize_t n = read(fd, tc->data + got, got == 0 ? TOKCACHE_HEADER : tc->capacity - got);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            break;
+        got += (size_t) n;
+        if (got == TOKCACHE_HEADER && (memcmp(tc->data, TOKCACHE_MAGIC, 4) != 0
+                                       || get_u64(tc->data + 12) != length))
+            break;
+    }
+    close(fd);
+    tc->length = got;
+
+    if (got != tc->capacity || memcmp(tc->data, TOKCACHE_MAGIC, 4) != 0
+        || get_u64(tc->data + 12) != length
+        || get_u64(tc->data + 20) != got - TOKCACHE_HEADER
+        || get_u64(tc->data + 4) != hash_source(text, length)) {
+        tokcache_free(tc);
+        return false;
+    }
+    tc->source_hash = get_u64(tc->data + 4);
+    tc->source_length = length;
+    return true;
+}
+
+/**
+* tokcache_open - Loads the stream for text from path, or lexes text and
+* saves a fresh stream there when the old one is missing or stale.
+*/
+enum tokcache_result tokcache_open(struct token_cache *tc, const char *path,
+                                   char *text, size_t length) {
+    int fd;
+    bool saved;
+
+    if (tokcache_load(tc, path, text, length))
+        return TOKCACHE_HIT;
+    if (!tokcache_build(tc, text, length)) {
+        tokcache_free(tc);
+        return TOKCACHE_ERROR;
+    }
+    fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    saved = fd >= 0 && tokcache_write(tc, fd);
+    if (fd >= 0)
+        close(fd);
+    if (!saved) {
+        fprintf(stderr, "ERROR: could not write %s\n", path);
+        remove(path);
+    }
+    return TOKCACHE_REBUILT;
+}
+
+/**
+* tokcache_free - Frees the stream.
+*/
+void tokcache_free(struct token_cache *tc) {
+    free(tc->data);
+    tc->data = NULL;
+    tc->length = tc->capacity = 0;
+}
@@ -0,0 +1,120 @@
+/**
+ * Header file for the binary token-stream cache
+ * @version 05/02/2025
+ */
+#ifndef TOKCACHE_H
+#define TOKCACHE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "tokenizer.h"
+
+#define TOKCACHE_MAGIC "TKS2"          /* First bytes of every stream      */
+#define TOKCACHE_HEADER (4 + 8 + 8 + 8) /* Magic, hash, source and body size */
+
+/* Fields of the first byte of each token */
+#define TOKCACHE_KIND_MASK 0x1f
+#define TOKCACHE_GAP_SHIFT 5
+#define TOKCACHE_LONG_GAP 3            /* Gap too long to fit; varint follows */
+#define TOKCACHE_HAS_LENGTH 0x80
+
+/**
+ * A lexed source as a compact byte stream. Each token starts with one
+ * byte holding its kind, the whitespace before it (0-2 bytes, or
+ * TOKCACHE_LONG_GAP when a varint gap follows) and whether its length is
+ * stored. An INT_LITERAL adds its value as a varint, then its length,
+ * only when that is not the digit count of the value (leading zeros or
+ * overflow). An IDENTIFIER always adds its length. Every other kind has
+ * a fixed length. The header holds a hash of the source, so a stale
+ * stream is never used.
+ */
+struct token_cache {
+    unsigned char *data;        /* Header, then the tokens          */
+    size_t length;              /* Bytes in data                    */
+    size_t capacity;            /* Size of data                     */
+    uint64_t source_hash;       /* hash_source() of the source      */
+    size_t source_length;       /* Bytes in the source              */
+};
+
+/* What tokcache_open() had to do */
+enum tokcache_result {
+    TOKCACHE_ERROR = -1,
+    TOKCACHE_REBUILT,
+    TOKCACHE_HIT
+};
+
+uint64_t hash_source(const char *text, size_t length);
+
+bool tokcache_init(struct token_cache *tc, size_t size);
+
+bool tokcache_append(struct token_cache *tc, char *text, size_t length);
+
+bool tokcache_copy(struct token_cache *tc, const unsigned char *tokens, size_t length);
+
+bool tokcache_build(struct token_cache *tc, char *text, size_t length);
+
+bool tokcache_write(const struct token_cache *tc, int fd);
+
+bool tokcache_load(struct token_cache *tc, const char *path,
+                   const char *text, size_t length);
+
+enum tokcache_result tokcache_open(struct token_cache *tc, const char *path,
+                                   char *text, size_t length);
+
+void tokcache_free(struct token_cache *tc);
+
+/**
+* tokcache_tokens - First byte of the encoded tokens.
+*/
+static inline const unsigned char *tokcache_tokens(const struct token_cache *tc) {
+    return tc->data + TOKCACHE_HEADER;
+}
+
+/**
+* tokcache_fixed_length - Length of every lexeme of a kind other than
+* INT_LITERAL and IDENTIFIER.
+*/
+static inline int tokcache_fixed_length(enum token_kind kind) {
+    switch (kind) {
+        case LESS_THAN_OR_EQUAL_OP:
+        case GREATER_THAN_OR_EQUAL_OP:
+        case EQUALS_OP:
+        case NOT_EQUALS_OP:
+            return 2;
+        default:
+            return 1;
+    }
+}
+
+/**
+* tokcache_digits - Number of decimal digits in value.
+*/
+static inline int tokcache_digits(unsigned int value) {
+    int digits = 1;
+    while (value >= 10) {
+        value /= 10;
+        digits++;
+    }
+    return digits;
+}
+
+/**
+* tokcache_varint - Reads the varint at *p, which must come before end,
+* and moves *p past it. A varint cut off by end reads as 0.
+*/
+static inline uint64_t tokcache_varint(const unsigned char **p, const unsigned char *end) {
+    uint64_t value = 0;
+    int shift = 0;
+
+    while (*p < end && shift < 64) {
+        unsigned char byte = *(*p)++;
+        value |= (uint64_t) (byte & 0x7f) << shift;
+        if (byte < 0x80)
+            return value;
+        shift += 7;
+    }
+    return 0;
+}
+
+#endif
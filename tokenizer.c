@@ -13,237 +13,487 @@
 #include <string.h>
 #include <stdlib.h>
 #include <stdbool.h>
+#include <stddef.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include "tokenizer.h"
+#include "scan.h"
+#include "writer.h"
+#include "tokcache.h"
+#include "stats.h"
 
-// global variables
-char *line;             // Global pointer to line of input
-char current_category[LINE]; // Global pointer to current category (e.g. ADD_OP)
-int lexeme_length; // Global pointer to length of lexeme
-
+#ifndef TOKENIZER_NO_MAIN
 /**
 * main - Reads a file of input and tokenizes it.
 */
 int main(int argc, char* argv[]) {
-    char token[TSIZE];      /* Spot to hold a token, fixed size */
-    char input_line[LINE];  /* Line of input, fixed size        */
-    FILE *in_file = NULL;        /* File pointer                     */
-    FILE *out_file = NULL;
-    int line_count,        /* Number of lines read             */
-    start,    /* is this the start of a new statement? */
-    count;             /*  count of tokens                  */
+    int in_fd = STDIN_FILENO;    /* Input, or stdin for "-"          */
+    int out_fd;
+    bool mapped = false;         /* mmap the input instead of reading it? */
+    bool cached = false;         /* write a token stream, not a report?   */
+    int status = 0;
 
+    if (argc == 4 && (strcmp(argv[1], "-m") == 0 || strcmp(argv[1], "-c") == 0)) {
+        cached = argv[1][1] == 'c';
+        mapped = true;
+        argv++;
+        argc--;
+    }
     if (argc != 3) {
-        fprintf(out_file, "Usage: tokenizer inputFile outputFile\n");
+        fprintf(stderr, "Usage: tokenizer [-m | -c] inputFile outputFile\n"
+                        "       -c writes a binary token stream for the parser\n"
+                        "       inputFile - reads stdin (not with -m or -c)\n");
         exit(1);
     }
 
-    in_file = fopen(argv[1], "r");
-    if (in_file == NULL) {
-        fprintf(out_file, (const char *) stderr, "ERROR: could not open %s for reading\n", argv[1]);
-        exit(1);
+    if (!mapped && strcmp(argv[1], "-") != 0) {
+        in_fd = open(argv[1], O_RDONLY);
+        if (in_fd < 0) {
+            fprintf(stderr, "ERROR: could not open %s for reading\n", argv[1]);
+            exit(1);
+        }
     }
 
-    out_file = fopen(argv[2], "w");
-    if (out_file == NULL) {
-        fprintf(out_file, (const char *) stderr, "ERROR: could not open %s for writing\n", argv[2]);
+    out_fd = open(argv[2], O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (out_fd < 0) {
+        fprintf(stderr, "ERROR: could not open %s for writing\n", argv[2]);
         exit(1);
     }
 
-    int i = 1; // Statement number
-    count = 0; // Token count
-    line_count = 0; // Line count
-    start = 1; // Start of a new statement
+    if (cached) {
+        status = tokenize_cached(argv[1], out_fd);
+    } else if (mapped) {
+        status = tokenize_mapped(argv[1], out_fd);
+    } else {
+        status = tokenize_stream(in_fd, out_fd);
+        close(in_fd);
+    }
+    close(out_fd);
+    return status == 0 ? 0 : 1;
+}
+#endif /* TOKENIZER_NO_MAIN */
 
-    // Read each line of the input file
-    while (fgets(input_line, LINE, in_file) != NULL) {
-        if(start == 1){ // If this is the start of a new statement
-            fprintf(out_file, "Statement #%d\n", i);
-            start = 0;
-            count = 0;
-        }
-        line = input_line;  // Sets a global pointer to the memory location here input resides
-        while (*line != '\0') { // While not at the end of the line
-            strcpy(token, line);
-            if (*line == ' ' || *line == '\t' || *line == '\n') { // If whitespace, skip
-                line++;
-                if (*line == '\n')
-                    line_count++;
-            } else { // Otherwise, get the token
-                get_token(token);
-                if (strcmp(current_category, "INVALID") != 0) { // If the token is valid
-                    fprintf(out_file, "Lexeme %d is %s and is a", count, token);
-                    if (is_vowel(current_category[0])){
-                        fprintf(out_file, "n");
-                        }
-                    fprintf(out_file, " %s\n", current_category);
-                    count++;
-                }
-                else { // If the token is invalid
-                    fprintf(out_file, "===> '%c'\nLexical error: not a lexeme\n", *token);
-                }
-                if (strcmp(current_category, "SEMI_COLON") == 0) { // If the token is a semicolon
-                    i++;
-                    fprintf(out_file,
-                            "---------------------------------------------------------\n");
-                    start = 1;
-                }
+/* Report text after each kind of lexeme, with its article worked out */
+#define REPORT_SUFFIX(kind, article) \
+    [kind] = { " and is " article " " #kind "\n", sizeof(" and is " article " " #kind "\n") - 1 }
 
-            }
-        }
-    }
+static const struct {
+    const char *text;
+    size_t length;
+} report_suffix[TOKEN_KIND_COUNT] = {
+    REPORT_SUFFIX(ADD_OP, "an"),
+    REPORT_SUFFIX(SUB_OP, "a"),
+    REPORT_SUFFIX(MULT_OP, "a"),
+    REPORT_SUFFIX(DIV_OP, "a"),
+    REPORT_SUFFIX(LESS_THAN_OP, "a"),
+    REPORT_SUFFIX(LESS_THAN_OR_EQUAL_OP, "a"),
+    REPORT_SUFFIX(GREATER_THAN_OP, "a"),
+    REPORT_SUFFIX(GREATER_THAN_OR_EQUAL_OP, "a"),
+    REPORT_SUFFIX(EQUALS_OP, "an"),
+    REPORT_SUFFIX(NOT_EQUALS_OP, "a"),
+    REPORT_SUFFIX(ASSIGN_OP, "an"),
+    REPORT_SUFFIX(NOT_OP, "a"),
+    REPORT_SUFFIX(EXPON_OP, "an"),
+    REPORT_SUFFIX(INT_LITERAL, "an"),
+    REPORT_SUFFIX(LEFT_PAREN, "a"),
+    REPORT_SUFFIX(RIGHT_PAREN, "a"),
+    REPORT_SUFFIX(SEMI_COLON, "a"),
+    REPORT_SUFFIX(IDENTIFIER, "an")
+};
 
-    fclose(in_file);
-    fclose(out_file);
+#define LITERAL(text) text, sizeof(text) - 1
+
+/**
+* report_init - Starts a token report at statement #1.
+* @return false if the output buffer could not be allocated
+*/
+bool report_init(struct token_report *rep, int out_fd) {
+    rep->statement = 1;
+    rep->count = 0;
+    rep->line_count = 0;
+    rep->start = true;
+    return out_init(&rep->out, out_fd);
+}
+
+/**
+* report_finish - Writes out the rest of the report.
+* @return 0, or -1 if any write failed
+*/
+int report_finish(struct token_report *rep) {
+    out_free(&rep->out);
+    if (rep->out.failed) {
+        fprintf(stderr, "ERROR: could not write the report\n");
+        return -1;
+    }
     return 0;
 }
 
 /**
-* get_token - Extracts the next token from a line of input.
+* report_token - Writes the lexeme the lexer just scanned to the report,
+* starting a new statement before its first lexeme and closing it after
+* its semicolon.
 */
-void get_token(char *token_ptr) {
-    lexeme_length = 1;
-    if (check_token(token_ptr) == false) { // If the token is not an operator, integer, or parenthesis
-        strcpy(current_category, "INVALID");
+void report_token(struct token_report *rep, const struct lexer_state *lex) {
+    const char *lexeme = lex->line - lex->lexeme_length; /* View of the lexeme */
+
+    struct out_buffer *out = &rep->out;
+
+    if (rep->start) { // If this is the start of a new statement
+        out_bytes(out, LITERAL("Statement #"));
+        out_int(out, rep->statement);
+        out_bytes(out, LITERAL("\n"));
+        rep->start = false;
+        rep->count = 0;
+    }
+    if (lex->kind != INVALID) { // If the token is valid
+        out_bytes(out, LITERAL("Lexeme "));
+        out_int(out, rep->count);
+        out_bytes(out, LITERAL(" is "));
+        out_bytes(out, lexeme, (size_t) lex->lexeme_length);
+        out_bytes(out, report_suffix[lex->kind].text, report_suffix[lex->kind].length);
+        rep->count++;
+    }
+    else { // If the token is invalid
+        out_bytes(out, LITERAL("===> '"));
+        out_bytes(out, lexeme, 1);
+        out_bytes(out, LITERAL("'\nLexical error: not a lexeme\n"));
+    }
+    if (lex->kind == SEMI_COLON) { // If the token is a semicolon
+        rep->statement++;
+        out_bytes(out, LITERAL(
+                "---------------------------------------------------------\n"));
+        rep->start = true;
     }
-    token_ptr[lexeme_length] = '\0'; // Null-terminate the token
-    line += lexeme_length; // Move the line pointer to the next token
 }
 
 /**
-* check_token - Checks if a token is a valid operator, integer, or parenthesis.
+* tokenize_range - Tokenizes input from lex->line up to end. Unless this
+* is the final piece of input, a lexeme that runs into end may continue
+* past it, so it is left unread for the caller to carry over.
+* @return where tokenizing stopped
 */
-bool check_token(char *token) {
-    return (is_valid_operator(token)
-            || is_valid_integer(token)
-            || is_valid_parenthesis(token)
-            || is_semi_colon(token));
+static char *tokenize_range(struct lexer_state *lex, struct token_report *rep,
+                            char *end, bool final) {
+    char *lexeme;
+
+    lex->end = end;
+    while (lex->line < end) {
+        switch (*lex->line) {
+            case '\n':
+            case ' ':
+            case '\t':
+                lex->line = skip_space(lex->line, end, &rep->line_count, &lex->line_start);
+                break;
+            default:
+                lexeme = lex->line;
+                scan_token(lex);
+                if (!final && lex->line >= end) { // might continue in the next chunk
+                    lex->line = lexeme;
+                    return lexeme;
+                }
+                report_token(rep, lex);
+        }
+    }
+    return lex->line;
 }
 
 /**
-* is_valid_operator - Checks if a token is a valid operator.
+* tokenize_stream - Tokenizes input read in STREAM_CHUNK sized blocks, so
+* pipes work and memory stays bounded however large the input is. Only a
+* lexeme cut off by the end of a block is carried into the next one; the
+* buffer grows only if a single lexeme is longer than the whole buffer.
 */
-bool is_valid_operator(char *token) {
-    bool result = true;
-    switch (*token) {
-        case '+':
-            strcpy(current_category, "ADD_OP");
-            break;
-        case '-':
-            strcpy(current_category, "SUB_OP");
-            break;
-        case '*':
-            strcpy(current_category, "MULT_OP");
-            break;
-        case '/':
-            strcpy(current_category, "DIV_OP");
-            break;
-        case '<':
-            if (check_equals(token) == true)
-                strcpy(current_category, "LESS_THAN_OR_EQUAL_OP");
-            else
-                strcpy(current_category, "LESS_THAN_OP");
-            break;
-        case '>':
-            if (check_equals(token) == true)
-                strcpy(current_category, "GREATER_THAN_OR_EQUAL_OP");
-            else
-                strcpy(current_category, "GREATER_THAN_OP");
-            break;
-        case '=':
-            if (check_equals(token) == true)
-                strcpy(current_category, "EQUALS_OP");
-            else
-                strcpy(current_category, "ASSIGN_OP");
-            break;
-        case '^':
-            strcpy(token, "^");
-        strcpy(current_category, "EXPON_OP");
-            break;
-        case '!':
-            if (check_equals(token) == true)
-                strcpy(current_category, "NOT_EQUALS_OP");
-            else
-                strcpy(current_category, "NOT_OP");
+int tokenize_stream(int in_fd, int out_fd) {
+    struct lexer_state lex;
+    struct token_report rep;
+    size_t capacity = STREAM_CHUNK, kept = 0;
+    char *buffer = malloc(capacity + 1), *end, *stop;
+    ssize_t got;
+
+    if (buffer == NULL || !report_init(&rep, out_fd)) {
+        fprintf(stderr, "ERROR: out of memory\n");
+        free(buffer);
+        return -1;
+    }
+    lex.line_start = buffer;
+
+    for (;;) {
+        if (kept == capacity) { // one lexeme fills the buffer
+            ptrdiff_t line_offset = lex.line_start - buffer;
+            char *bigger = realloc(buffer, capacity * 2 + 1);
+            if (bigger == NULL) {
+                fprintf(stderr, "ERROR: out of memory\n");
+                free(buffer);
+                report_finish(&rep);
+                return -1;
+            }
+            lex.line_start = bigger + line_offset;
+            buffer = bigger;
+            capacity *= 2;
+        }
+        STATS_TIMED(PHASE_IO, got = read(in_fd, buffer + kept, capacity - kept));
+        if (got > 0)
+            STATS_READ(got);
+        if (got < 0 && errno == EINTR)
+            continue;
+        if (got < 0) {
+            fprintf(stderr, "ERROR: read failed: %s\n", strerror(errno));
+            free(buffer);
+            report_finish(&rep);
+            return -1;
+        }
+
+        end = buffer + kept + got;
+        *end = '\0';
+        lex.line = buffer;
+        stop = tokenize_range(&lex, &rep, end, got == 0);
+        if (got == 0)
             break;
-        default:
-            result = false;
+
+        // move the unfinished lexeme to the front; the line start moves
+        // with it so lexeme offsets stay relative to the same line
+        kept = (size_t) (end - stop);
+        memmove(buffer, stop, kept);
+        STATS_COPIED(kept);
+        lex.line_start -= stop - buffer;
     }
-    return result;
+
+    free(buffer);
+    return report_finish(&rep);
 }
 
 /**
-* is_vowel - Checks if a letter is a vowel.
+* map_input - Maps a whole file read-only. The mapping is followed by at
+* least one zero byte, so the lexer can look one byte past the last
+* character without a bounds check.
 */
-bool is_vowel(char letter) {
-    return (letter == 'A' ||
-            letter == 'E' ||
-            letter == 'I' ||
-            letter == 'O' ||
-            letter == 'U');
+static char *map_input(const char *path, size_t *length, size_t *mapped) {
+    struct stat st;
+    size_t page = (size_t) sysconf(_SC_PAGESIZE);
+    char *base;
+    int fd = open(path, O_RDONLY);
+
+    if (fd < 0)
+        return NULL;
+    if (fstat(fd, &st) < 0) {
+        close(fd);
+        return NULL;
+    }
+    *length = (size_t) st.st_size;
+    *mapped = (*length / page + 1) * page;
+
+    // reserve zero pages for the whole range, then map the file over them
+    base = mmap(NULL, *mapped, PROT_READ, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (base != MAP_FAILED && *length > 0
+        && mmap(base, *length, PROT_READ, MAP_PRIVATE | MAP_FIXED, fd, 0) == MAP_FAILED) {
+        munmap(base, *mapped);
+        base = MAP_FAILED;
+    }
+    close(fd);
+    if (base == MAP_FAILED)
+        return NULL;
+    madvise(base, *mapped, MADV_SEQUENTIAL);
+    return base;
 }
 
 /**
-* is_valid_integer - Checks if a token is a valid integer.
+* tokenize_mapped - Tokenizes a file mapped into memory. Lexemes are views
+* into the mapping and are only copied when written out, and lines may be
+* any length.
 */
-bool is_valid_integer(char *token) {
-    bool result = true;
-    strcpy(current_category, "INT_LITERAL");
-    if (*token == '1'
-        || *token == '2'
-        || *token == '3'
-        || *token == '4'
-        || *token == '5'
-        || *token == '6'
-        || *token == '7'
-        || *token == '8'
-        || *token == '9'
-        || *token == '0') {
-        if (is_valid_integer(token + 1)) {
-            lexeme_length++;
-        }
-        } else {
-            result = false;
-        }
-    return result;
+int tokenize_mapped(const char *path, int out_fd) {
+    struct lexer_state lex;
+    struct token_report rep;
+    size_t length, mapped;
+    char *input = map_input(path, &length, &mapped), *end;
+
+    if (input == NULL) {
+        fprintf(stderr, "ERROR: could not map %s for reading\n", path);
+        return -1;
+    }
+    if (!report_init(&rep, out_fd)) {
+        fprintf(stderr, "ERROR: out of memory\n");
+        munmap(input, mapped);
+        return -1;
+    }
+
+    end = input + length;
+    lex.line = lex.line_start = input;
+    tokenize_range(&lex, &rep, end, true);
+
+    munmap(input, mapped);
+    return report_finish(&rep);
 }
 
 /**
-* is_valid_parenthesis - Checks if a token is a valid parenthesis.
+* tokenize_cached - Writes the tokens of a file as a binary token stream
+* (see tokcache.h) instead of a report.
 */
-bool is_valid_parenthesis(char *token) {
-    switch (*token) {
-        case '(':
-            strcpy(current_category, "LEFT_PAREN");
-            return true;
-        case ')':
-            strcpy(current_category, "RIGHT_PAREN");
-            return true;
+int tokenize_cached(const char *path, int out_fd) {
+    struct token_cache tc;
+    size_t length, mapped;
+    char *input = map_input(path, &length, &mapped);
+    int status = 0;
+
+    if (input == NULL) {
+        fprintf(stderr, "ERROR: could not map %s for reading\n", path);
+        return -1;
+    }
+    if (!tokcache_build(&tc, input, length)) {
+        fprintf(stderr, "ERROR: out of memory\n");
+        status = -1;
+    } else if (!tokcache_write(&tc, out_fd)) {
+        fprintf(stderr, "ERROR: could not write the token stream\n");
+        status = -1;
+    }
+    tokcache_free(&tc);
+    munmap(input, mapped);
+    return status;
+}
+
+/**
+* Character classes used by scan_token() to pick a lexeme in one lookup.
+*/
+enum char_class {
+    CC_OTHER,   /* not the start of any lexeme              */
+    CC_SPACE,   /* blank, tab or newline                     */
+    CC_DIGIT,   /* 0-9                                       */
+    CC_ALPHA,   /* A-Z, a-z or _, which starts an identifier */
+    CC_SINGLE,  /* always a one character lexeme             */
+    CC_PAIR     /* one character, or two when followed by =  */
+};
+
+static const unsigned char char_class[256] = {
+    [' '] = CC_SPACE, ['\t'] = CC_SPACE, ['\n'] = CC_SPACE,
+    ['0'] = CC_DIGIT, ['1'] = CC_DIGIT, ['2'] = CC_DIGIT, ['3'] = CC_DIGIT,
+    ['4'] = CC_DIGIT, ['5'] = CC_DIGIT, ['6'] = CC_DIGIT, ['7'] = CC_DIGIT,
+    ['8'] = CC_DIGIT, ['9'] = CC_DIGIT,
+    ['A' ... 'Z'] = CC_ALPHA, ['a' ... 'z'] = CC_ALPHA, ['_'] = CC_ALPHA,
+    ['+'] = CC_SINGLE, ['-'] = CC_SINGLE, ['*'] = CC_SINGLE, ['/'] = CC_SINGLE,
+    ['^'] = CC_SINGLE, ['('] = CC_SINGLE, [')'] = CC_SINGLE, [';'] = CC_SINGLE,
+    ['<'] = CC_PAIR, ['>'] = CC_PAIR, ['='] = CC_PAIR, ['!'] = CC_PAIR
+};
+
+/* Characters that continue an identifier */
+static const bool ident_char[256] = {
+    ['A' ... 'Z'] = true, ['a' ... 'z'] = true, ['0' ... '9'] = true, ['_'] = true
+};
+
+/* Kind of a CC_SINGLE or CC_PAIR character on its own */
+static const unsigned char single_kind[256] = {
+    ['+'] = ADD_OP, ['-'] = SUB_OP, ['*'] = MULT_OP, ['/'] = DIV_OP,
+    ['^'] = EXPON_OP, ['('] = LEFT_PAREN, [')'] = RIGHT_PAREN,
+    [';'] = SEMI_COLON,
+    ['<'] = LESS_THAN_OP, ['>'] = GREATER_THAN_OP, ['='] = ASSIGN_OP,
+    ['!'] = NOT_OP
+};
+
+/* Kind of a CC_PAIR character followed by '=' */
+static const unsigned char pair_kind[256] = {
+    ['<'] = LESS_THAN_OR_EQUAL_OP, ['>'] = GREATER_THAN_OR_EQUAL_OP,
+    ['='] = EQUALS_OP, ['!'] = NOT_EQUALS_OP
+};
+
+/* Category names, only needed when writing output */
+static const char *const category_names[TOKEN_KIND_COUNT] = {
+    [ADD_OP] = "ADD_OP",
+    [SUB_OP] = "SUB_OP",
+    [MULT_OP] = "MULT_OP",
+    [DIV_OP] = "DIV_OP",
+    [LESS_THAN_OP] = "LESS_THAN_OP",
+    [LESS_THAN_OR_EQUAL_OP] = "LESS_THAN_OR_EQUAL_OP",
+    [GREATER_THAN_OP] = "GREATER_THAN_OP",
+    [GREATER_THAN_OR_EQUAL_OP] = "GREATER_THAN_OR_EQUAL_OP",
+    [EQUALS_OP] = "EQUALS_OP",
+    [NOT_EQUALS_OP] = "NOT_EQUALS_OP",
+    [ASSIGN_OP] = "ASSIGN_OP",
+    [NOT_OP] = "NOT_OP",
+    [EXPON_OP] = "EXPON_OP",
+    [INT_LITERAL] = "INT_LITERAL",
+    [LEFT_PAREN] = "LEFT_PAREN",
+    [RIGHT_PAREN] = "RIGHT_PAREN",
+    [SEMI_COLON] = "SEMI_COLON",
+    [IDENTIFIER] = "IDENTIFIER",
+    [INVALID] = "INVALID",
+    [END_OF_INPUT] = "END_OF_INPUT"
+};
+
+/**
+* scan_lexeme - The body of scan_token(), apart so the instrumented build
+* can time some calls of it.
+*/
+static inline void scan_lexeme(struct lexer_state *lex) {
+    const unsigned char *p = (const unsigned char *) lex->line;
+    int length = 1;
+
+    lex->lexeme_offset = (int) (lex->line - lex->line_start);
+    switch (char_class[*p]) {
+        case CC_DIGIT:
+            length = (int) (skip_digits(lex->line + 1, lex->end) - lex->line);
+            lex->kind = INT_LITERAL;
+            break;
+        case CC_ALPHA:
+            while (lex->line + length < lex->end && ident_char[p[length]])
+                length++;
+            lex->kind = IDENTIFIER;
+            break;
+        case CC_SINGLE:
+            lex->kind = single_kind[*p];
+            break;
+        case CC_PAIR:
+            if (lex->line + 1 < lex->end && p[1] == '=') {
+                lex->kind = pair_kind[*p];
+                length++;
+            } else {
+                lex->kind = single_kind[*p];
+            }
+            break;
         default:
-            return false;
+            lex->kind = INVALID;
     }
+    lex->lexeme_length = length;
+    lex->line += length; // Move the line pointer to the next token
+}
+
+/**
+* scan_token - Scans the lexeme at lex->line without copying it, setting
+* kind, lexeme_offset and lexeme_length and moving past it. Nothing at or
+* after lex->end is read.
+*/
+void scan_token(struct lexer_state *lex) {
+    STATS_TIMED(PHASE_LEX, scan_lexeme(lex));
+    STATS_TOKEN(lex->kind);
 }
 
 /**
-* is_semi_colon - Checks if a token is a semicolon.
+* next_lexeme - Skips whitespace and scans the next lexeme into a
+* descriptor of it, with nothing copied. At lex->end it describes an
+* empty END_OF_INPUT lexeme there; lex->end must be set as for
+* scan_token().
 */
-bool is_semi_colon(char *token) {
-    bool result = true;
-    if (*token == ';') {
-        strcpy(current_category, "SEMI_COLON");
+void next_lexeme(struct lexer_state *lex, struct lexeme *out) {
+    int newlines = 0;
+
+    lex->line = skip_space(lex->line, lex->end, &newlines, &lex->line_start);
+    if (lex->line == lex->end) {
+        lex->kind = END_OF_INPUT;
+        lex->lexeme_offset = (int) (lex->line - lex->line_start);
+        lex->lexeme_length = 0;
     } else {
-        result = false;
+        scan_token(lex);
     }
-    return result;
+    out->kind = lex->kind;
+    out->length = lex->lexeme_length;
+    out->start = lex->line - lex->lexeme_length;
+    out->value = lex->kind == INT_LITERAL ? parse_digits(out->start, out->length) : 0;
 }
 
 /**
-* check_equals - Checks if a token is an equals operator.
+* category_name - Returns the output name of a token kind.
 */
-bool check_equals(char *token) {
-    bool result = false;
-    if (*(token + 1) == '=') {
-        lexeme_length++;
-        result = true;
-    }
-    return result;
+const char *category_name(enum token_kind kind) {
+    return category_names[kind];
 }
@@ -1,34 +1,104 @@
 /**
- * Header file for the tokenizer project 
+ * Header file for the tokenizer project
  * @author Andrew Patterson
  * @version 04/22/2025
  */
+#ifndef TOKENIZER_H
+#define TOKENIZER_H
+
+#include <stdbool.h>
+#include "writer.h"
 
 /* Constants */
-#define LINE 100
-#define TSIZE 20
+#ifndef STREAM_CHUNK
+#define STREAM_CHUNK (64 * 1024)   /* Bytes read at a time from a stream */
+#endif
 #define TRUE 1
 #define FALSE 0
 
 /**
-* add comment
-*/
-void get_token(char *token);
+ * Token kinds produced by scan_token(). The names match the category
+ * strings written to the output file (see category_name()).
+ */
+enum token_kind {
+    ADD_OP,
+    SUB_OP,
+    MULT_OP,
+    DIV_OP,
+    LESS_THAN_OP,
+    LESS_THAN_OR_EQUAL_OP,
+    GREATER_THAN_OP,
+    GREATER_THAN_OR_EQUAL_OP,
+    EQUALS_OP,
+    NOT_EQUALS_OP,
+    ASSIGN_OP,
+    NOT_OP,
+    EXPON_OP,
+    INT_LITERAL,
+    LEFT_PAREN,
+    RIGHT_PAREN,
+    SEMI_COLON,
+    IDENTIFIER,
+    INVALID,
+    END_OF_INPUT,
+    TOKEN_KIND_COUNT
+};
 
-bool is_valid_operator(char *token);
+/**
+ * All lexer state. Each input being tokenized gets its own lexer_state,
+ * so several inputs can be lexed at once on different threads.
+ */
+struct lexer_state {
+    char *line;                 /* Next unread character            */
+    char *line_start;           /* Start of the current input line  */
+    char *end;                  /* End of the input                 */
+    enum token_kind kind;       /* Kind of the last lexeme          */
+    int lexeme_offset;          /* Offset of the lexeme in the line */
+    int lexeme_length;          /* Length of the last lexeme        */
+};
 
-bool is_vowel(char letter);
+/**
+ * A token as next_lexeme() found it: a view of its bytes in the input,
+ * never a copy, and the value of an INT_LITERAL already decoded.
+ */
+struct lexeme {
+    enum token_kind kind;       /* Kind of the token                */
+    char *start;                /* First byte, in the input         */
+    int length;                 /* Bytes in it; 0 at END_OF_INPUT   */
+    int value;                  /* Value of an INT_LITERAL, wrapped */
+};
 
-int main(int argc, char *argv[]);
+/**
+ * Progress of the token report written to the output file.
+ */
+struct token_report {
+    struct out_buffer out;      /* Where the report goes            */
+    int statement;              /* Number of the current statement  */
+    int count;                  /* Lexemes so far in the statement  */
+    int line_count;             /* Lines read so far                */
+    bool start;                 /* Next lexeme starts a statement?  */
+};
+
+void scan_token(struct lexer_state *lex);
+
+void next_lexeme(struct lexer_state *lex, struct lexeme *out);
 
-bool check_token(char *token);
+bool report_init(struct token_report *rep, int out_fd);
 
-bool is_valid_integer(char *token);
+int report_finish(struct token_report *rep);
 
-bool is_valid_parenthesis(char *token);
+void report_token(struct token_report *rep, const struct lexer_state *lex);
 
-bool is_semi_colon(char *token);
+int tokenize_stream(int in_fd, int out_fd);
 
-bool check_equals(char *token);
+int tokenize_mapped(const char *path, int out_fd);
 
+int tokenize_cached(const char *path, int out_fd);
+
+const char *category_name(enum token_kind kind);
+
+#ifndef TOKENIZER_NO_MAIN
+int main(int argc, char *argv[]);
+#endif
 
+#endif
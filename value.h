@@ -0,0 +1,176 @@
+#ifndef VALUE_H
+#define VALUE_H
+/*
+ * Purpose: The number type the numeric evaluator computes with, chosen
+ *          at compile time:
+ *            (default)        int, as parser.c uses; overflow wraps
+ *            -DVALUE_INT64    64-bit, every operation checked
+ *            -DVALUE_BIGNUM   arbitrary precision (bignum.c)
+ *          Every backend has the same val_* functions, so numeric.c is
+ *          written once. The int and int64 ones are inline and work on
+ *          plain integers, so those builds cost nothing over parser.c.
+ *          Each returns false when the result cannot be represented.
+ * Date:    2025 May 5
+ */
+#include <stdbool.h>
+#include <stdio.h>
+
+#if defined(VALUE_BIGNUM)
+
+#include "bignum.h"
+
+#define VALUE_NAME "bignum"
+typedef struct bignum value_t;
+
+#define val_init big_init
+#define val_free big_free
+#define val_digits big_digits
+#define val_add big_add
+#define val_sub big_sub
+#define val_mul big_mul
+#define val_div big_div
+#define val_pow big_pow
+#define val_cmp big_cmp
+#define val_print big_print
+
+static inline bool val_is_zero(const value_t *v) {
+   return v->length == 0;
+}
+
+static inline bool val_bool(value_t *r, bool b) {
+   return big_set_int(r, b);
+}
+
+#elif defined(VALUE_INT64)
+
+#include <stdint.h>
+
+#define VALUE_NAME "int64"
+typedef int64_t value_t;
+
+static inline void val_init(value_t *v) { *v = 0; }
+static inline void val_free(value_t *v) { (void) v; }
+static inline bool val_is_zero(const value_t *v) { return *v == 0; }
+static inline bool val_bool(value_t *r, bool b) { *r = b; return true; }
+
+static inline bool val_digits(value_t *r, const char *p, int length) {
+   int64_t value = 0;
+   for (int i = 0; i < length; i++) {
+      if (__builtin_mul_overflow(value, 10, &value)
+          || __builtin_add_overflow(value, p[i] - '0', &value))
+         return false;
+   }
+   *r = value;
+   return true;
+}
+
+static inline bool val_add(value_t *r, const value_t *a, const value_t *b) {
+   return !__builtin_add_overflow(*a, *b, r);
+}
+
+static inline bool val_sub(value_t *r, const value_t *a, const value_t *b) {
+   return !__builtin_sub_overflow(*a, *b, r);
+}
+
+static inline bool val_mul(value_t *r, const value_t *a, const value_t *b) {
+   return !__builtin_mul_overflow(*a, *b, r);
+}
+
+static inline bool val_div(value_t *r, const value_t *a, const value_t *b) {
+   if (*b == 0 || (*a == INT64_MIN && *b == -1))
+      return false;
+   *r = *a / *b;
+   return true;
+}
+
+// Same rules as ipow(), in 64 bits
+static inline bool val_pow(value_t *r, const value_t *a, const value_t *b) {
+   int64_t base = *a, exponent = *b, result = 1;
+
+   if (exponent < 0) {
+      if (base == 0)
+         return false;
+      *r = (base == 1 || base == -1) ? ((base == -1 && (exponent & 1)) ? -1 : 1) : 0;
+      return true;
+   }
+   if (base >= -1 && base <= 1) {
+      *r = exponent == 0 ? 1 : (base == -1 && !(exponent & 1)) ? 1 : base;
+      return true;
+   }
+   for (;;) {
+      if ((exponent & 1) && __builtin_mul_overflow(result, base, &result))
+         return false;
+      exponent >>= 1;
+      if (exponent == 0)
+         break;
+      if (__builtin_mul_overflow(base, base, &base))
+         return false;
+   }
+   *r = result;
+   return true;
+}
+
+static inline int val_cmp(const value_t *a, const value_t *b) {
+   return (*a > *b) - (*a < *b);
+}
+
+static inline void val_print(FILE *out, const value_t *v) {
+   fprintf(out, "%lld", (long long) *v);
+}
+
+#else
+
+#include <limits.h>
+#include "ipow.h"
+#include "scan.h"
+
+#define VALUE_NAME "int"
+typedef int value_t;
+
+static inline void val_init(value_t *v) { *v = 0; }
+static inline void val_free(value_t *v) { (void) v; }
+static inline bool val_is_zero(const value_t *v) { return *v == 0; }
+static inline bool val_bool(value_t *r, bool b) { *r = b; return true; }
+
+static inline bool val_digits(value_t *r, const char *p, int length) {
+   *r = parse_digits(p, length);
+   return true;
+}
+
+static inline bool val_add(value_t *r, const value_t *a, const value_t *b) {
+   *r = *a + *b;
+   return true;
+}
+
+static inline bool val_sub(value_t *r, const value_t *a, const value_t *b) {
+   *r = *a - *b;
+   return true;
+}
+
+static inline bool val_mul(value_t *r, const value_t *a, const value_t *b) {
+   *r = *a * *b;
+   return true;
+}
+
+static inline bool val_div(value_t *r, const value_t *a, const value_t *b) {
+   if (*b == 0 || (*a == INT_MIN && *b == -1))
+      return false;
+   *r = *a / *b;
+   return true;
+}
+
+static inline bool val_pow(value_t *r, const value_t *a, const value_t *b) {
+   return ipow(*a, *b, r);
+}
+
+static inline int val_cmp(const value_t *a, const value_t *b) {
+   return (*a > *b) - (*a < *b);
+}
+
+static inline void val_print(FILE *out, const value_t *v) {
+   fprintf(out, "%d", *v);
+}
+
+#endif
+
+#endif
@@ -0,0 +1,95 @@
+/**
+ * writer.c - Collects output in a large buffer and writes it with one
+ * write() per batch instead of one stdio call per field.
+ *
+ * @version 05/01/2025
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include "writer.h"
+#include "stats.h"
+
+/**
+* out_init - Sets up an empty buffer that writes to fd.
+* @return false if the buffer could not be allocated
+*/
+bool out_init(struct out_buffer *out, int fd) {
+    out->data = malloc(OUT_BUFFER);
+    out->used = 0;
+    out->capacity = OUT_BUFFER;
+    out->fd = fd;
+    out->failed = (out->data == NULL);
+    return !out->failed;
+}
+
+/**
+* write_all - Writes length bytes, retrying short and interrupted writes.
+*/
+static void write_all(struct out_buffer *out, const char *bytes, size_t length) {
+    while (length > 0 && !out->failed) {
+        ssize_t wrote;
+        STATS_TIMED(PHASE_IO, wrote = write(out->fd, bytes, length));
+        if (wrote < 0) {
+            if (errno != EINTR)
+                out->failed = true;
+            continue;
+        }
+        STATS_WRITTEN(wrote);
+        bytes += wrote;
+        length -= (size_t) wrote;
+    }
+}
+
+/**
+* out_flush - Writes everything buffered so far.
+*/
+void out_flush(struct out_buffer *out) {
+    write_all(out, out->data, out->used);
+    out->used = 0;
+}
+
+/**
+* out_bytes - Appends bytes to the buffer, flushing first if they do not
+* fit. Anything larger than the whole buffer is written straight through.
+*/
+void out_bytes(struct out_buffer *out, const char *bytes, size_t length) {
+    if (out->capacity - out->used < length) {
+        out_flush(out);
+        if (length > out->capacity) {
+            write_all(out, bytes, length);
+            return;
+        }
+    }
+    memcpy(out->data + out->used, bytes, length);
+    STATS_COPIED(length);
+    out->used += length;
+}
+
+/**
+* out_int - Appends a decimal integer.
+*/
+void out_int(struct out_buffer *out, int value) {
+    char digits[12], *p = digits + sizeof(digits);
+    unsigned magnitude = value < 0 ? 0u - (unsigned) value : (unsigned) value;
+
+    do {
+        *--p = (char) ('0' + magnitude % 10);
+        magnitude /= 10;
+    } while (magnitude != 0);
+    if (value < 0)
+        *--p = '-';
+    out_bytes(out, p, (size_t) (digits + sizeof(digits) - p));
+}
+
+/**
+* out_free - Flushes the buffer and frees it.
+*/
+void out_free(struct out_buffer *out) {
+    if (out->data != NULL)
+        out_flush(out);
+    free(out->data);
+    out->data = NULL;
+}
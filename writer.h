@@ -0,0 +1,35 @@
+/**
+ * Header file for the buffered output writer
+ * @version 05/01/2025
+ */
+#ifndef WRITER_H
+#define WRITER_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#define OUT_BUFFER (256 * 1024)   /* Bytes collected before each write */
+
+/**
+ * Output collected in memory and written to a file descriptor in large
+ * batches. Each thread writing output uses its own out_buffer.
+ */
+struct out_buffer {
+    char *data;                 /* Bytes not yet written            */
+    size_t used;                /* Bytes in data                    */
+    size_t capacity;            /* Size of data                     */
+    int fd;                     /* Where the bytes go               */
+    bool failed;                /* Did a write fail?                */
+};
+
+bool out_init(struct out_buffer *out, int fd);
+
+void out_bytes(struct out_buffer *out, const char *bytes, size_t length);
+
+void out_int(struct out_buffer *out, int value);
+
+void out_flush(struct out_buffer *out);
+
+void out_free(struct out_buffer *out);
+
+#endif